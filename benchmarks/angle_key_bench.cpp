@@ -0,0 +1,46 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+
+#include <visibility/visibility.hpp>
+
+BENCHMARK("angle key: sort endpoints by angle")
+{
+    using namespace geometry;
+
+    std::printf("%10s %16s %16s\n", "segments", "comparer [us]", "keys [us]");
+    for (std::size_t count : { 1000, 10000, 50000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        auto observer = bench::make_observers(1, count, 2)[0];
+        std::vector<bench::vector_type> points;
+        for (auto&& segment : segments)
+        {
+            points.push_back(segment.a);
+            points.push_back(segment.b);
+        }
+
+        auto repeat = 1000000 / count + 1;
+        std::vector<bench::vector_type> sorted_points;
+        angle_comparer<bench::vector_type> cmp{ observer };
+        auto comparer_time = bench::measure_ns([&]()
+        {
+            sorted_points = points;
+            std::sort(sorted_points.begin(), sorted_points.end(), cmp);
+            bench::do_not_optimize(sorted_points.data());
+        }, repeat);
+
+        std::vector<std::uint64_t> keys;
+        auto key_time = bench::measure_ns([&]()
+        {
+            keys.clear();
+            for (auto&& point : points)
+                keys.push_back(angle_key(observer, point));
+            std::sort(keys.begin(), keys.end());
+            bench::do_not_optimize(keys.data());
+        }, repeat);
+
+        std::printf("%10zu %16.1f %16.1f\n", 
+            count, comparer_time / 1000, key_time / 1000);
+    }
+}
@@ -0,0 +1,98 @@
+#include "benchmark.hpp"
+
+#include <thread>
+
+#include <visibility/batch.hpp>
+
+BENCHMARK("batch: many observers against one scene")
+{
+    using namespace geometry;
+
+    std::printf("%10s %10s %14s %14s %14s %14s\n", 
+        "segments", "observers", "single [us]", "warm [us]", "batch [us]", "warm / batch");
+    for (std::size_t count : { 100, 1000, 10000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        auto observers = bench::make_observers(256, count, 2);
+
+        // independent queries which allocate their result
+        auto single_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : observers)
+            {
+                auto poly = visibility_polygon(observer, segments.begin(), segments.end());
+                bench::do_not_optimize(poly.data());
+            }
+        }, 3);
+
+        // independent queries with a shared workspace
+        visibility_workspace<bench::vector_type> workspace;
+        auto warm_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : observers)
+            {
+                auto&& poly = visibility_polygon(
+                    observer, segments.begin(), segments.end(), workspace);
+                bench::do_not_optimize(poly.data());
+            }
+        }, 3);
+
+        batch_workspace<bench::vector_type> batch;
+        packed_polygons<bench::vector_type> polygons;
+        auto batch_time = bench::measure_ns([&]()
+        {
+            polygons.clear();
+            visibility_polygons(
+                observers.begin(), observers.end(), 
+                segments.begin(), segments.end(), 
+                batch, polygons);
+            bench::do_not_optimize(polygons.vertices.data());
+        }, 3);
+
+        std::printf("%10zu %10zu %14.1f %14.1f %14.1f %14.2f\n", 
+            count, 
+            observers.size(), 
+            single_time / 1000, 
+            warm_time / 1000, 
+            batch_time / 1000,
+            warm_time / batch_time);
+    }
+}
+
+BENCHMARK("batch: parallel scaling")
+{
+    using namespace geometry;
+
+    // observers in open areas see much more than observers in corridors
+    auto segments = bench::make_grid_scene(10000, 1);
+    auto observers = bench::make_observers(1024, 10000, 2);
+    auto layers = bench::make_layers_scene(64, 16);
+    for (auto&& segment : layers)
+    {
+        segments.emplace_back(
+            segment.a * 0.1f + bench::vector_type{ 2000, 0 }, 
+            segment.b * 0.1f + bench::vector_type{ 2000, 0 });
+    }
+
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    std::printf("%8s %12s %10s\n", "threads", "time [ms]", "speedup");
+    double base_time = 0;
+    for (std::size_t threads : { 1, 2, 4, 8, 16, 32, 64 })
+    {
+        thread_pool pool{ threads };
+        batch_workspace<bench::vector_type> workspace;
+        packed_polygons<bench::vector_type> polygons;
+        auto time = bench::measure_ns([&]()
+        {
+            polygons.clear();
+            visibility_polygons(
+                observers.begin(), observers.end(), 
+                segments.begin(), segments.end(), 
+                workspace, pool, polygons);
+            bench::do_not_optimize(polygons.vertices.data());
+        }, 2);
+        if (threads == 1)
+            base_time = time;
+        std::printf("%8zu %12.1f %10.2f\n", threads, time / 1e6, base_time / time);
+    }
+}
@@ -0,0 +1,244 @@
+#ifndef BENCHMARKS_BENCHMARK_HPP_
+#define BENCHMARKS_BENCHMARK_HPP_
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <visibility/vector2.hpp>
+#include <visibility/primitives.hpp>
+
+namespace bench
+{
+    using vector_type = geometry::vec2;
+    using segment_type = geometry::line_segment<vector_type>;
+    using benchmark_function = void(*)();
+
+    // list of all registered benchmarks
+    inline std::vector<std::pair<std::string, benchmark_function>>& registry()
+    {
+        static std::vector<std::pair<std::string, benchmark_function>> items;
+        return items;
+    }
+
+    // register a benchmark in a static initializer
+    struct registration
+    {
+        registration(const char* name, benchmark_function function)
+        {
+            registry().emplace_back(name, function);
+        }
+    };
+
+    /** Number of calls of the global operator new since the program started.
+     * It is defined in main.cpp.
+     */
+    std::size_t allocation_count();
+
+    /** Measure average run time of a function.
+     * @param function to run
+     * @param repeat number of times to run the function
+     * @return average time of 1 run in nanoseconds
+     */
+    template<typename Function>
+    double measure_ns(Function&& function, std::size_t repeat)
+    {
+        using clock = std::chrono::steady_clock;
+        auto start = clock::now();
+        for (std::size_t i = 0; i < repeat; ++i)
+            function();
+        auto elapsed = std::chrono::duration<double, std::nano>(
+            clock::now() - start);
+        return elapsed.count() / repeat;
+    }
+
+    /** Prevent the compiler from removing a computation.
+     * @param value result of the computation
+     */
+    template<typename T>
+    void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /** Generate a scene with random line segments in cells of a regular grid.
+     * The scene is enclosed in a bounding box.
+     * @param count number of line segments (apart from the bounding box)
+     * @param seed of the random generator
+     * @param cell_size size of a grid cell
+     * @return line segments of the scene
+     */
+    inline std::vector<segment_type> make_grid_scene(
+        std::size_t count, 
+        unsigned seed,
+        float cell_size = 10)
+    {
+        std::mt19937 engine{ seed };
+        std::uniform_real_distribution<float> offset{ 
+            0.1f * cell_size, 0.9f * cell_size };
+
+        auto size = static_cast<std::size_t>(std::ceil(std::sqrt(count)));
+        std::vector<segment_type> segments;
+        segments.reserve(count + 4);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            vector_type corner{ 
+                (i % size) * cell_size, 
+                (i / size) * cell_size };
+            segments.emplace_back(
+                corner + vector_type{ offset(engine), offset(engine) },
+                corner + vector_type{ offset(engine), offset(engine) });
+        }
+
+        auto min = -cell_size;
+        auto max = (size + 1) * cell_size;
+        segments.emplace_back(vector_type{ min, min }, vector_type{ min, max });
+        segments.emplace_back(vector_type{ min, max }, vector_type{ max, max });
+        segments.emplace_back(vector_type{ max, max }, vector_type{ max, min });
+        segments.emplace_back(vector_type{ max, min }, vector_type{ min, min });
+        return segments;
+    }
+
+    /** Generate a scene with horizontal layers of line segments.
+     * Each layer consists of pieces which share endpoints with their 
+     * neighbours. A ray from the observer returned by layers_observer()
+     * intersects a line segment from every layer in most directions so
+     * the sweep line state has about `layers` line segments.
+     * @param layers number of layers
+     * @param pieces number of line segments in each layer
+     * @return line segments of the scene
+     */
+    inline std::vector<segment_type> make_layers_scene(
+        std::size_t layers,
+        std::size_t pieces)
+    {
+        const float width = 1000;
+        std::vector<segment_type> segments;
+        segments.reserve(layers * pieces + 4);
+        for (std::size_t i = 0; i < layers; ++i)
+        {
+            auto y = static_cast<float>(i + 1);
+            for (std::size_t j = 0; j < pieces; ++j)
+            {
+                auto x0 = -width + 2 * width * j / pieces;
+                auto x1 = -width + 2 * width * (j + 1) / pieces;
+                segments.emplace_back(vector_type{ x0, y }, vector_type{ x1, y });
+            }
+        }
+
+        auto top = static_cast<float>(layers + 1);
+        auto min = -width - 1, max = width + 1;
+        segments.emplace_back(vector_type{ min, -1 }, vector_type{ min, top });
+        segments.emplace_back(vector_type{ min, top }, vector_type{ max, top });
+        segments.emplace_back(vector_type{ max, top }, vector_type{ max, -1 });
+        segments.emplace_back(vector_type{ max, -1 }, vector_type{ min, -1 });
+        return segments;
+    }
+
+    // position of the observer in a scene from make_layers_scene()
+    inline vector_type layers_observer()
+    {
+        return vector_type{ 0.37f, 0.5f };
+    }
+
+    /** Generate an indoor map: a square grid of rooms with doors in half
+     * of the inner walls and a random line segment (furniture) in each
+     * room. Walls are split at their junctions.
+     * @param size number of rooms in each row and column
+     * @param seed of the random generator
+     * @param room_size size of a room
+     * @return line segments of the scene
+     */
+    inline std::vector<segment_type> make_rooms_scene(
+        std::size_t size,
+        unsigned seed,
+        float room_size = 10)
+    {
+        std::mt19937 engine{ seed };
+        std::uniform_real_distribution<float> offset{ 
+            0.2f * room_size, 0.8f * room_size };
+        std::bernoulli_distribution has_door{ 0.5 };
+
+        std::vector<segment_type> segments;
+        segments.reserve(2 * (size + 1) * size * 2 + size * size);
+        for (std::size_t i = 0; i <= size; ++i)
+        {
+            for (std::size_t j = 0; j < size; ++j)
+            {
+                auto u = i * room_size, v = j * room_size;
+                auto is_outer = i == 0 || i == size;
+                for (auto is_vertical : { true, false })
+                {
+                    auto point = [=](float t)
+                    {
+                        return is_vertical ? 
+                            vector_type{ u, v + t * room_size } : 
+                            vector_type{ v + t * room_size, u };
+                    };
+                    if (is_outer || !has_door(engine))
+                    {
+                        segments.emplace_back(point(0), point(1));
+                    }
+                    else
+                    {
+                        segments.emplace_back(point(0), point(0.4f));
+                        segments.emplace_back(point(0.6f), point(1));
+                    }
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < size * size; ++i)
+        {
+            vector_type corner{ 
+                (i % size) * room_size, 
+                (i / size) * room_size };
+            segments.emplace_back(
+                corner + vector_type{ offset(engine), offset(engine) },
+                corner + vector_type{ offset(engine), offset(engine) });
+        }
+        return segments;
+    }
+
+    /** Generate random observer positions in a scene from make_grid_scene().
+     * @param count number of observers
+     * @param segment_count number of line segments passed to make_grid_scene
+     * @param seed of the random generator
+     * @param cell_size size of a grid cell
+     * @return positions of the observers
+     */
+    inline std::vector<vector_type> make_observers(
+        std::size_t count,
+        std::size_t segment_count,
+        unsigned seed,
+        float cell_size = 10)
+    {
+        std::mt19937 engine{ seed };
+        auto size = static_cast<float>(
+            std::ceil(std::sqrt(segment_count)) * cell_size);
+        std::uniform_real_distribution<float> coord{ 0, size };
+
+        std::vector<vector_type> observers;
+        observers.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+            observers.emplace_back(coord(engine), coord(engine));
+        return observers;
+    }
+}
+
+#define BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_IMPL(a, b)
+
+// Register a benchmark function: BENCHMARK("name") { ... }
+#define BENCHMARK(name) \
+    static void BENCHMARK_CONCAT(benchmark_, __LINE__)(); \
+    static ::bench::registration BENCHMARK_CONCAT(registration_, __LINE__){ \
+        name, &BENCHMARK_CONCAT(benchmark_, __LINE__) }; \
+    static void BENCHMARK_CONCAT(benchmark_, __LINE__)()
+
+#endif // BENCHMARKS_BENCHMARK_HPP_
@@ -0,0 +1,192 @@
+#include "benchmark.hpp"
+
+#include <limits>
+
+#include <visibility/grid.hpp>
+#include <visibility/bvh.hpp>
+
+namespace
+{
+    /** Generate a scene with dense blocks of short line segments in an
+     * empty field (like city blocks next to fields).
+     * @param count number of line segments
+     * @param seed of the random generator
+     * @return line segments of the scene
+     */
+    std::vector<bench::segment_type> make_blocks_scene(std::size_t count, unsigned seed)
+    {
+        std::mt19937 engine{ seed };
+        std::uniform_real_distribution<float> block{ 0, 10000 };
+        std::uniform_real_distribution<float> offset{ 0, 100 };
+        std::uniform_real_distribution<float> length{ -1, 1 };
+        std::vector<bench::vector_type> corners;
+        for (std::size_t i = 0; i < 16; ++i)
+            corners.emplace_back(block(engine), block(engine));
+
+        std::vector<bench::segment_type> segments;
+        segments.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto a = corners[i % corners.size()] +
+                bench::vector_type{ offset(engine), offset(engine) };
+            segments.emplace_back(a, a + bench::vector_type{ length(engine), length(engine) });
+        }
+        return segments;
+    }
+
+    // queries around line segments of the scene
+    std::vector<bench::vector_type> make_positions(
+        const std::vector<bench::segment_type>& segments,
+        std::size_t count)
+    {
+        std::vector<bench::vector_type> positions;
+        for (std::size_t i = 0; i < count; ++i)
+            positions.push_back(segments[(i * 7919) % segments.size()].a);
+        return positions;
+    }
+
+    // run disc, wedge and ray queries with a spatial index
+    template<typename Index, typename Ray>
+    void run_queries(
+        const char* name,
+        const Index& index,
+        const std::vector<bench::vector_type>& positions,
+        Ray&& nearest_hit)
+    {
+        using namespace geometry;
+
+        std::size_t visited = 0;
+        auto disc_time = bench::measure_ns([&]()
+        {
+            for (auto&& position : positions)
+            {
+                index.visit_disc(position, 2,
+                    [&](std::uint32_t segment) { visited += segment; });
+            }
+        }, 4);
+        auto wedge_time = bench::measure_ns([&]()
+        {
+            for (std::size_t i = 0; i < positions.size(); ++i)
+            {
+                auto angle = i * 0.1;
+                vector2<double> start{ std::sin(angle), std::cos(angle) };
+                vector2<double> end{ std::sin(angle + 0.5), std::cos(angle + 0.5) };
+                index.visit_wedge(positions[i], start, end,
+                    [&](std::uint32_t segment) { visited += segment; });
+            }
+        }, 1);
+        auto ray_time = bench::measure_ns([&]()
+        {
+            for (std::size_t i = 0; i < positions.size(); ++i)
+            {
+                auto angle = i * 0.1;
+                bench::vector_type dir{
+                    static_cast<float>(std::sin(angle)),
+                    static_cast<float>(std::cos(angle)) };
+                visited += static_cast<std::size_t>(nearest_hit(positions[i], dir));
+            }
+        }, 4);
+        bench::do_not_optimize(visited);
+
+        std::printf(" %10s %12.1f %12.1f %12.1f\n",
+            name,
+            disc_time / positions.size(),
+            wedge_time / positions.size() / 1000,
+            ray_time / positions.size());
+    }
+
+    // intersect a ray with a line segment (see segment_bvh::nearest_hit())
+    double ray_distance(
+        bench::vector_type origin,
+        bench::vector_type dir,
+        const bench::segment_type& segment)
+    {
+        double ax = segment.a.x - origin.x, ay = segment.a.y - origin.y;
+        double ex = segment.b.x - segment.a.x, ey = segment.b.y - segment.a.y;
+        auto denominator = dir.x * ey - dir.y * ex;
+        auto t = (ax * ey - ay * ex) / denominator;
+        auto s = (ax * dir.y - ay * dir.x) / denominator;
+        return denominator != 0 && t >= 0 && s >= 0 && s <= 1 ?
+            t : std::numeric_limits<double>::infinity();
+    }
+}
+
+BENCHMARK("bvh: build time of the tree and the grid")
+{
+    using namespace geometry;
+
+    thread_pool pool;
+    std::printf("%10s %8s %12s %14s %12s %8s\n",
+        "segments", "scene", "grid [ms]", "bvh [ms]", "parallel [ms]", "depth");
+    for (std::size_t count : { 100000, 1000000 })
+    {
+        for (auto is_blocks : { false, true })
+        {
+            auto segments = is_blocks ?
+                make_blocks_scene(count, 1) :
+                bench::make_grid_scene(count, 1);
+
+            uniform_grid<bench::vector_type> grid;
+            auto grid_time = bench::measure_ns([&]()
+            {
+                grid = uniform_grid<bench::vector_type>{ segments };
+            }, 2);
+            segment_bvh<bench::vector_type> tree;
+            auto bvh_time = bench::measure_ns([&]()
+            {
+                tree = segment_bvh<bench::vector_type>{ segments };
+            }, 2);
+            auto parallel_time = bench::measure_ns([&]()
+            {
+                tree = segment_bvh<bench::vector_type>{ segments, pool };
+            }, 2);
+
+            std::printf("%10zu %8s %12.1f %14.1f %12.1f %8zu\n",
+                count,
+                is_blocks ? "blocks" : "uniform",
+                grid_time / 1e6,
+                bvh_time / 1e6,
+                parallel_time / 1e6,
+                tree.depth());
+        }
+    }
+    std::printf("(%zu threads)\n", pool.size());
+}
+
+BENCHMARK("bvh: queries in uniform and non-uniform scenes")
+{
+    using namespace geometry;
+
+    for (auto is_blocks : { false, true })
+    {
+        const std::size_t count = 1000000;
+        auto segments = is_blocks ?
+            make_blocks_scene(count, 1) :
+            bench::make_grid_scene(count, 1);
+        auto positions = make_positions(segments, 1000);
+        uniform_grid<bench::vector_type> grid{ segments };
+        segment_bvh<bench::vector_type> tree{ segments };
+
+        std::printf("%s scene, %zu segments\n", is_blocks ? "blocks" : "uniform", count);
+        std::printf(" %10s %12s %12s %12s\n", "index", "disc [ns]", "wedge [us]", "ray [ns]");
+        run_queries("grid", grid, positions, [&](
+            bench::vector_type origin,
+            bench::vector_type dir)
+        {
+            auto nearest = std::numeric_limits<double>::infinity();
+            grid.visit_ray(origin, vector2<double>{ dir.x, dir.y }, nearest, [&](std::uint32_t index)
+            {
+                nearest = std::min(nearest, ray_distance(origin, dir, segments[index]));
+                return nearest;
+            });
+            return nearest;
+        });
+        run_queries("bvh", tree, positions, [&](
+            bench::vector_type origin,
+            bench::vector_type dir)
+        {
+            ray_hit<bench::vector_type> hit;
+            return tree.nearest_hit(ray<bench::vector_type>{ origin, dir }, hit) ? hit.t : 0;
+        });
+    }
+}
@@ -0,0 +1,64 @@
+#include "benchmark.hpp"
+
+#include <random>
+
+#include <visibility/cache.hpp>
+
+BENCHMARK("cache: stationary and slowly moving observers")
+{
+    using namespace geometry;
+
+    std::printf("%10s %10s %14s %14s %10s %12s\n",
+        "segments", "cell", "scratch [us]", "cached [us]", "hit rate", "memory [kB]");
+    for (std::size_t count : { 1000, 10000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+
+        // 32 turrets and 32 observers which move slowly
+        auto positions = bench::make_observers(64, count, 2);
+        std::mt19937 engine{ 3 };
+        std::uniform_real_distribution<float> move{ -0.05f, 0.05f };
+        std::vector<bench::vector_type> queries;
+        for (int frame = 0; frame < 16; ++frame)
+        {
+            for (std::size_t i = 0; i < positions.size(); ++i)
+            {
+                if (i % 2 == 1)
+                    positions[i] = positions[i] + bench::vector_type{ move(engine), move(engine) };
+                queries.push_back(positions[i]);
+            }
+        }
+
+        visibility_workspace<bench::vector_type> workspace;
+        auto scratch_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : queries)
+            {
+                auto&& poly = visibility_polygon(scene, observer, workspace);
+                bench::do_not_optimize(poly.data());
+            }
+        }, 1);
+
+        for (double cell : { 0.01, 0.1, 1.0 })
+        {
+            visibility_cache<bench::vector_type> cache{ cell, 16 << 20 };
+            auto cached_time = bench::measure_ns([&]()
+            {
+                for (auto&& observer : queries)
+                {
+                    auto&& poly = visibility_polygon(cache, scene, observer, workspace);
+                    bench::do_not_optimize(poly.data());
+                }
+            }, 1);
+
+            std::printf("%10zu %10.2f %14.1f %14.1f %10.2f %12.1f\n",
+                count,
+                cell,
+                scratch_time / queries.size() / 1000,
+                cached_time / queries.size() / 1000,
+                cache.hit_rate(),
+                cache.memory() / 1024.0);
+        }
+    }
+}
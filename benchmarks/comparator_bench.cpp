@@ -0,0 +1,101 @@
+#include "benchmark.hpp"
+
+#include <visibility/visibility.hpp>
+
+namespace
+{
+    using pair_list = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+    // line_segment_dist_comparer applied to segments given by indices
+    struct segment_index_comparer
+    {
+        const bench::segment_type* segments;
+        geometry::line_segment_dist_comparer<bench::vector_type> cmp;
+
+        bool operator()(std::uint32_t x, std::uint32_t y) const
+        {
+            return cmp(segments[x], segments[y]);
+        }
+    };
+
+    // prepared segment comparer which records compared pairs
+    struct recording_comparer
+    {
+        geometry::prepared_segment_comparer cmp;
+        pair_list* pairs;
+
+        bool operator()(std::uint32_t x, std::uint32_t y) const
+        {
+            pairs->emplace_back(x, y);
+            return cmp(x, y);
+        }
+    };
+
+    // time of 1 comparison of recorded pairs in nanoseconds
+    template<typename Comparer>
+    double compare_time(const pair_list& pairs, Comparer cmp)
+    {
+        auto time = bench::measure_ns([&]()
+        {
+            std::size_t count = 0;
+            for (auto&& pair : pairs)
+                count += cmp(pair.first, pair.second);
+            bench::do_not_optimize(count);
+        }, 20);
+        return time / pairs.size();
+    }
+
+    // time of the state operations of the sweep per event in nanoseconds
+    template<typename Comparer>
+    double replay_time(const geometry::visibility_events& events, Comparer cmp)
+    {
+        geometry::btree_state<std::uint32_t, Comparer> state{ cmp };
+        auto time = bench::measure_ns([&]()
+        {
+            state.reset(cmp);
+            for (auto ref : events.refs)
+            {
+                auto index = geometry::event_segment(ref);
+                if (geometry::is_end_vertex(ref))
+                    state.erase_id(index);
+                if (!state.empty())
+                    bench::do_not_optimize(cmp(index, state.front()));
+                if (!geometry::is_end_vertex(ref))
+                    state.insert(index);
+            }
+        }, 20);
+        return time / events.size();
+    }
+}
+
+BENCHMARK("comparator: line segment vs prepared segment comparer")
+{
+    using namespace geometry;
+
+    std::printf("%8s %14s %14s %14s %14s\n",
+        "state", "segment [ns]", "prepared [ns]", "seg. sweep", "prep. sweep");
+    for (std::size_t layers : { 4, 64, 1024 })
+    {
+        auto segments = bench::make_layers_scene(layers, 32768 / layers);
+        auto observer = bench::layers_observer();
+        visibility_workspace<bench::vector_type> workspace;
+        visibility_polygon(observer, segments.begin(), segments.end(), workspace);
+
+        // collect pairs of line segments compared in the sweep
+        pair_list pairs;
+        recording_comparer recorder{
+            prepared_segment_comparer{ workspace.prepared.data() }, &pairs };
+        replay_time(workspace.events, recorder);
+
+        segment_index_comparer segment_cmp{
+            workspace.segments.data(),
+            line_segment_dist_comparer<bench::vector_type>{ observer } };
+        prepared_segment_comparer prepared_cmp{ workspace.prepared.data() };
+        std::printf("%8zu %14.2f %14.2f %14.1f %14.1f\n",
+            layers,
+            compare_time(pairs, segment_cmp),
+            compare_time(pairs, prepared_cmp),
+            replay_time(workspace.events, segment_cmp),
+            replay_time(workspace.events, prepared_cmp));
+    }
+}
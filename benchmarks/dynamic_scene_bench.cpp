@@ -0,0 +1,72 @@
+#include "benchmark.hpp"
+
+#include <random>
+
+#include <visibility/dynamic_scene.hpp>
+
+BENCHMARK("dynamic scene: edits with cached observers vs rebuilding the scene")
+{
+    using namespace geometry;
+
+    std::printf("%10s %12s %12s %14s %14s\n",
+        "segments", "edit [us]", "invalidated", "repair [us]", "rebuild [us]");
+    for (std::size_t count : { 1000, 10000, 100000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        auto observers = bench::make_observers(16, count, 2);
+
+        dynamic_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+        visibility_workspace<bench::vector_type> workspace;
+        std::vector<std::uint32_t> ids;
+        for (auto&& observer : observers)
+        {
+            ids.push_back(scene.add_observer(observer));
+            scene.polygon(ids.back(), workspace);
+        }
+
+        // open and close random doors (line segments of the scene)
+        const std::size_t edit_count = 32;
+        std::mt19937 engine{ 3 };
+        double edit_time = 0, repair_time = 0;
+        std::size_t invalidated = 0;
+        for (std::size_t i = 0; i < edit_count; ++i)
+        {
+            auto door = scene.ids()[engine() % count];
+            auto segment = scene.segment(door);
+            for (int step = 0; step < 2; ++step)
+            {
+                edit_time += bench::measure_ns([&]()
+                {
+                    if (step == 0)
+                        scene.remove_segment(door);
+                    else
+                        door = scene.insert_segment(segment);
+                }, 1);
+                invalidated += scene.invalidated().size();
+                repair_time += bench::measure_ns([&]()
+                {
+                    for (auto id : scene.invalidated())
+                        bench::do_not_optimize(scene.polygon(id, workspace).data());
+                }, 1);
+            }
+        }
+
+        // rebuild an immutable scene and recompute all polygons after an edit
+        auto rebuild_time = bench::measure_ns([&]()
+        {
+            visibility_scene<bench::vector_type> fresh{ segments.begin(), segments.end() };
+            for (auto&& observer : observers)
+            {
+                auto&& poly = visibility_polygon(fresh, observer, workspace);
+                bench::do_not_optimize(poly.data());
+            }
+        }, 2);
+
+        std::printf("%10zu %12.2f %12.2f %14.1f %14.1f\n",
+            count,
+            edit_time / (2 * edit_count) / 1000,
+            static_cast<double>(invalidated) / (2 * edit_count),
+            repair_time / (2 * edit_count) / 1000,
+            rebuild_time / 1000);
+    }
+}
@@ -0,0 +1,74 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+
+#include <visibility/visibility.hpp>
+
+BENCHMARK("event sort: comparison sort and radix sort")
+{
+    using namespace geometry;
+
+    std::printf("%10s %10s %16s %16s %16s\n", 
+        "segments", "events", "std::sort [us]", "radix [us]", "AoS radix [us]");
+    for (std::size_t count : { 256, 512, 1000, 2000, 4000, 10000, 100000, 1000000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        auto observer = bench::make_observers(1, count, 2)[0];
+
+        // compute angle keys of all events
+        visibility_workspace<bench::vector_type> workspace;
+        visibility_polygon(observer, segments.begin(), segments.end(), workspace);
+        auto events = workspace.events;
+        std::mt19937 engine{ 3 };
+        for (std::size_t i = events.size(); i > 1; --i)
+            events.swap(i - 1, std::uniform_int_distribution<std::size_t>{ 0, i - 1 }(engine));
+
+        auto repeat = 2000000 / count + 1;
+        visibility_events sorted, buffer;
+        auto comparison_time = bench::measure_ns([&]()
+        {
+            sorted = events;
+            sort_events(sorted, buffer, false);
+            bench::do_not_optimize(sorted.refs.data());
+        }, repeat);
+
+        auto radix_time = bench::measure_ns([&]()
+        {
+            sorted = events;
+            sort_events(sorted, buffer, true);
+            bench::do_not_optimize(sorted.refs.data());
+        }, repeat);
+
+        // the previous event representation: a copy of the line segment,
+        // event type and the key (32 bytes per event)
+        struct fat_event 
+        { 
+            bench::segment_type segment; 
+            int type; 
+            std::uint64_t key; 
+        };
+        std::vector<std::uint64_t> fat_keys(events.keys), fat_key_buffer;
+        std::vector<fat_event> fat_events, fat_buffer;
+        for (auto ref : events.refs)
+        {
+            fat_events.push_back(fat_event{ 
+                workspace.segments[event_segment(ref)], 
+                is_end_vertex(ref), 
+                0 });
+        }
+        auto aos_time = bench::measure_ns([&]()
+        {
+            auto keys = fat_keys;
+            auto values = fat_events;
+            radix_sort(keys, values, fat_key_buffer, fat_buffer, 32, 64);
+            bench::do_not_optimize(values.data());
+        }, repeat);
+
+        std::printf("%10zu %10zu %16.1f %16.1f %16.1f\n", 
+            count, 
+            events.size(), 
+            comparison_time / 1000, 
+            radix_time / 1000, 
+            aos_time / 1000);
+    }
+}
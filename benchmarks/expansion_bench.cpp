@@ -0,0 +1,71 @@
+#include "benchmark.hpp"
+
+#include <visibility/expansion.hpp>
+
+BENCHMARK("expansion: triangular expansion vs sweep on indoor maps")
+{
+    using namespace geometry;
+
+    std::printf("%8s %10s %10s %10s %12s %14s %10s\n",
+        "scene", "segments", "scene [ms]", "cdt [ms]",
+        "sweep [us]", "expansion [us]", "speedup");
+    for (std::size_t size : { 30, 100, 300 })
+    {
+        for (auto is_rooms : { true, false })
+        {
+            auto segments = is_rooms ?
+                bench::make_rooms_scene(size, 1) :
+                bench::make_grid_scene(size * size * 3, 1);
+
+            visibility_scene<bench::vector_type> scene;
+            auto scene_time = bench::measure_ns([&]()
+            {
+                scene = visibility_scene<bench::vector_type>{ segments.begin(), segments.end() };
+            }, 1);
+            constrained_triangulation<bench::vector_type> triangulation;
+            auto cdt_time = bench::measure_ns([&]()
+            {
+                triangulation = constrained_triangulation<bench::vector_type>{ scene };
+            }, 1);
+
+            // observers inside of the rooms or the grid of line segments
+            std::mt19937 engine{ 2 };
+            auto max = is_rooms ?
+                size * 10.f :
+                static_cast<float>(std::ceil(std::sqrt(segments.size() - 4)) * 10);
+            std::uniform_real_distribution<float> coord{ 0.1f, max - 0.1f };
+            std::vector<bench::vector_type> observers;
+            for (int i = 0; i < 64; ++i)
+                observers.emplace_back(coord(engine), coord(engine));
+
+            visibility_workspace<bench::vector_type> sweep_workspace;
+            auto sweep_time = bench::measure_ns([&]()
+            {
+                for (auto&& observer : observers)
+                {
+                    auto&& poly = visibility_polygon(scene, observer, sweep_workspace);
+                    bench::do_not_optimize(poly.data());
+                }
+            }, 1);
+
+            expansion_workspace<bench::vector_type> workspace;
+            auto expansion_time = bench::measure_ns([&]()
+            {
+                for (auto&& observer : observers)
+                {
+                    auto&& poly = visibility_polygon(triangulation, observer, workspace);
+                    bench::do_not_optimize(poly.data());
+                }
+            }, 16);
+
+            std::printf("%8s %10zu %10.1f %10.1f %12.1f %14.2f %10.1f\n",
+                is_rooms ? "rooms" : "random",
+                scene.size(),
+                scene_time / 1e6,
+                cdt_time / 1e6,
+                sweep_time / observers.size() / 1000,
+                expansion_time / observers.size() / 1000,
+                sweep_time / expansion_time);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#include "benchmark.hpp"
+
+#include <visibility/graph.hpp>
+
+namespace
+{
+    // even-odd test of a point in a polygon
+    bool contains(const std::vector<bench::vector_type>& polygon, bench::vector_type point)
+    {
+        auto result = false;
+        for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            auto a = polygon[i], b = polygon[j];
+            if ((a.y > point.y) != (b.y > point.y) &&
+                point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+            {
+                result = !result;
+            }
+        }
+        return result;
+    }
+}
+
+BENCHMARK("graph: visibility graph builder vs polygon per vertex")
+{
+    using namespace geometry;
+
+    std::printf("%8s %10s %10s %12s %12s %12s %12s %10s\n",
+        "scene", "vertices", "edges", "polygons [ms]", "graph [ms]",
+        "reflex [ms]", "4 threads [ms]", "speedup");
+    for (std::size_t size : { 5, 10, 20 })
+    {
+        for (auto is_rooms : { true, false })
+        {
+            auto segments = is_rooms ?
+                bench::make_rooms_scene(size, 1) :
+                bench::make_grid_scene(size * size * 3, 1);
+            visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+            auto&& vertices = scene.vertices();
+
+            // current approach: a visibility polygon of each vertex and a
+            // containment test of the other vertices
+            visibility_workspace<bench::vector_type> query;
+            std::size_t hits = 0;
+            auto polygons_time = bench::measure_ns([&]()
+            {
+                for (auto&& vertex : vertices)
+                {
+                    auto&& poly = visibility_polygon(scene, vertex, query);
+                    for (auto&& other : vertices)
+                        hits += contains(poly, other);
+                }
+            }, 1);
+            bench::do_not_optimize(hits);
+
+            graph_workspace<bench::vector_type> workspace;
+            visibility_graph graph, reduced;
+            auto graph_time = bench::measure_ns([&]()
+            {
+                build_visibility_graph(scene, graph_vertices::all, workspace, graph);
+            }, 1);
+            auto reflex_time = bench::measure_ns([&]()
+            {
+                build_visibility_graph(scene, graph_vertices::reflex, workspace, reduced);
+            }, 1);
+
+            thread_pool pool{ 4 };
+            auto parallel_time = bench::measure_ns([&]()
+            {
+                build_visibility_graph(scene, graph_vertices::all, workspace, pool, graph);
+            }, 1);
+
+            std::printf("%8s %10zu %10zu %12.1f %12.1f %12.1f %12.1f %10.1f\n",
+                is_rooms ? "rooms" : "random",
+                vertices.size(),
+                graph.neighbors.size() / 2,
+                polygons_time / 1e6,
+                graph_time / 1e6,
+                reflex_time / 1e6,
+                parallel_time / 1e6,
+                polygons_time / graph_time);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#include "benchmark.hpp"
+
+#include <limits>
+
+#include <visibility/grid.hpp>
+
+BENCHMARK("grid: build time and query time")
+{
+    using namespace geometry;
+
+    std::printf("%10s %12s %12s %12s %12s %12s\n",
+        "segments", "build [ms]", "box [ns]", "disc [ns]", "wedge [ns]", "ray [ns]");
+    for (std::size_t count : { 10000, 100000, 1000000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        auto observers = bench::make_observers(1000, count, 2);
+
+        uniform_grid<bench::vector_type> grid;
+        auto build_time = bench::measure_ns([&]()
+        {
+            grid = uniform_grid<bench::vector_type>{ segments };
+        }, 3);
+
+        // queries with the radius of 5 cells of the scene
+        const float radius = 50;
+        std::size_t visited = 0;
+        auto box_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : observers)
+            {
+                grid.visit_box(
+                    observer - bench::vector_type{ radius, radius },
+                    observer + bench::vector_type{ radius, radius },
+                    [&](std::uint32_t index) { visited += index; });
+            }
+        }, 4);
+        auto disc_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : observers)
+            {
+                grid.visit_disc(observer, radius,
+                    [&](std::uint32_t index) { visited += index; });
+            }
+        }, 4);
+
+        // 60 degree field of view
+        auto wedge_time = bench::measure_ns([&]()
+        {
+            for (std::size_t i = 0; i < observers.size(); ++i)
+            {
+                auto angle = i * 0.1;
+                vector2<double> start{ std::sin(angle), std::cos(angle) };
+                vector2<double> end{ std::sin(angle + 1.047), std::cos(angle + 1.047) };
+                grid.visit_wedge(observers[i], start, end,
+                    [&](std::uint32_t index) { visited += index; });
+            }
+        }, 1);
+
+        // nearest hit of a ray
+        auto ray_time = bench::measure_ns([&]()
+        {
+            for (std::size_t i = 0; i < observers.size(); ++i)
+            {
+                auto angle = i * 0.1;
+                auto origin = observers[i];
+                vector2<double> dir{ std::sin(angle), std::cos(angle) };
+                auto nearest = std::numeric_limits<double>::infinity();
+                grid.visit_ray(origin, dir, nearest, [&](std::uint32_t index)
+                {
+                    auto&& segment = segments[index];
+                    vector2<double> a{ 
+                        static_cast<double>(segment.a.x) - origin.x, 
+                        static_cast<double>(segment.a.y) - origin.y };
+                    vector2<double> edge{
+                        static_cast<double>(segment.b.x) - segment.a.x,
+                        static_cast<double>(segment.b.y) - segment.a.y };
+                    auto denominator = cross(dir, edge);
+                    auto t = cross(a, edge) / denominator;
+                    auto s = cross(a, dir) / denominator;
+                    if (denominator != 0 && t >= 0 && s >= 0 && s <= 1)
+                        nearest = std::min(nearest, t);
+                    return nearest;
+                });
+                bench::do_not_optimize(nearest);
+            }
+        }, 4);
+        bench::do_not_optimize(visited);
+
+        std::printf("%10zu %12.2f %12.1f %12.1f %12.1f %12.1f\n",
+            count,
+            build_time / 1e6,
+            box_time / observers.size(),
+            disc_time / observers.size(),
+            wedge_time / observers.size(),
+            ray_time / observers.size());
+    }
+}
@@ -0,0 +1,54 @@
+#include "benchmark.hpp"
+
+#include <visibility/kinetic.hpp>
+
+BENCHMARK("kinetic: trajectory vs dense sampling")
+{
+    using namespace geometry;
+
+    std::printf("%10s %10s %14s %14s %8s %8s %12s\n", 
+        "segments", "samples", "sampled [ms]", "kinetic [ms]", "pieces", "sweeps", "certificates");
+    for (std::size_t count : { 1000, 4000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+
+        // short walk across a few cells of the grid
+        auto start = bench::make_observers(1, count, 2)[0];
+        std::vector<bench::vector_type> path{ 
+            start, 
+            start + bench::vector_type{ 6, 2 }, 
+            start + bench::vector_type{ 9, 8 },
+        };
+
+        kinetic_visibility<bench::vector_type> kinetic;
+        auto kinetic_time = bench::measure_ns([&]()
+        {
+            kinetic = kinetic_visibility<bench::vector_type>{ 
+                scene, path.begin(), path.end() };
+        }, 1);
+
+        for (std::size_t samples : { 100, 1000 })
+        {
+            visibility_workspace<bench::vector_type> workspace;
+            auto sampled_time = bench::measure_ns([&]()
+            {
+                for (std::size_t i = 0; i < samples; ++i)
+                {
+                    auto observer = kinetic.position(kinetic.length() * i / samples);
+                    auto&& poly = visibility_polygon(scene, observer, workspace);
+                    bench::do_not_optimize(poly.data());
+                }
+            }, 1);
+
+            std::printf("%10zu %10zu %14.1f %14.1f %8zu %8zu %12zu\n", 
+                count, 
+                samples,
+                sampled_time / 1e6, 
+                kinetic_time / 1e6,
+                kinetic.size(),
+                kinetic.sweep_count(),
+                kinetic.certificate_count());
+        }
+    }
+}
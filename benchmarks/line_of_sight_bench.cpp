@@ -0,0 +1,122 @@
+#include "benchmark.hpp"
+
+#include <visibility/line_of_sight.hpp>
+
+namespace
+{
+    // even-odd test of a point in a polygon
+    bool contains(const std::vector<bench::vector_type>& polygon, bench::vector_type point)
+    {
+        auto result = false;
+        for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            auto a = polygon[i], b = polygon[j];
+            if ((a.y > point.y) != (b.y > point.y) &&
+                point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+            {
+                result = !result;
+            }
+        }
+        return result;
+    }
+}
+
+BENCHMARK("line_of_sight: point to point queries")
+{
+    using namespace geometry;
+
+    std::printf("%8s %10s %8s %12s %12s %12s %12s %14s\n",
+        "scene", "segments", "pairs", "polygon [ns]", "all [ns]",
+        "grid [ns]", "batch [ns]", "4 threads [ns]");
+    for (std::size_t size : { 30, 100, 300 })
+    {
+        for (auto is_rooms : { true, false })
+        {
+            auto segments = is_rooms ?
+                bench::make_rooms_scene(size, 1) :
+                bench::make_grid_scene(size * size * 3, 1);
+            visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+            auto max = is_rooms ?
+                size * 10.f :
+                static_cast<float>(std::ceil(std::sqrt(segments.size() - 4)) * 10);
+
+            for (auto is_short : { true, false })
+            {
+                // agents a few rooms apart or anywhere in the scene
+                std::mt19937 engine{ 2 };
+                std::uniform_real_distribution<float> coord{ 0.1f, max - 0.1f };
+                std::uniform_real_distribution<float> offset{ -20, 20 };
+                std::vector<line_segment<bench::vector_type>> pairs;
+                for (int i = 0; i < 4096; ++i)
+                {
+                    bench::vector_type a{ coord(engine), coord(engine) };
+                    auto b = is_short ?
+                        a + bench::vector_type{ offset(engine), offset(engine) } :
+                        bench::vector_type{ coord(engine), coord(engine) };
+                    pairs.push_back({ a, b });
+                }
+
+                // current approach: a visibility polygon of one point
+                visibility_workspace<bench::vector_type> workspace;
+                std::size_t polygon_count = size <= 100 ? 16 : 4;
+                std::size_t hits = 0;
+                auto polygon_time = bench::measure_ns([&]()
+                {
+                    for (std::size_t i = 0; i < polygon_count; ++i)
+                    {
+                        auto&& poly = visibility_polygon(scene, pairs[i].a, workspace);
+                        hits += contains(poly, pairs[i].b);
+                    }
+                }, 1) / polygon_count;
+
+                std::size_t all_count = size <= 100 ? 256 : 16;
+                auto all_time = bench::measure_ns([&]()
+                {
+                    auto&& lines = scene.lines();
+                    for (std::size_t i = 0; i < all_count; ++i)
+                    {
+                        auto sight_line = make_line_equation(pairs[i]);
+                        auto is_visible = true;
+                        for (std::size_t j = 0; j < scene.size() && is_visible; ++j)
+                        {
+                            is_visible = !crosses_line_of_sight(
+                                scene.segments()[j], lines[j], pairs[i], sight_line);
+                        }
+                        hits += is_visible;
+                    }
+                }, 1) / all_count;
+
+                auto grid_time = bench::measure_ns([&]()
+                {
+                    for (auto&& pair : pairs)
+                        hits += line_of_sight(scene, pair.a, pair.b);
+                }, 4) / pairs.size();
+
+                std::vector<std::uint8_t> results;
+                auto batch_time = bench::measure_ns([&]()
+                {
+                    results.clear();
+                    lines_of_sight(scene, pairs.begin(), pairs.end(), results);
+                }, 4) / pairs.size();
+
+                thread_pool pool{ 4 };
+                auto parallel_time = bench::measure_ns([&]()
+                {
+                    results.clear();
+                    lines_of_sight(scene, pairs.begin(), pairs.end(), pool, results);
+                }, 4) / pairs.size();
+                bench::do_not_optimize(hits);
+
+                std::printf("%8s %10zu %8s %12.0f %12.0f %12.0f %12.0f %14.0f\n",
+                    is_rooms ? "rooms" : "random",
+                    scene.size(),
+                    is_short ? "short" : "long",
+                    polygon_time,
+                    all_time,
+                    grid_time,
+                    batch_time,
+                    parallel_time);
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "benchmark.hpp"
+
+namespace
+{
+    std::atomic<std::size_t> allocations{ 0 };
+}
+
+std::size_t bench::allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto pointer = std::malloc(size == 0 ? 1 : size))
+        return pointer;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// Usage: benchmarks [name filter]
+int main(int argc, char** argv)
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+    for (auto&& item : bench::registry())
+    {
+        if (item.first.find(filter) == std::string::npos)
+            continue;
+        std::printf("== %s\n", item.first.c_str());
+        item.second();
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "benchmark.hpp"
+
+#include <iterator>
+
+#include <visibility/radius.hpp>
+
+BENCHMARK("radius: limited queries vs full queries")
+{
+    using namespace geometry;
+
+    std::printf("%10s %8s %12s %14s %14s\n",
+        "segments", "radius", "in disc", "full [us]", "radius [us]");
+    for (std::size_t count : { 10000, 100000, 400000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+        auto observers = bench::make_observers(16, count, 2);
+
+        visibility_workspace<bench::vector_type> workspace;
+        auto full_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : observers)
+            {
+                auto&& poly = visibility_polygon(scene, observer, workspace);
+                bench::do_not_optimize(poly.data());
+            }
+        }, 1);
+
+        std::vector<limited_vertex<bench::vector_type>> poly;
+        for (double radius : { 20.0, 100.0 })
+        {
+            std::size_t in_disc = 0;
+            auto radius_time = bench::measure_ns([&]()
+            {
+                in_disc = 0;
+                for (auto&& observer : observers)
+                {
+                    poly.clear();
+                    visibility_polygon(scene, observer, radius, 0.01, workspace,
+                        std::back_inserter(poly));
+                    bench::do_not_optimize(poly.data());
+                    in_disc += workspace.segments.size();
+                }
+            }, 4);
+
+            std::printf("%10zu %8.0f %12zu %14.1f %14.1f\n",
+                count,
+                radius,
+                in_disc / observers.size(),
+                full_time / observers.size() / 1000,
+                radius_time / observers.size() / 1000);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include "benchmark.hpp"
+
+#include <visibility/region.hpp>
+#include <visibility/scene.hpp>
+
+namespace
+{
+    // even-odd test of a point in a polygon
+    bool contains(const std::vector<bench::vector_type>& polygon, bench::vector_type point)
+    {
+        auto result = false;
+        for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            auto a = polygon[i], b = polygon[j];
+            if ((a.y > point.y) != (b.y > point.y) &&
+                point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+            {
+                result = !result;
+            }
+        }
+        return result;
+    }
+}
+
+BENCHMARK("region: containment queries on a visibility polygon")
+{
+    using namespace geometry;
+
+    std::printf("%8s %10s %10s %12s %16s %16s %14s\n",
+        "scene", "segments", "vertices", "build [ns]", "even-odd [ns]",
+        "contains [ns]", "ray hit [ns]");
+    for (std::size_t size : { 10, 30, 100 })
+    {
+        for (auto is_rooms : { true, false })
+        {
+            auto segments = is_rooms ?
+                bench::make_rooms_scene(size, 1) :
+                bench::make_grid_scene(size * size * 3, 1);
+            visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+            auto max = is_rooms ?
+                size * 10.f :
+                static_cast<float>(std::ceil(std::sqrt(segments.size() - 4)) * 10);
+
+            // the observer with the largest polygon of a few random ones
+            std::mt19937 engine{ 2 };
+            std::uniform_real_distribution<float> coord{ 0.1f, max - 0.1f };
+            visibility_workspace<bench::vector_type> workspace;
+            bench::vector_type observer;
+            std::vector<bench::vector_type> poly;
+            for (int i = 0; i < 16; ++i)
+            {
+                bench::vector_type candidate{ coord(engine), coord(engine) };
+                auto&& result = visibility_polygon(scene, candidate, workspace);
+                if (result.size() > poly.size())
+                {
+                    observer = candidate;
+                    poly = result;
+                }
+            }
+
+            // points around the observer (mostly near the polygon)
+            std::uniform_real_distribution<float> offset{ -20, 20 };
+            std::vector<bench::vector_type> points;
+            std::vector<vector2<double>> directions;
+            for (int i = 0; i < 4096; ++i)
+            {
+                points.push_back(observer + bench::vector_type{ offset(engine), offset(engine) });
+                directions.push_back(relative_position(observer, points.back()));
+            }
+
+            visibility_region<bench::vector_type> region;
+            auto build_time = bench::measure_ns([&]()
+            {
+                region.assign(observer, poly.begin(), poly.end());
+            }, 16);
+
+            std::size_t hits = 0;
+            auto polygon_time = bench::measure_ns([&]()
+            {
+                for (auto&& point : points)
+                    hits += contains(poly, point);
+            }, 1) / points.size();
+
+            auto region_time = bench::measure_ns([&]()
+            {
+                for (auto&& point : points)
+                    hits += region.contains(point);
+            }, 16) / points.size();
+
+            auto ray_time = bench::measure_ns([&]()
+            {
+                for (auto&& direction : directions)
+                    hits += region.ray_hit(direction).x > observer.x;
+            }, 16) / points.size();
+            bench::do_not_optimize(hits);
+
+            std::printf("%8s %10zu %10zu %12.0f %16.1f %16.1f %14.1f\n",
+                is_rooms ? "rooms" : "random",
+                scene.size(),
+                poly.size(),
+                build_time,
+                polygon_time,
+                region_time,
+                ray_time);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#include "benchmark.hpp"
+
+#include <visibility/scene.hpp>
+
+BENCHMARK("scene: build time and query time")
+{
+    using namespace geometry;
+
+    std::printf("%10s %12s %14s %14s\n", 
+        "segments", "build [us]", "range [us]", "scene [us]");
+    for (std::size_t count : { 1000, 10000, 100000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        auto observers = bench::make_observers(16, count, 2);
+
+        visibility_scene<bench::vector_type> scene;
+        auto build_time = bench::measure_ns([&]()
+        {
+            scene = visibility_scene<bench::vector_type>{ segments.begin(), segments.end() };
+        }, 3);
+
+        visibility_workspace<bench::vector_type> workspace;
+        auto range_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : observers)
+            {
+                auto&& poly = visibility_polygon(
+                    observer, segments.begin(), segments.end(), workspace);
+                bench::do_not_optimize(poly.data());
+            }
+        }, 2);
+        auto scene_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : observers)
+            {
+                auto&& poly = visibility_polygon(scene, observer, workspace);
+                bench::do_not_optimize(poly.data());
+            }
+        }, 2);
+
+        std::printf("%10zu %12.1f %14.1f %14.1f\n", 
+            count, 
+            build_time / 1000, 
+            range_time / observers.size() / 1000, 
+            scene_time / observers.size() / 1000);
+    }
+}
@@ -0,0 +1,248 @@
+#include "benchmark.hpp"
+
+#include <visibility/visibility.hpp>
+
+namespace
+{
+    template<template<typename, typename> class State>
+    double query_time(
+        const std::vector<bench::segment_type>& segments, 
+        bench::vector_type observer)
+    {
+        geometry::visibility_workspace<bench::vector_type, State> workspace;
+        auto repeat = 2000000 / segments.size() + 1;
+        return bench::measure_ns([&]()
+        {
+            auto&& poly = geometry::visibility_polygon(
+                observer, 
+                segments.begin(), 
+                segments.end(), 
+                workspace);
+            bench::do_not_optimize(poly.data());
+        }, repeat);
+    }
+
+    // replay state operations of the sweep over sorted events
+    template<template<typename, typename> class State>
+    double replay_time(
+        const geometry::visibility_workspace<bench::vector_type>& workspace)
+    {
+        using namespace geometry;
+        using comparer_type = prepared_segment_comparer;
+
+        auto&& events = workspace.events;
+        comparer_type cmp{ workspace.prepared.data() };
+        State<std::uint32_t, comparer_type> state{ cmp };
+        auto time = bench::measure_ns([&]()
+        {
+            state.reset(cmp);
+            for (auto ref : events.refs)
+            {
+                if (is_end_vertex(ref))
+                    state.erase_id(event_segment(ref));
+                if (!state.empty())
+                    bench::do_not_optimize(state.front());
+                if (!is_end_vertex(ref))
+                    state.insert(event_segment(ref));
+            }
+        }, 20);
+        return time / events.size();
+    }
+}
+
+BENCHMARK("sweep state: state operations by state size")
+{
+    using namespace geometry;
+
+    std::printf("%8s %8s %12s %12s %12s %12s\n", 
+        "state", "pieces", "tree [ns]", "flat [ns]", "btree [ns]", "adapt [ns]");
+    for (std::size_t layers : { 4, 16, 32, 64, 128, 256, 1024, 4096 })
+    {
+        auto pieces = 32768 / layers;
+        auto segments = bench::make_layers_scene(layers, pieces);
+        auto observer = bench::layers_observer();
+
+        // sort events
+        visibility_workspace<bench::vector_type> workspace;
+        visibility_polygon(observer, segments.begin(), segments.end(), workspace);
+
+        std::printf("%8zu %8zu %12.1f %12.1f %12.1f %12.1f\n", 
+            layers, 
+            pieces,
+            replay_time<tree_state>(workspace),
+            replay_time<flat_state>(workspace),
+            replay_time<btree_state>(workspace),
+            replay_time<adaptive_state>(workspace));
+    }
+}
+
+BENCHMARK("sweep state: query time in a grid scene")
+{
+    using namespace geometry;
+
+    std::printf("%10s %12s %12s %12s %12s\n", 
+        "segments", "tree [us]", "flat [us]", "btree [us]", "adapt [us]");
+    for (std::size_t count : { 100, 1000, 10000, 100000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        auto observer = bench::make_observers(1, count, 2)[0];
+
+        std::printf("%10zu %12.1f %12.1f %12.1f %12.1f\n", 
+            count, 
+            query_time<tree_state>(segments, observer) / 1000,
+            query_time<flat_state>(segments, observer) / 1000,
+            query_time<btree_state>(segments, observer) / 1000,
+            query_time<adaptive_state>(segments, observer) / 1000);
+    }
+}
+
+namespace
+{
+    // segment comparer which counts its calls
+    struct counting_comparer
+    {
+        geometry::prepared_segment_comparer cmp;
+        std::size_t* count;
+
+        bool operator()(std::uint32_t a, std::uint32_t b) const
+        {
+            ++*count;
+            return cmp(a, b);
+        }
+    };
+
+    // number of comparator calls in the sweep with and without handles
+    template<template<typename, typename> class State>
+    void count_comparisons(
+        const geometry::visibility_workspace<bench::vector_type>& workspace, 
+        const char* name)
+    {
+        using namespace geometry;
+
+        std::size_t count = 0;
+        counting_comparer cmp{ prepared_segment_comparer{ workspace.prepared.data() }, &count };
+        State<std::uint32_t, counting_comparer> state{ cmp };
+
+        std::size_t calls[2];
+        for (auto use_handles : { false, true })
+        {
+            count = 0;
+            state.reset(cmp);
+            for (auto ref : workspace.events.refs)
+            {
+                auto index = event_segment(ref);
+                if (is_end_vertex(ref) && use_handles)
+                    state.erase_id(index);
+                else if (is_end_vertex(ref))
+                    state.erase(index);
+                if (!state.empty())
+                    cmp(index, state.front());
+                if (!is_end_vertex(ref))
+                    state.insert(index);
+            }
+            calls[use_handles] = count;
+        }
+
+        auto events = static_cast<double>(workspace.events.size());
+        std::printf("%10s %16.2f %16.2f %10.1f%%\n", 
+            name, 
+            calls[0] / events, 
+            calls[1] / events, 
+            100.0 * (calls[0] - calls[1]) / calls[0]);
+    }
+}
+
+BENCHMARK("sweep state: comparator calls saved by erase_id")
+{
+    using namespace geometry;
+
+    for (std::size_t layers : { 16, 256, 4096 })
+    {
+        auto segments = bench::make_layers_scene(layers, 32768 / layers);
+        auto observer = bench::layers_observer();
+        visibility_workspace<bench::vector_type> workspace;
+        visibility_polygon(observer, segments.begin(), segments.end(), workspace);
+
+        std::printf("state size %zu\n", layers);
+        std::printf("%10s %16s %16s %11s\n", 
+            "state", "erase [calls]", "erase_id [calls]", "saved");
+        count_comparisons<tree_state>(workspace, "tree");
+        count_comparisons<flat_state>(workspace, "flat");
+        count_comparisons<btree_state>(workspace, "btree");
+        count_comparisons<adaptive_state>(workspace, "adaptive");
+    }
+}
+
+namespace
+{
+    // time to build the initial state in nanoseconds: insertion of values
+    // one by one and sort followed by assign_sorted()
+    template<template<typename, typename> class State>
+    std::pair<double, double> initial_state_time(
+        const geometry::visibility_workspace<bench::vector_type>& workspace)
+    {
+        using namespace geometry;
+
+        prepared_segment_comparer cmp{ workspace.prepared.data() };
+        State<std::uint32_t, prepared_segment_comparer> state{ cmp };
+        auto&& initial_state = workspace.initial_state;
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> values;
+        for (std::size_t i = 0; i < initial_state.size(); ++i)
+            values.emplace_back(initial_state.keys[i], initial_state.refs[i]);
+        std::shuffle(values.begin(), values.end(), std::mt19937{ 1 });
+        visibility_events sorted, buffer;
+        sorted.reserve(values.size());
+        buffer.reserve(values.size());
+
+        auto repeat = 200000 / values.size() + 1;
+        auto insert_time = bench::measure_ns([&]()
+        {
+            state.reset(cmp);
+            for (auto value : values)
+                state.insert(value.second);
+            bench::do_not_optimize(state.front());
+        }, repeat);
+        auto bulk_time = bench::measure_ns([&]()
+        {
+            sorted.clear();
+            for (auto value : values)
+                sorted.push_back(value.first, value.second);
+            sort_initial_state(workspace.prepared.data(), sorted, buffer);
+            state.reset(cmp);
+            state.assign_sorted(sorted.refs.begin(), sorted.refs.end());
+            bench::do_not_optimize(state.front());
+        }, repeat);
+        return { insert_time, bulk_time };
+    }
+}
+
+BENCHMARK("sweep state: initial state construction")
+{
+    using namespace geometry;
+
+    std::printf("%8s %10s %22s %22s %22s %22s\n", "state", "", 
+        "tree [us]", "flat [us]", "btree [us]", "adapt [us]");
+    std::printf("%8s %10s", "", "");
+    for (int i = 0; i < 4; ++i)
+        std::printf(" %10s %11s", "insert", "bulk");
+    std::printf("\n");
+
+    for (std::size_t layers : { 16, 128, 512, 1024, 4096, 16384 })
+    {
+        auto segments = bench::make_layers_scene(layers, 4);
+        auto observer = bench::layers_observer();
+        visibility_workspace<bench::vector_type> workspace;
+        visibility_polygon(observer, segments.begin(), segments.end(), workspace);
+
+        std::printf("%8zu %10s", workspace.initial_state.size(), "");
+        for (auto time : { 
+            initial_state_time<tree_state>(workspace),
+            initial_state_time<flat_state>(workspace),
+            initial_state_time<btree_state>(workspace),
+            initial_state_time<adaptive_state>(workspace) })
+        {
+            std::printf(" %10.1f %11.1f", time.first / 1000, time.second / 1000);
+        }
+        std::printf("\n");
+    }
+}
@@ -0,0 +1,58 @@
+#include "benchmark.hpp"
+
+#include <random>
+
+#include <visibility/tracker.hpp>
+
+BENCHMARK("tracker: moving observer vs queries from scratch")
+{
+    using namespace geometry;
+
+    std::printf("%10s %8s %14s %14s %10s %10s\n", 
+        "segments", "step", "scratch [us]", "tracker [us]", "rebuilds", "resorts");
+    for (std::size_t count : { 1000, 10000, 100000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+        auto start = bench::make_observers(1, count, 2)[0];
+
+        for (float step : { 0.01f, 0.1f, 1.f })
+        {
+            // random walk of the observer
+            std::mt19937 engine{ 3 };
+            std::uniform_real_distribution<float> move{ -step, step };
+            std::vector<bench::vector_type> path{ start };
+            for (int i = 1; i < 64; ++i)
+                path.push_back(path.back() + bench::vector_type{ move(engine), move(engine) });
+
+            visibility_workspace<bench::vector_type> workspace;
+            auto scratch_time = bench::measure_ns([&]()
+            {
+                for (auto&& observer : path)
+                {
+                    auto&& poly = visibility_polygon(scene, observer, workspace);
+                    bench::do_not_optimize(poly.data());
+                }
+            }, 2);
+
+            visibility_tracker<bench::vector_type> tracker{ scene };
+            auto tracker_time = bench::measure_ns([&]()
+            {
+                tracker.invalidate();
+                for (auto&& observer : path)
+                {
+                    auto&& poly = tracker.update(observer);
+                    bench::do_not_optimize(poly.data());
+                }
+            }, 2);
+
+            std::printf("%10zu %8.2f %14.1f %14.1f %10zu %10zu\n", 
+                count, 
+                step,
+                scratch_time / path.size() / 1000, 
+                tracker_time / path.size() / 1000,
+                tracker.rebuild_count(),
+                tracker.resort_count());
+        }
+    }
+}
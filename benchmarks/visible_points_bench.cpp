@@ -0,0 +1,101 @@
+#include "benchmark.hpp"
+
+#include <visibility/visible_points.hpp>
+#include <visibility/line_of_sight.hpp>
+
+namespace
+{
+    // even-odd test of a point in a polygon
+    bool contains(const std::vector<bench::vector_type>& polygon, bench::vector_type point)
+    {
+        auto result = false;
+        for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            auto a = polygon[i], b = polygon[j];
+            if ((a.y > point.y) != (b.y > point.y) &&
+                point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+            {
+                result = !result;
+            }
+        }
+        return result;
+    }
+}
+
+BENCHMARK("visible_points: targets in one sweep vs polygon and containment")
+{
+    using namespace geometry;
+
+    std::printf("%8s %10s %8s %14s %14s %14s %10s\n",
+        "scene", "segments", "targets", "polygon [us]", "sight [us]",
+        "sweep [us]", "speedup");
+    for (std::size_t size : { 30, 100 })
+    {
+        for (auto is_rooms : { true, false })
+        {
+            auto segments = is_rooms ?
+                bench::make_rooms_scene(size, 1) :
+                bench::make_grid_scene(size * size * 3, 1);
+            visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+            auto max = is_rooms ?
+                size * 10.f :
+                static_cast<float>(std::ceil(std::sqrt(segments.size() - 4)) * 10);
+
+            for (std::size_t count : { 64, 1024, 16384 })
+            {
+                // agents anywhere in the scene
+                std::mt19937 engine{ 2 };
+                std::uniform_real_distribution<float> coord{ 0.1f, max - 0.1f };
+                std::vector<bench::vector_type> observers;
+                for (int i = 0; i < 8; ++i)
+                    observers.emplace_back(coord(engine), coord(engine));
+                std::vector<bench::vector_type> targets;
+                for (std::size_t i = 0; i < count; ++i)
+                    targets.emplace_back(coord(engine), coord(engine));
+
+                visibility_workspace<bench::vector_type> query;
+                std::size_t hits = 0;
+                auto polygon_time = bench::measure_ns([&]()
+                {
+                    for (auto&& observer : observers)
+                    {
+                        auto&& poly = visibility_polygon(scene, observer, query);
+                        for (auto&& target : targets)
+                            hits += contains(poly, target);
+                    }
+                }, 1) / observers.size();
+
+                auto sight_time = bench::measure_ns([&]()
+                {
+                    for (auto&& observer : observers)
+                    {
+                        for (auto&& target : targets)
+                            hits += line_of_sight(scene, observer, target);
+                    }
+                }, 1) / observers.size();
+                bench::do_not_optimize(hits);
+
+                points_workspace<bench::vector_type> workspace;
+                std::vector<std::uint8_t> output;
+                auto sweep_time = bench::measure_ns([&]()
+                {
+                    for (auto&& observer : observers)
+                    {
+                        output.clear();
+                        visible_points(scene, observer, targets.begin(), targets.end(), workspace, output);
+                        bench::do_not_optimize(output.data());
+                    }
+                }, 1) / observers.size();
+
+                std::printf("%8s %10zu %8zu %14.1f %14.1f %14.1f %10.1f\n",
+                    is_rooms ? "rooms" : "random",
+                    scene.size(),
+                    count,
+                    polygon_time / 1000,
+                    sight_time / 1000,
+                    sweep_time / 1000,
+                    polygon_time / sweep_time);
+            }
+        }
+    }
+}
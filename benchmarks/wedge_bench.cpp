@@ -0,0 +1,51 @@
+#include "benchmark.hpp"
+
+#include <visibility/wedge.hpp>
+
+BENCHMARK("wedge: field of view queries vs full queries")
+{
+    using namespace geometry;
+
+    std::printf("%10s %8s %14s %14s %10s\n",
+        "segments", "fov [deg]", "full [us]", "wedge [us]", "speedup");
+    for (std::size_t count : { 10000, 100000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        visibility_scene<bench::vector_type> scene{ segments.begin(), segments.end() };
+        auto observers = bench::make_observers(16, count, 2);
+
+        visibility_workspace<bench::vector_type> workspace;
+        auto full_time = bench::measure_ns([&]()
+        {
+            for (auto&& observer : observers)
+            {
+                auto&& poly = visibility_polygon(scene, observer, workspace);
+                bench::do_not_optimize(poly.data());
+            }
+        }, 2);
+
+        for (double fov : { 30.0, 90.0, 180.0 })
+        {
+            auto half_angle = fov / 2 * 3.14159265358979323846 / 180;
+            auto wedge_time = bench::measure_ns([&]()
+            {
+                for (std::size_t i = 0; i < observers.size(); ++i)
+                {
+                    bench::vector_type direction{
+                        static_cast<float>(i % 4) - 1.5f,
+                        static_cast<float>(i % 3) - 0.5f };
+                    auto&& poly = visibility_wedge(
+                        scene, observers[i], direction, half_angle, workspace);
+                    bench::do_not_optimize(poly.data());
+                }
+            }, 2);
+
+            std::printf("%10zu %8.0f %14.1f %14.1f %10.2f\n",
+                count,
+                fov,
+                full_time / observers.size() / 1000,
+                wedge_time / observers.size() / 1000,
+                full_time / wedge_time);
+        }
+    }
+}
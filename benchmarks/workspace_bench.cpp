@@ -0,0 +1,52 @@
+#include "benchmark.hpp"
+
+#include <visibility/visibility.hpp>
+
+BENCHMARK("workspace: allocations per query")
+{
+    using namespace geometry;
+
+    std::printf("%10s %14s %14s %14s %14s\n", 
+        "segments", "fresh [ns]", "fresh [alloc]", "warm [ns]", "warm [alloc]");
+    for (std::size_t count : { 100, 1000, 10000 })
+    {
+        auto segments = bench::make_grid_scene(count, 1);
+        auto observers = bench::make_observers(64, count, 2);
+        auto repeat = 200000 / count + 1;
+
+        std::size_t index = 0;
+        auto allocs_before = bench::allocation_count();
+        auto fresh_time = bench::measure_ns([&]() 
+        {
+            auto poly = visibility_polygon(
+                observers[index++ % observers.size()], 
+                segments.begin(), 
+                segments.end());
+            bench::do_not_optimize(poly.data());
+        }, repeat);
+        auto fresh_allocs = bench::allocation_count() - allocs_before;
+
+        // warm up the workspace
+        visibility_workspace<bench::vector_type> workspace;
+        for (auto&& observer : observers)
+            visibility_polygon(observer, segments.begin(), segments.end(), workspace);
+
+        index = 0;
+        allocs_before = bench::allocation_count();
+        auto warm_time = bench::measure_ns([&]() 
+        {
+            auto&& poly = visibility_polygon(
+                observers[index++ % observers.size()], 
+                segments.begin(), 
+                segments.end(),
+                workspace);
+            bench::do_not_optimize(poly.data());
+        }, repeat);
+        auto warm_allocs = bench::allocation_count() - allocs_before;
+
+        std::printf("%10zu %14.0f %14.2f %14.0f %14.2f\n", 
+            count, 
+            fresh_time, static_cast<double>(fresh_allocs) / repeat,
+            warm_time, static_cast<double>(warm_allocs) / repeat);
+    }
+}
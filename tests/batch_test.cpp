@@ -0,0 +1,126 @@
+#include "catch.hpp"
+
+#include <random>
+#include <vector>
+
+#include <visibility/batch.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+TEST_CASE("Batch of visibility polygons with no observers", "[batch]")
+{
+    using namespace geometry;
+
+    std::vector<vector_type> observers;
+    std::vector<segment_type> segments{
+        { { -1, -1 }, { -1, 1 } },
+        { { -1, 1 }, { 1, 1 } },
+    };
+    auto polygons = visibility_polygons(
+        observers.begin(), observers.end(), segments.begin(), segments.end());
+    REQUIRE(polygons.size() == 0);
+    REQUIRE(polygons.vertices.empty());
+}
+
+TEST_CASE("Batch of visibility polygons gives the same polygons as single queries", "[batch]")
+{
+    using namespace geometry;
+
+    std::mt19937 engine{ 3 };
+    std::uniform_real_distribution<float> offset{ 1, 9 };
+    std::uniform_real_distribution<float> coord{ 0, 100 };
+    std::vector<segment_type> segments{
+        { { -10, -10 },{ -10, 110 } },
+        { { -10, 110 },{ 110, 110 } },
+        { { 110, 110 },{ 110, -10 } },
+        { { 110, -10 },{ -10, -10 } },
+    };
+    for (int i = 0; i < 10; ++i)
+    {
+        for (int j = 0; j < 10; ++j)
+        {
+            vector_type corner{ i * 10.f, j * 10.f };
+            segments.emplace_back(
+                corner + vector_type{ offset(engine), offset(engine) },
+                corner + vector_type{ offset(engine), offset(engine) });
+        }
+    }
+
+    std::vector<vector_type> observers;
+    for (int i = 0; i < 50; ++i)
+        observers.emplace_back(coord(engine), coord(engine));
+
+    batch_workspace<vector_type> workspace;
+    packed_polygons<vector_type> polygons;
+    for (int run = 0; run < 2; ++run)
+    {
+        polygons.clear();
+        visibility_polygons(
+            observers.begin(), observers.end(), 
+            segments.begin(), segments.end(), 
+            workspace, polygons);
+
+        REQUIRE(polygons.size() == observers.size());
+        REQUIRE(polygons.offsets.back() == polygons.vertices.size());
+        for (std::size_t i = 0; i < observers.size(); ++i)
+        {
+            auto expected = visibility_polygon(observers[i], segments.begin(), segments.end());
+            REQUIRE(polygons.polygon_size(i) == expected.size());
+
+            auto it = polygons.polygon_begin(i);
+            for (auto&& vertex : expected)
+                REQUIRE(approx_equal(*it++, vertex));
+            REQUIRE(it == polygons.polygon_end(i));
+        }
+    }
+}
+
+TEST_CASE("Parallel batch gives the same polygons as a single threaded batch", "[batch]")
+{
+    using namespace geometry;
+
+    std::mt19937 engine{ 4 };
+    std::uniform_real_distribution<float> offset{ 1, 9 };
+    std::uniform_real_distribution<float> coord{ 0, 200 };
+    std::vector<segment_type> segments{
+        { { -10, -10 },{ -10, 210 } },
+        { { -10, 210 },{ 210, 210 } },
+        { { 210, 210 },{ 210, -10 } },
+        { { 210, -10 },{ -10, -10 } },
+    };
+    for (int i = 0; i < 20; ++i)
+    {
+        for (int j = 0; j < 20; ++j)
+        {
+            vector_type corner{ i * 10.f, j * 10.f };
+            segments.emplace_back(
+                corner + vector_type{ offset(engine), offset(engine) },
+                corner + vector_type{ offset(engine), offset(engine) });
+        }
+    }
+
+    std::vector<vector_type> observers;
+    for (int i = 0; i < 200; ++i)
+        observers.emplace_back(coord(engine), coord(engine));
+
+    auto expected = visibility_polygons(
+        observers.begin(), observers.end(), segments.begin(), segments.end());
+
+    thread_pool pool{ 4 };
+    batch_workspace<vector_type> workspace;
+    packed_polygons<vector_type> polygons;
+    for (int run = 0; run < 2; ++run)
+    {
+        polygons.clear();
+        visibility_polygons(
+            observers.begin(), observers.end(), 
+            segments.begin(), segments.end(), 
+            workspace, pool, polygons);
+
+        REQUIRE(polygons.offsets == expected.offsets);
+        REQUIRE(polygons.vertices.size() == expected.vertices.size());
+        for (std::size_t i = 0; i < polygons.vertices.size(); ++i)
+            REQUIRE(polygons.vertices[i] == expected.vertices[i]);
+    }
+}
@@ -0,0 +1,206 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/bvh.hpp>
+#include <visibility/radius.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+using dvec = tests::dvec;
+
+namespace
+{
+    const double pi = 3.14159265358979323846;
+
+    // a dense cluster of short line segments in a sparse field
+    std::vector<segment_type> make_segments(unsigned seed, int count)
+    {
+        std::mt19937 engine{ seed };
+        std::uniform_real_distribution<float> field{ 0, 1000 };
+        std::uniform_real_distribution<float> cluster{ 100, 120 };
+        std::uniform_real_distribution<float> offset{ -2, 2 };
+        std::vector<segment_type> segments;
+        for (int i = 0; i < count; ++i)
+        {
+            auto is_dense = i % 10 != 0;
+            vector_type a{
+                is_dense ? cluster(engine) : field(engine),
+                is_dense ? cluster(engine) : field(engine) };
+            segments.emplace_back(a, a + vector_type{ offset(engine), offset(engine) });
+        }
+
+        // duplicate and degenerate line segments
+        segments.push_back(segments[0]);
+        segments.emplace_back(vector_type{ 50, 50 }, vector_type{ 50, 50 });
+        return segments;
+    }
+}
+
+TEST_CASE("BVH reports line segments in a box, a disc and a wedge", "[bvh]")
+{
+    using namespace geometry;
+
+    auto segments = make_segments(1, 2000);
+    segment_bvh<vector_type> tree{ segments };
+    REQUIRE(tree.size() == segments.size());
+    REQUIRE(tree.depth() > 1);
+    REQUIRE(tree.depth() < 64);
+
+    std::mt19937 engine{ 2 };
+    std::uniform_real_distribution<float> coord{ -100, 1100 };
+    std::uniform_real_distribution<float> near_cluster{ 90, 130 };
+    std::uniform_real_distribution<double> radius{ 0, 50 };
+    std::uniform_real_distribution<double> angle{ 0, 2 * pi };
+    for (int i = 0; i < 100; ++i)
+    {
+        auto is_near = i % 2 == 0;
+        vector_type center{
+            is_near ? near_cluster(engine) : coord(engine),
+            is_near ? near_cluster(engine) : coord(engine) };
+        auto r = radius(engine);
+        auto axis = angle(engine), half = angle(engine) / 2;
+        dvec start{ std::sin(axis - half), std::cos(axis - half) };
+        dvec end{ std::sin(axis + half), std::cos(axis + half) };
+        auto min = center - vector_type{ 10, 10 }, max = center + vector_type{ 20, 5 };
+
+        std::vector<int> box(segments.size(), 0);
+        std::vector<int> disc(segments.size(), 0);
+        std::vector<int> wedge(segments.size(), 0);
+        tree.visit_box(min, max, [&](std::uint32_t index) { ++box[index]; });
+        tree.visit_disc(center, r, [&](std::uint32_t index) { ++disc[index]; });
+        tree.visit_wedge(center, start, end, [&](std::uint32_t index) { ++wedge[index]; });
+
+        auto apex = tests::to_double(center);
+        for (std::size_t j = 0; j < segments.size(); ++j)
+        {
+            auto&& segment = segments[j];
+            REQUIRE(box[j] <= 1);
+            REQUIRE(disc[j] <= 1);
+            REQUIRE(wedge[j] <= 1);
+
+            auto in_box =
+                std::max(segment.a.x, segment.b.x) >= min.x &&
+                std::min(segment.a.x, segment.b.x) <= max.x &&
+                std::max(segment.a.y, segment.b.y) >= min.y &&
+                std::min(segment.a.y, segment.b.y) <= max.y;
+            REQUIRE(box[j] == (in_box ? 1 : 0));
+
+            auto d = tests::distance(apex, segment);
+            if (d <= r * 0.999)
+                REQUIRE(disc[j] == 1);
+            if (d >= r * 1.001)
+                REQUIRE(disc[j] == 0);
+
+            auto in_wedge =
+                tests::wedge_contains(apex, start, end, tests::to_double(segment.a)) ||
+                tests::wedge_contains(apex, start, end, tests::to_double(segment.b)) ||
+                std::isfinite(tests::ray_distance(apex, start, segment)) ||
+                std::isfinite(tests::ray_distance(apex, end, segment));
+            if (in_wedge)
+                REQUIRE(wedge[j] == 1);
+        }
+    }
+}
+
+TEST_CASE("BVH finds the nearest hit of a ray", "[bvh]")
+{
+    using namespace geometry;
+
+    auto segments = make_segments(3, 2000);
+    segment_bvh<vector_type> tree{ segments };
+
+    std::mt19937 engine{ 4 };
+    std::uniform_real_distribution<float> coord{ -100, 1100 };
+    std::uniform_real_distribution<double> angle{ 0, 2 * pi };
+    for (int i = 0; i < 500; ++i)
+    {
+        vector_type origin{ coord(engine), coord(engine) };
+        auto direction = angle(engine);
+        vector_type dir{
+            static_cast<float>(std::sin(direction)),
+            static_cast<float>(std::cos(direction)) };
+        if (i % 10 == 0)
+            dir = vector_type{ static_cast<float>(i % 20 == 0), static_cast<float>(i % 20 != 0) };
+
+        auto nearest = std::numeric_limits<double>::infinity();
+        for (auto&& segment : segments)
+            nearest = std::min(nearest, tests::ray_distance(tests::to_double(origin), tests::to_double(dir), segment));
+
+        ray_hit<vector_type> hit;
+        auto found = tree.nearest_hit(ray<vector_type>{ origin, dir }, hit);
+        REQUIRE(found == std::isfinite(nearest));
+        if (found)
+        {
+            REQUIRE(hit.t == Approx(nearest));
+            REQUIRE(tests::ray_distance(tests::to_double(origin), tests::to_double(dir), segments[hit.segment]) ==
+                Approx(nearest));
+            REQUIRE(hit.point.x == Approx(origin.x + dir.x * hit.t).margin(1e-3));
+            REQUIRE(hit.point.y == Approx(origin.y + dir.y * hit.t).margin(1e-3));
+        }
+
+        // limited ray
+        ray_hit<vector_type> limited;
+        REQUIRE(tree.nearest_hit(ray<vector_type>{ origin, dir }, limited, 10) ==
+            (nearest <= 10));
+    }
+}
+
+TEST_CASE("Parallel BVH build gives the same tree", "[bvh]")
+{
+    using namespace geometry;
+
+    auto segments = make_segments(5, 50000);
+    segment_bvh<vector_type> serial{ segments };
+    thread_pool pool{ 4 };
+    segment_bvh<vector_type> parallel{ segments, pool };
+
+    REQUIRE(serial.depth() == parallel.depth());
+    REQUIRE(serial.nodes().size() == parallel.nodes().size());
+
+    // compare the trees by traversing them in the same order
+    std::vector<std::uint32_t> serial_order, parallel_order;
+    vector_type min{ 0, 0 }, max{ 1000, 1000 };
+    serial.visit_box(min, max, [&](std::uint32_t index) { serial_order.push_back(index); });
+    parallel.visit_box(min, max, [&](std::uint32_t index) { parallel_order.push_back(index); });
+    REQUIRE(serial_order == parallel_order);
+
+    segment_bvh<vector_type> empty{ std::vector<segment_type>{}, pool };
+    REQUIRE(empty.size() == 0);
+    ray_hit<vector_type> hit;
+    REQUIRE_FALSE(empty.nearest_hit(ray<vector_type>{ min, max }, hit));
+}
+
+TEST_CASE("Radius query with a BVH gives the same polygon as with the grid", "[bvh]")
+{
+    using namespace geometry;
+
+    auto segments = make_segments(6, 5000);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    segment_bvh<vector_type> tree{ scene.segments() };
+    visibility_workspace<vector_type> workspace;
+
+    std::mt19937 engine{ 7 };
+    std::uniform_real_distribution<float> coord{ 90, 130 };
+    for (int i = 0; i < 50; ++i)
+    {
+        vector_type observer{ coord(engine), coord(engine) };
+        std::vector<limited_vertex<vector_type>> expected, actual;
+        visibility_polygon(scene, observer, 5, 0.01, workspace, std::back_inserter(expected));
+        visit_visibility_polygon(scene, tree, observer, 5, 0.01, workspace,
+            [&actual](const limited_vertex<vector_type>& vertex) { actual.push_back(vertex); });
+
+        REQUIRE(actual.size() == expected.size());
+        for (std::size_t j = 0; j < actual.size(); ++j)
+        {
+            REQUIRE(actual[j].point == expected[j].point);
+            REQUIRE(actual[j].is_arc == expected[j].is_arc);
+        }
+    }
+}
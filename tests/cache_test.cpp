@@ -0,0 +1,149 @@
+#include "catch.hpp"
+
+#include <limits>
+#include <vector>
+
+#include <visibility/cache.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+namespace
+{
+    // box with a pillar in the middle
+    std::vector<segment_type> make_room()
+    {
+        return std::vector<segment_type>{
+            { { 0, 0 }, { 0, 10 } },
+            { { 0, 10 }, { 10, 10 } },
+            { { 10, 10 }, { 10, 0 } },
+            { { 10, 0 }, { 0, 0 } },
+            { { 4, 5 }, { 6, 5 } },
+        };
+    }
+}
+
+TEST_CASE("Cache returns polygons of observers in the same cell", "[cache]")
+{
+    using namespace geometry;
+
+    auto segments = make_room();
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+    visibility_cache<vector_type> cache{ 0.5, 1 << 20 };
+
+    std::vector<vector_type> first = visibility_polygon(
+        cache, scene, vector_type{ 5.1f, 2.1f }, workspace);
+    REQUIRE(first == visibility_polygon(scene, vector_type{ 5.1f, 2.1f }, workspace));
+    REQUIRE(cache.miss_count() == 1);
+    REQUIRE(cache.hit_count() == 0);
+
+    // the same cell gives the cached polygon
+    auto&& second = visibility_polygon(cache, scene, vector_type{ 5.3f, 2.4f }, workspace);
+    REQUIRE(second == first);
+    REQUIRE(cache.hit_count() == 1);
+
+    // another cell computes a new polygon
+    auto&& third = visibility_polygon(cache, scene, vector_type{ 5.6f, 2.1f }, workspace);
+    REQUIRE(third == visibility_polygon(scene, vector_type{ 5.6f, 2.1f }, workspace));
+    REQUIRE(cache.miss_count() == 2);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.hit_rate() == Approx(1 / 3.0));
+
+    cache.reset_counters();
+    REQUIRE(cache.hit_rate() == 0);
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.memory() == 0);
+}
+
+TEST_CASE("Cache evicts the least recently used polygons", "[cache]")
+{
+    using namespace geometry;
+
+    auto segments = make_room();
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+
+    // find the memory of 1 entry
+    visibility_cache<vector_type> probe{ 1, 1 << 20 };
+    visibility_polygon(probe, scene, vector_type{ 1.5f, 1.5f }, workspace);
+    auto entry_memory = probe.memory();
+
+    // there is enough memory for 2 polygons with the same number of vertices
+    visibility_cache<vector_type> cache{ 1, 2 * entry_memory + entry_memory / 2 };
+    vector_type a{ 1.5f, 1.5f }, b{ 8.5f, 1.5f }, c{ 1.5f, 2.5f };
+    visibility_polygon(cache, scene, a, workspace);
+    visibility_polygon(cache, scene, b, workspace);
+    visibility_polygon(cache, scene, a, workspace); // b is the least recently used
+    visibility_polygon(cache, scene, c, workspace);
+    REQUIRE(cache.eviction_count() == 1);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.memory() <= cache.max_memory());
+
+    visibility_polygon(cache, scene, a, workspace);
+    REQUIRE(cache.hit_count() == 2);
+    visibility_polygon(cache, scene, b, workspace);
+    REQUIRE(cache.miss_count() == 4);
+}
+
+TEST_CASE("Cache does not return polygons of an older version of a scene", "[cache]")
+{
+    using namespace geometry;
+
+    auto segments = make_room();
+    dynamic_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+    visibility_cache<vector_type> cache{ 1, 1 << 20 };
+
+    vector_type observer{ 5, 2 };
+    std::vector<vector_type> before = visibility_polygon(cache, scene, observer, workspace);
+    scene.insert_segment(segment_type{ { 2, 3 }, { 8, 3 } });
+    auto&& after = visibility_polygon(cache, scene, observer, workspace);
+    REQUIRE(after != before);
+    REQUIRE(after == visibility_polygon(scene, observer, workspace));
+    REQUIRE(cache.miss_count() == 2);
+}
+
+TEST_CASE("Cache clamps cells of positions far from the origin", "[cache]")
+{
+    using namespace geometry;
+
+    // quotients of the positions are out of the range of cell indices
+    visibility_cache<vector_type> cache{ 1e-30, 1 << 20 };
+    std::vector<vector_type> polygon{ { 0, 0 }, { 1, 0 }, { 0, 1 } };
+    auto query = [&](vector_type) -> const std::vector<vector_type>& { return polygon; };
+
+    REQUIRE(cache.find(vector_type{ 1e30f, -1e30f }, 0, query) == polygon);
+    REQUIRE(cache.find(vector_type{ 2e30f, -3e30f }, 0, query) == polygon);
+    REQUIRE(cache.find(vector_type{ -1e30f, -1e30f }, 0, query) == polygon);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.miss_count() == 2);
+    REQUIRE(cache.hit_count() == 1);
+}
+
+TEST_CASE("Cache does not store polygons of non-finite positions", "[cache]")
+{
+    using namespace geometry;
+
+    visibility_cache<vector_type> cache{ 0.5, 1 << 20 };
+    std::vector<vector_type> polygon{ { 0, 0 }, { 1, 0 }, { 0, 1 } };
+    auto query = [&](vector_type) -> const std::vector<vector_type>& { return polygon; };
+
+    auto nan = std::numeric_limits<float>::quiet_NaN();
+    auto inf = std::numeric_limits<float>::infinity();
+    std::vector<vector_type> positions{
+        { nan, nan }, { nan, nan }, { nan, 1 }, { -inf, -inf },
+    };
+    for (auto&& position : positions)
+        REQUIRE(cache.find(position, 0, query) == polygon);
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.memory() == 0);
+    REQUIRE(cache.miss_count() == 4);
+    REQUIRE(cache.hit_count() == 0);
+
+    // the lowest cell is not shared with the non-finite positions
+    REQUIRE(cache.find(vector_type{ -1e30f, -1e30f }, 0, query) == polygon);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.miss_count() == 5);
+}
@@ -0,0 +1,184 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/dynamic_scene.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+TEST_CASE("Dynamic scene keeps ids of line segments and welds endpoints", "[dynamic_scene]")
+{
+    using namespace geometry;
+
+    dynamic_scene<vector_type> scene{ vector_type{ 0, 0 }, vector_type{ 10, 10 }, 4 };
+    auto first = scene.insert_segment(segment_type{ { 0, 0 }, { 10, 0 } });
+    auto second = scene.insert_segment(segment_type{ { 10, 0 }, { 10, 10 } });
+    auto third = scene.insert_segment(segment_type{ { 10.000001f, 10 }, { 0, 0 } });
+    REQUIRE(scene.size() == 3);
+    REQUIRE(scene.segment(third).a == vector_type(10, 10));
+    REQUIRE(scene.insert_segment(segment_type{ { 5, 5 }, { 5, 5 } }) == no_segment);
+
+    REQUIRE(scene.remove_segment(first));
+    REQUIRE_FALSE(scene.remove_segment(first));
+    REQUIRE_FALSE(scene.contains(first));
+    REQUIRE(scene.size() == 2);
+    REQUIRE(scene.segment(second).a == vector_type(10, 0));
+    REQUIRE(scene.segment(third).a == vector_type(10, 10));
+    for (std::size_t i = 0; i < scene.size(); ++i)
+        REQUIRE(&scene.segments()[i] == &scene.segment(scene.ids()[i]));
+    REQUIRE(scene.version() == 4);
+}
+
+TEST_CASE("Dynamic scene welds an endpoint to the nearest approximately equal endpoint", "[dynamic_scene]")
+{
+    using namespace geometry;
+
+    // both endpoints are 1 ulp away from the new point in each coordinate
+    // but they are not approximately equal to each other
+    auto x1 = std::nextafter(10.f, 11.f);
+    auto x2 = std::nextafter(x1, 11.f);
+    auto y1 = std::nextafter(10.f, 11.f);
+    vector_type near{ x2, y1 };
+    vector_type far{ 10, 10 };
+    vector_type point{ x1, y1 };
+    REQUIRE(approx_equal(near, point));
+    REQUIRE(approx_equal(far, point));
+    REQUIRE_FALSE(approx_equal(near, far));
+
+    dynamic_scene<vector_type> scene{ vector_type{ 0, 0 }, vector_type{ 20, 20 }, 4 };
+    scene.insert_segment(segment_type{ near, { 20, 0 } });
+    scene.insert_segment(segment_type{ far, { 0, 20 } });
+    auto id = scene.insert_segment(segment_type{ point, { 0, 0 } });
+    REQUIRE(scene.segment(id).a == near);
+}
+
+TEST_CASE("Dynamic scene welds endpoints in adjacent cells and grows its grid", "[dynamic_scene]")
+{
+    using namespace geometry;
+
+    // cells of size 2, the endpoints are on both sides of the boundary
+    // x = 2 of a cell
+    dynamic_scene<vector_type> scene{ vector_type{ 0, 0 }, vector_type{ 10, 10 }, 50 };
+    REQUIRE(scene.grid().cell_size() == Approx(2));
+    scene.insert_segment(segment_type{ { 2, 5 }, { 4, 5 } });
+    auto id = scene.insert_segment(segment_type{ { 0, 5 }, { std::nextafter(2.f, 0.f), 5 } });
+    REQUIRE(scene.segment(id).b == vector_type(2, 5));
+
+    // a scene without an initial size
+    dynamic_scene<vector_type> grown;
+    auto segments = tests::make_scene(14, 20);
+    for (auto&& segment : segments)
+        grown.insert_segment(segment);
+    REQUIRE(grown.size() == segments.size());
+    REQUIRE(grown.grid().columns() * grown.grid().rows() >= segments.size() / 8);
+    for (std::size_t i = 0; i < grown.size(); ++i)
+    {
+        std::size_t count = 0;
+        grown.grid().visit_box(grown.segments()[i].a, grown.segments()[i].a, [&](std::uint32_t id)
+        {
+            count += id == grown.ids()[i];
+        });
+        REQUIRE(count == 1);
+    }
+}
+
+TEST_CASE("Edits of a dynamic scene invalidate only observers which they affect", "[dynamic_scene]")
+{
+    using namespace geometry;
+
+    // two rooms connected by a door
+    std::vector<segment_type> segments{
+        { { 0, 0 }, { 0, 10 } },
+        { { 0, 10 }, { 20, 10 } },
+        { { 20, 10 }, { 20, 0 } },
+        { { 20, 0 }, { 0, 0 } },
+        { { 10, 0 }, { 10, 4 } },
+        { { 10, 6 }, { 10, 10 } },
+    };
+    dynamic_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+
+    auto left = scene.add_observer(vector_type{ 2, 5 });
+    auto right = scene.add_observer(vector_type{ 15, 8 });
+    scene.polygon(left, workspace);
+    scene.polygon(right, workspace);
+    REQUIRE(scene.is_valid(left));
+    REQUIRE(scene.is_valid(right));
+
+    // a box in the corner of the left room which the right observer can't see
+    auto box = scene.insert_segment(segment_type{ { 1, 9 }, { 2, 9 } });
+    REQUIRE((scene.invalidated() == std::vector<std::uint32_t>{ left }));
+    REQUIRE_FALSE(scene.is_valid(left));
+    REQUIRE(scene.is_valid(right));
+    scene.polygon(left, workspace);
+
+    // close the door
+    auto door = scene.insert_segment(segment_type{ { 10, 4 }, { 10, 6 } });
+    REQUIRE(scene.invalidated().size() == 2);
+    scene.polygon(left, workspace);
+    scene.polygon(right, workspace);
+
+    // the box is hidden from the right observer
+    REQUIRE(scene.remove_segment(box));
+    REQUIRE((scene.invalidated() == std::vector<std::uint32_t>{ left }));
+    scene.polygon(left, workspace);
+
+    // open the door
+    REQUIRE(scene.remove_segment(door));
+    REQUIRE(scene.invalidated().size() == 2);
+    auto&& poly = scene.polygon(right, workspace);
+    REQUIRE(poly == visibility_polygon(scene, vector_type{ 15, 8 }, workspace));
+}
+
+TEST_CASE("Cached polygons of a dynamic scene are equal to queries from scratch", "[dynamic_scene]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(3, 8);
+    dynamic_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+
+    std::mt19937 engine{ 4 };
+    std::uniform_real_distribution<float> coord{ -5, 85 };
+    std::uniform_real_distribution<float> offset{ -4, 4 };
+    std::vector<vector_type> positions;
+    std::vector<std::uint32_t> observers;
+    for (int i = 0; i < 16; ++i)
+    {
+        positions.push_back(vector_type{ coord(engine), coord(engine) });
+        observers.push_back(scene.add_observer(positions.back()));
+    }
+
+    std::size_t invalidated = 0;
+    for (int edit = 0; edit < 100; ++edit)
+    {
+        if (edit % 3 == 2)
+        {
+            auto id = scene.ids()[engine() % scene.size()];
+            REQUIRE(scene.remove_segment(id));
+        }
+        else
+        {
+            vector_type a{ coord(engine), coord(engine) };
+            auto id = scene.insert_segment(
+                segment_type{ a, a + vector_type{ offset(engine), offset(engine) } });
+            REQUIRE(scene.contains(id));
+        }
+        invalidated += scene.invalidated().size();
+
+        for (std::size_t i = 0; i < observers.size(); ++i)
+        {
+            std::vector<vector_type> cached = scene.polygon(observers[i], workspace);
+            REQUIRE(cached == visibility_polygon(scene, positions[i], workspace));
+        }
+    }
+
+    // some cached polygons survive edits
+    REQUIRE(invalidated < 100 * observers.size());
+}
@@ -0,0 +1,92 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/expansion.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+namespace
+{
+    const double pi = 3.14159265358979323846;
+
+    // twice the signed area of a polygon (negative for clockwise polygons)
+    double signed_area(const std::vector<vector_type>& polygon)
+    {
+        double result = 0;
+        for (std::size_t i = 0; i < polygon.size(); ++i)
+        {
+            auto a = polygon[i], b = polygon[(i + 1) % polygon.size()];
+            result += static_cast<double>(a.x) * b.y - static_cast<double>(a.y) * b.x;
+        }
+        return result;
+    }
+
+    // compare triangular expansion with the sweep from random observers
+    void check_scene(
+        const std::vector<segment_type>& segments,
+        float min,
+        float max,
+        unsigned seed)
+    {
+        using namespace geometry;
+
+        visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+        constrained_triangulation<vector_type> triangulation{ scene };
+        visibility_workspace<vector_type> sweep_workspace;
+        expansion_workspace<vector_type> workspace;
+
+        std::mt19937 engine{ seed };
+        std::uniform_real_distribution<float> coord{ min, max };
+        std::uniform_real_distribution<double> angle{ 0, 2 * pi };
+        for (int i = 0; i < 100; ++i)
+        {
+            vector_type observer{ coord(engine), coord(engine) };
+            auto&& expected = visibility_polygon(scene, observer, sweep_workspace);
+            auto&& actual = visibility_polygon(triangulation, observer, workspace);
+            REQUIRE(actual.size() >= 3);
+            REQUIRE(signed_area(actual) == Approx(signed_area(expected)).epsilon(1e-4));
+            for (int j = 0; j < 50; ++j)
+            {
+                auto ray = angle(engine);
+                tests::dvec dir{ std::sin(ray), std::cos(ray) };
+                REQUIRE(tests::polygon_ray_distance(observer, dir, actual) ==
+                    Approx(tests::polygon_ray_distance(observer, dir, expected)).epsilon(1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("Triangular expansion gives the same polygon as the sweep", "[expansion]")
+{
+    check_scene(tests::make_scene(21, 12), 0, 120, 22);
+}
+
+TEST_CASE("Triangular expansion gives the same polygon in rooms", "[expansion]")
+{
+    check_scene(tests::make_rooms(10, 0.5, false, true, 23), 0.5f, 99.5f, 24);
+}
+
+TEST_CASE("Triangular expansion outside of the frame gives an empty polygon", "[expansion]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(25, 4);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    constrained_triangulation<vector_type> triangulation{ scene };
+    expansion_workspace<vector_type> workspace;
+    REQUIRE(visibility_polygon(triangulation, vector_type{ 1e6f, 1e6f }, workspace).empty());
+
+    // a query does not allocate memory once the buffers are large enough
+    visibility_polygon(triangulation, vector_type{ 15, 15 }, workspace);
+    auto capacity = workspace.points.capacity();
+    auto data = workspace.points.data();
+    visibility_polygon(triangulation, vector_type{ 15, 15 }, workspace);
+    REQUIRE(workspace.points.data() == data);
+    REQUIRE(workspace.points.capacity() == capacity);
+}
@@ -0,0 +1,187 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/graph.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+namespace
+{
+    // random scene with a straight polyline and a cross in the margin of
+    // the bounding box (their middle vertices are not reflex)
+    std::vector<segment_type> make_graph_scene(unsigned seed, int size)
+    {
+        auto segments = tests::make_scene(seed, size);
+        segments.push_back({ { -8, -5 }, { -5, -5 } });
+        segments.push_back({ { -5, -5 }, { -2, -5 } });
+        for (auto end : { vector_type{ -8, 30 }, vector_type{ -2, 30 },
+            vector_type{ -5, 27 }, vector_type{ -5, 33 } })
+        {
+            segments.push_back({ { -5, 30 }, end });
+        }
+        return segments;
+    }
+
+    // check whether an obstacle crosses the interior of the line of sight
+    // from the i-th to the j-th vertex of a scene: a line segment crosses it
+    // or it passes through a vertex with line segments on both sides
+    bool is_blocked(
+        const geometry::visibility_scene<vector_type>& scene,
+        std::uint32_t i,
+        std::uint32_t j)
+    {
+        auto&& vertices = scene.vertices();
+        auto a = vertices[i], b = vertices[j];
+        for (auto&& segment : scene.segments())
+        {
+            auto c = tests::orient(a, b, segment.a), d = tests::orient(a, b, segment.b);
+            auto e = tests::orient(segment.a, segment.b, a), f = tests::orient(segment.a, segment.b, b);
+            if (((c > 0 && d < 0) || (c < 0 && d > 0)) &&
+                ((e > 0 && f < 0) || (e < 0 && f > 0)))
+            {
+                return true;
+            }
+        }
+
+        for (std::uint32_t k = 0; k < vertices.size(); ++k)
+        {
+            auto v = vertices[k];
+            auto is_inside = k != i && k != j && tests::orient(a, b, v) == 0 &&
+                (static_cast<double>(v.x) - a.x) * (static_cast<double>(v.x) - b.x) +
+                (static_cast<double>(v.y) - a.y) * (static_cast<double>(v.y) - b.y) < 0;
+            if (!is_inside)
+                continue;
+
+            auto is_left = false, is_right = false;
+            for (auto&& record : scene.records())
+            {
+                if (record.a != k && record.b != k)
+                    continue;
+                auto side = tests::orient(a, b, vertices[record.a == k ? record.b : record.a]);
+                is_left = is_left || side > 0;
+                is_right = is_right || side < 0;
+            }
+            if (is_left && is_right)
+                return true;
+        }
+        return false;
+    }
+
+    bool has_edge(const geometry::visibility_graph& graph, std::uint32_t a, std::uint32_t b)
+    {
+        return std::binary_search(graph.neighbors_begin(a), graph.neighbors_end(a), b);
+    }
+}
+
+TEST_CASE("Visibility graph connects mutually visible vertices", "[graph]")
+{
+    using namespace geometry;
+
+    auto segments = make_graph_scene(31, 6);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    auto graph = build_visibility_graph(scene);
+    auto&& vertices = scene.vertices();
+    REQUIRE(graph.size() == vertices.size());
+
+    std::size_t edge_count = 0;
+    for (std::uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        REQUIRE(std::is_sorted(graph.neighbors_begin(i), graph.neighbors_end(i)));
+        for (std::uint32_t j = 0; j < vertices.size(); ++j)
+        {
+            if (i == j)
+                continue;
+            auto is_visible = !is_blocked(scene, i, j);
+            REQUIRE(has_edge(graph, i, j) == is_visible);
+            edge_count += is_visible;
+        }
+    }
+    REQUIRE(graph.neighbors.size() == edge_count);
+}
+
+TEST_CASE("Reduced visibility graph only contains reflex vertices", "[graph]")
+{
+    using namespace geometry;
+
+    auto segments = make_graph_scene(32, 6);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    auto graph = build_visibility_graph(scene);
+    auto reduced = build_visibility_graph(scene, graph_vertices::reflex);
+    auto is_reflex = reflex_vertices(scene);
+
+    // the middle of the polyline and the center of the cross are not
+    // reflex, all other vertices (even corners of the bounding box) are
+    auto&& vertices = scene.vertices();
+    for (std::uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        auto is_middle = vertices[i] == vector_type{ -5, -5 } || vertices[i] == vector_type{ -5, 30 };
+        REQUIRE(is_reflex[i] == !is_middle);
+    }
+
+    for (std::uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        std::vector<std::uint32_t> expected;
+        if (is_reflex[i])
+        {
+            std::copy_if(graph.neighbors_begin(i), graph.neighbors_end(i),
+                std::back_inserter(expected), [&](std::uint32_t j) { return is_reflex[j]; });
+        }
+        REQUIRE(std::vector<std::uint32_t>(
+            reduced.neighbors_begin(i), reduced.neighbors_end(i)) == expected);
+    }
+}
+
+TEST_CASE("Visibility graph of rooms with collinear walls", "[graph]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_rooms(4, 1, false, false);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    auto graph = build_visibility_graph(scene);
+    auto&& vertices = scene.vertices();
+
+    // lines of sight along walls and through doors are not blocked and
+    // the graph is symmetric
+    for (std::uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        for (auto it = graph.neighbors_begin(i); it != graph.neighbors_end(i); ++it)
+        {
+            REQUIRE(!is_blocked(scene, i, *it));
+            REQUIRE(has_edge(graph, *it, i));
+        }
+    }
+
+    // door posts of a room see each other and the next post on the wall
+    auto index = [&](vector_type point)
+    {
+        return static_cast<std::uint32_t>(
+            std::find(vertices.begin(), vertices.end(), point) - vertices.begin());
+    };
+    REQUIRE(has_edge(graph, index({ 10, 14 }), index({ 10, 16 })));
+    REQUIRE(has_edge(graph, index({ 10, 14 }), index({ 16, 10 })));
+    REQUIRE(has_edge(graph, index({ 10, 14 }), index({ 10, 20 })));
+    REQUIRE(!has_edge(graph, index({ 10, 14 }), index({ 10, 26 })));
+}
+
+TEST_CASE("Parallel visibility graph builder gives the same graph", "[graph]")
+{
+    using namespace geometry;
+
+    auto segments = make_graph_scene(33, 8);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    thread_pool pool{ 4 };
+    for (auto mode : { graph_vertices::all, graph_vertices::reflex })
+    {
+        graph_workspace<vector_type> workspace;
+        visibility_graph serial, parallel;
+        build_visibility_graph(scene, mode, workspace, serial);
+        build_visibility_graph(scene, mode, workspace, pool, parallel);
+        REQUIRE(parallel.offsets == serial.offsets);
+        REQUIRE(parallel.neighbors == serial.neighbors);
+    }
+}
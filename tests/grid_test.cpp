@@ -0,0 +1,207 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/grid.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+using dvec = tests::dvec;
+
+TEST_CASE("Grid reports line segments in a box exactly once", "[grid]")
+{
+    using namespace geometry;
+
+    std::mt19937 engine{ 1 };
+    std::uniform_real_distribution<float> coord{ 0, 100 };
+    std::uniform_real_distribution<float> offset{ -5, 5 };
+    std::vector<segment_type> segments;
+    for (int i = 0; i < 500; ++i)
+    {
+        vector_type a{ coord(engine), coord(engine) };
+        segments.emplace_back(a, a + vector_type{ offset(engine), offset(engine) });
+    }
+    segments.emplace_back(vector_type{ 0, 0 }, vector_type{ 100, 100 });
+
+    uniform_grid<vector_type> grid{ segments };
+    REQUIRE(grid.columns() * grid.rows() > 1);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        vector_type a{ coord(engine), coord(engine) };
+        vector_type b{ coord(engine), coord(engine) };
+        vector_type min{ std::min(a.x, b.x), std::min(a.y, b.y) };
+        vector_type max{ std::max(a.x, b.x), std::max(a.y, b.y) };
+
+        std::vector<int> visits(segments.size(), 0);
+        grid.visit_box(min, max, [&](std::uint32_t index) { ++visits[index]; });
+
+        for (std::size_t j = 0; j < segments.size(); ++j)
+        {
+            auto&& segment = segments[j];
+            REQUIRE(visits[j] <= 1);
+
+            // line segments whose bounding box intersects the box must be
+            // reported
+            auto overlaps = 
+                std::max(segment.a.x, segment.b.x) >= min.x &&
+                std::min(segment.a.x, segment.b.x) <= max.x &&
+                std::max(segment.a.y, segment.b.y) >= min.y &&
+                std::min(segment.a.y, segment.b.y) <= max.y;
+            if (overlaps)
+                REQUIRE(visits[j] == 1);
+        }
+    }
+}
+
+TEST_CASE("Empty grid does not report any line segments", "[grid]")
+{
+    std::vector<segment_type> segments;
+    geometry::uniform_grid<vector_type> grid{ segments };
+    auto count = 0;
+    grid.visit_box(vector_type{ 0, 0 }, vector_type{ 1, 1 }, [&](std::uint32_t) { ++count; });
+    REQUIRE(count == 0);
+}
+
+namespace
+{
+    // random short line segments and 1 long diagonal line segment
+    std::vector<segment_type> make_segments(unsigned seed)
+    {
+        std::mt19937 engine{ seed };
+        std::uniform_real_distribution<float> coord{ 0, 100 };
+        std::uniform_real_distribution<float> offset{ -5, 5 };
+        std::vector<segment_type> segments;
+        for (int i = 0; i < 1000; ++i)
+        {
+            vector_type a{ coord(engine), coord(engine) };
+            segments.emplace_back(a, a + vector_type{ offset(engine), offset(engine) });
+        }
+        segments.emplace_back(vector_type{ 0, 0 }, vector_type{ 100, 100 });
+        return segments;
+    }
+}
+
+TEST_CASE("Grid reports line segments in a disc exactly once", "[grid]")
+{
+    using namespace geometry;
+
+    auto segments = make_segments(2);
+    uniform_grid<vector_type> grid{ segments };
+
+    std::mt19937 engine{ 3 };
+    std::uniform_real_distribution<float> coord{ -20, 120 };
+    std::uniform_real_distribution<double> radius{ 0, 30 };
+    for (int i = 0; i < 100; ++i)
+    {
+        vector_type center{ coord(engine), coord(engine) };
+        auto r = radius(engine);
+        std::vector<int> visits(segments.size(), 0);
+        grid.visit_disc(center, r, [&](std::uint32_t index) { ++visits[index]; });
+
+        for (std::size_t j = 0; j < segments.size(); ++j)
+        {
+            REQUIRE(visits[j] <= 1);
+            if (tests::distance(tests::to_double(center), segments[j]) <= r)
+                REQUIRE(visits[j] == 1);
+        }
+    }
+}
+
+TEST_CASE("Grid reports line segments in a wedge exactly once", "[grid]")
+{
+    using namespace geometry;
+
+    auto segments = make_segments(4);
+    uniform_grid<vector_type> grid{ segments };
+
+    std::mt19937 engine{ 5 };
+    std::uniform_real_distribution<float> coord{ -20, 120 };
+    std::uniform_real_distribution<double> angle{ 0, 2 * 3.14159265358979323846 };
+    std::uniform_real_distribution<double> half_angle{ 0, 3.14159265358979323846 };
+    for (int i = 0; i < 200; ++i)
+    {
+        vector_type apex{ coord(engine), coord(engine) };
+        auto axis = angle(engine), half = half_angle(engine);
+        dvec start{ std::sin(axis - half), std::cos(axis - half) };
+        dvec end{ std::sin(axis + half), std::cos(axis + half) };
+        std::vector<int> visits(segments.size(), 0);
+        grid.visit_wedge(apex, start, end, [&](std::uint32_t index) { ++visits[index]; });
+
+        auto origin = tests::to_double(apex);
+        for (std::size_t j = 0; j < segments.size(); ++j)
+        {
+            REQUIRE(visits[j] <= 1);
+            if (half > 1.5)
+            {
+                // wider wedges are not culled
+                continue;
+            }
+
+            auto&& segment = segments[j];
+            auto intersects =
+                tests::wedge_contains(origin, start, end, tests::to_double(segment.a)) ||
+                tests::wedge_contains(origin, start, end, tests::to_double(segment.b)) ||
+                std::isfinite(tests::ray_distance(origin, start, segment)) ||
+                std::isfinite(tests::ray_distance(origin, end, segment));
+            if (intersects)
+                REQUIRE(visits[j] == 1);
+        }
+    }
+}
+
+TEST_CASE("Grid reports line segments along a ray in order", "[grid]")
+{
+    using namespace geometry;
+
+    auto segments = make_segments(6);
+    uniform_grid<vector_type> grid{ segments };
+
+    std::mt19937 engine{ 7 };
+    std::uniform_real_distribution<float> coord{ -20, 120 };
+    std::uniform_real_distribution<double> angle{ 0, 2 * 3.14159265358979323846 };
+    for (int i = 0; i < 200; ++i)
+    {
+        vector_type origin{ coord(engine), coord(engine) };
+        auto direction = angle(engine);
+        dvec dir{ std::sin(direction), std::cos(direction) };
+        if (i % 10 == 0)
+            dir = dvec{ static_cast<double>(i % 20 == 0), static_cast<double>(i % 20 != 0) };
+
+        // all intersected line segments are reported once
+        std::vector<int> visits(segments.size(), 0);
+        grid.visit_ray(origin, dir, 80, [&](std::uint32_t index)
+        {
+            ++visits[index];
+            return 80.0;
+        });
+        auto nearest = std::numeric_limits<double>::infinity();
+        for (std::size_t j = 0; j < segments.size(); ++j)
+        {
+            auto t = tests::ray_distance(tests::to_double(origin), dir, segments[j]);
+            REQUIRE(visits[j] <= 1);
+            if (t <= 80)
+                REQUIRE(visits[j] == 1);
+            nearest = std::min(nearest, t);
+        }
+
+        // the nearest intersection is found if the ray is shortened
+        auto hit = std::numeric_limits<double>::infinity();
+        std::size_t count = 0;
+        grid.visit_ray(origin, dir, 1000, [&](std::uint32_t index)
+        {
+            ++count;
+            hit = std::min(hit, tests::ray_distance(tests::to_double(origin), dir, segments[index]));
+            return hit;
+        });
+        REQUIRE(hit == nearest);
+        if (std::isfinite(nearest))
+            REQUIRE(count < segments.size() / 4);
+    }
+}
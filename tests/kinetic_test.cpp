@@ -0,0 +1,92 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/kinetic.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+namespace
+{
+    // check whether two polygons have approximately equal vertices
+    bool polygons_match(
+        const std::vector<vector_type>& a,
+        const std::vector<vector_type>& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (std::size_t i = 0; i < a.size(); ++i)
+        {
+            if (geometry::distance_squared(a[i], b[i]) > 1e-6f)
+                return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE("Kinetic visibility matches queries from scratch along a path", "[kinetic]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(7, 5);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    std::vector<vector_type> path{
+        { 0.5f, 0.5f }, { 40.5f, 5.5f }, { 35.5f, 45.5f }, { 2.5f, 30.5f },
+    };
+    kinetic_visibility<vector_type> kinetic{ scene, path.begin(), path.end() };
+
+    REQUIRE(kinetic.size() > 1);
+    REQUIRE(kinetic.piece_first(0) == 0);
+    for (std::size_t i = 1; i < kinetic.size(); ++i)
+        REQUIRE(kinetic.piece_first(i) > kinetic.piece_first(i - 1));
+    REQUIRE(kinetic.piece_last(kinetic.size() - 1) == Approx(kinetic.length()));
+
+    // sample the path densely and compare polygons away from the changes
+    const std::size_t samples = 2000;
+    std::size_t matches = 0, tested = 0;
+    for (std::size_t i = 0; i <= samples; ++i)
+    {
+        auto parameter = kinetic.length() * i / samples;
+        auto piece = kinetic.find_piece(parameter);
+        auto margin = 1e-4;
+        if (parameter - kinetic.piece_first(piece) < margin ||
+            kinetic.piece_last(piece) - parameter < margin)
+            continue;
+
+        ++tested;
+        auto expected = visibility_polygon(scene, kinetic.position(parameter));
+        matches += polygons_match(kinetic.polygon(parameter), expected);
+    }
+    REQUIRE(tested > samples / 2);
+    REQUIRE(matches == tested);
+
+    // only changes of the polygon need a sweep
+    REQUIRE(kinetic.sweep_count() < samples);
+    REQUIRE(kinetic.sweep_count() < kinetic.certificate_count());
+}
+
+TEST_CASE("Kinetic visibility in an empty room has one piece", "[kinetic]")
+{
+    using namespace geometry;
+
+    std::vector<segment_type> segments{
+        { { 0, 0 }, { 0, 10 } },
+        { { 0, 10 }, { 10, 10 } },
+        { { 10, 10 }, { 10, 0 } },
+        { { 10, 0 }, { 0, 0 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    std::vector<vector_type> path{ { 1, 1 }, { 9, 2 }, { 5, 8 } };
+    kinetic_visibility<vector_type> kinetic{ scene, path.begin(), path.end() };
+
+    REQUIRE(kinetic.size() == 1);
+    REQUIRE(kinetic.sweep_count() == 1);
+    auto poly = kinetic.polygon(3);
+    REQUIRE(poly == visibility_polygon(scene, kinetic.position(3)));
+    REQUIRE(poly.size() == 4);
+}
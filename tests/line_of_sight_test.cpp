@@ -0,0 +1,126 @@
+#include "catch.hpp"
+
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/line_of_sight.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+TEST_CASE("Line of sight agrees with a test of all line segments", "[line_of_sight]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(41, 20);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+
+    // short and long lines of sight, some of them leave the scene
+    std::mt19937 engine{ 42 };
+    std::uniform_real_distribution<float> coord{ -20, 220 };
+    std::uniform_real_distribution<float> offset{ -15, 15 };
+    std::size_t visible_count = 0;
+    for (int i = 0; i < 4000; ++i)
+    {
+        vector_type a{ coord(engine), coord(engine) };
+        auto b = i % 2 == 0 ?
+            vector_type{ coord(engine), coord(engine) } :
+            a + vector_type{ offset(engine), offset(engine) };
+        auto expected = tests::crosses_no_segment(scene.segments(), a, b);
+        REQUIRE(line_of_sight(scene, a, b) == expected);
+        REQUIRE(line_of_sight(scene, b, a) == expected);
+        visible_count += expected;
+    }
+    REQUIRE(visible_count > 500);
+    REQUIRE(visible_count < 3500);
+}
+
+TEST_CASE("Line of sight is not blocked by touching an obstacle", "[line_of_sight]")
+{
+    using namespace geometry;
+
+    // a room with a door in the right wall and a wall behind it
+    std::vector<segment_type> segments{
+        { { 0, 0 }, { 0, 10 } },
+        { { 0, 10 }, { 10, 10 } },
+        { { 10, 10 }, { 10, 6 } },
+        { { 10, 4 }, { 10, 0 } },
+        { { 10, 0 }, { 0, 0 } },
+        { { 20, -5 }, { 20, 15 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+
+    REQUIRE(line_of_sight(scene, vector_type{ 5, 5 }, vector_type{ 15, 5 }));
+    REQUIRE(!line_of_sight(scene, vector_type{ 5, 5 }, vector_type{ 15, 9 }));
+    REQUIRE(!line_of_sight(scene, vector_type{ 5, 5 }, vector_type{ 25, 5 }));
+    REQUIRE(line_of_sight(scene, vector_type{ 5, 5 }, vector_type{ 5, 5 }));
+
+    // through the door post, along a wall and ending on a wall
+    REQUIRE(line_of_sight(scene, vector_type{ 8, 8 }, vector_type{ 12, 4 }));
+    REQUIRE(line_of_sight(scene, vector_type{ 10, 12 }, vector_type{ 10, 7 }));
+    REQUIRE(line_of_sight(scene, vector_type{ 5, 5 }, vector_type{ 10, 8 }));
+    REQUIRE(line_of_sight(scene, vector_type{ 5, 5 }, vector_type{ 5, 10 }));
+}
+
+TEST_CASE("Line of sight is blocked by a corner of a closed polygon", "[line_of_sight]")
+{
+    using namespace geometry;
+
+    // a box in a frame
+    std::vector<segment_type> segments{
+        { { 0, 0 }, { 2, 0 } },
+        { { 2, 0 }, { 2, 2 } },
+        { { 2, 2 }, { 0, 2 } },
+        { { 0, 2 }, { 0, 0 } },
+        { { -5, -5 }, { -5, 5 } },
+        { { -5, 5 }, { 5, 5 } },
+        { { 5, 5 }, { 5, -5 } },
+        { { 5, -5 }, { -5, -5 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+
+    // through a corner into the box, through the box and along its sides
+    std::vector<segment_type> pairs{
+        { { -1, -1 }, { 1, 1 } },
+        { { -1, -1 }, { 3, 3 } },
+        { { -1, 3 }, { 3, -1 } },
+        { { -1, 2 }, { 3, 2 } },
+        { { -1, 1 }, { 1, -1 } },
+        { { -1, 1 }, { 1, 3 } },
+        { { -1, -1 }, { 0, 0 } },
+        { { 2, 0 }, { 4, -2 } },
+    };
+    std::vector<std::uint8_t> expected{ 0, 0, 0, 1, 1, 1, 1, 1 };
+    for (std::size_t i = 0; i < pairs.size(); ++i)
+    {
+        REQUIRE(line_of_sight(scene, pairs[i].a, pairs[i].b) == (expected[i] != 0));
+        REQUIRE(line_of_sight(scene, pairs[i].b, pairs[i].a) == (expected[i] != 0));
+    }
+}
+
+TEST_CASE("Batched line of sight queries give the same results", "[line_of_sight]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(43, 15);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    std::mt19937 engine{ 44 };
+    std::uniform_real_distribution<float> coord{ 0, 150 };
+    std::vector<segment_type> pairs;
+    for (int i = 0; i < 3000; ++i)
+        pairs.push_back({ { coord(engine), coord(engine) }, { coord(engine), coord(engine) } });
+
+    std::vector<std::uint8_t> expected{ 7 };
+    lines_of_sight(scene, pairs.begin(), pairs.end(), expected);
+    REQUIRE(expected.size() == pairs.size() + 1);
+    REQUIRE(expected[0] == 7);
+    for (std::size_t i = 0; i < pairs.size(); ++i)
+        REQUIRE((expected[i + 1] != 0) == line_of_sight(scene, pairs[i].a, pairs[i].b));
+
+    thread_pool pool{ 4 };
+    std::vector<std::uint8_t> actual{ 7 };
+    lines_of_sight(scene, pairs.begin(), pairs.end(), pool, actual);
+    REQUIRE(actual == expected);
+}
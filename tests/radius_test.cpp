@@ -0,0 +1,150 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/radius.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+using vertex_type = geometry::limited_vertex<vector_type>;
+
+namespace
+{
+    // clockwise angle of a direction from the positive y axis in [0, 2 pi)
+    double clockwise_angle(double x, double y)
+    {
+        auto angle = std::atan2(x, y);
+        return angle < 0 ? angle + 2 * 3.14159265358979323846 : angle;
+    }
+
+    // distance from the observer to the boundary of a polygon in a
+    // direction (arc edges are arcs of a circle with given radius)
+    double boundary_distance(
+        vector_type observer,
+        double angle,
+        const std::vector<vertex_type>& polygon,
+        double radius)
+    {
+        double dx = std::sin(angle), dy = std::cos(angle);
+        auto result = std::numeric_limits<double>::infinity();
+        for (std::size_t i = 0; i < polygon.size(); ++i)
+        {
+            auto&& first = polygon[i];
+            auto&& second = polygon[(i + 1) % polygon.size()];
+            double ax = first.point.x - observer.x, ay = first.point.y - observer.y;
+            double bx = second.point.x - observer.x, by = second.point.y - observer.y;
+            if (first.is_arc && radius > 0)
+            {
+                auto from = clockwise_angle(ax, ay), to = clockwise_angle(bx, by);
+                auto is_inside = from <= to ?
+                    from <= angle && angle <= to :
+                    from <= angle || angle <= to;
+                if (is_inside)
+                    result = std::min(result, radius);
+                continue;
+            }
+
+            // intersection of the ray with the edge
+            double ex = bx - ax, ey = by - ay;
+            auto denominator = dx * ey - dy * ex;
+            if (denominator == 0)
+                continue;
+            auto t = (ax * ey - ay * ex) / denominator;
+            auto s = (ax * dy - ay * dx) / denominator;
+            if (t >= 0 && s >= -1e-6 && s <= 1 + 1e-6)
+                result = std::min(result, t);
+        }
+        return result;
+    }
+
+    std::vector<vertex_type> to_limited(const std::vector<vector_type>& polygon)
+    {
+        std::vector<vertex_type> result;
+        for (auto&& vertex : polygon)
+            result.push_back(vertex_type{ vertex, false });
+        return result;
+    }
+}
+
+TEST_CASE("Radius query without obstacles in the disc gives the circle", "[radius]")
+{
+    using namespace geometry;
+
+    std::vector<segment_type> segments{
+        { { -100, -100 }, { -100, 100 } },
+        { { -100, 100 }, { 100, 100 } },
+        { { 100, 100 }, { 100, -100 } },
+        { { 100, -100 }, { -100, -100 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+    vector_type observer{ 1, 2 };
+
+    std::vector<vertex_type> polyline;
+    visibility_polygon(scene, observer, 10, 0.01, workspace, std::back_inserter(polyline));
+    REQUIRE(polyline.size() > 50);
+    for (std::size_t i = 0; i < polyline.size(); ++i)
+    {
+        auto&& vertex = polyline[i];
+        auto&& next = polyline[(i + 1) % polyline.size()];
+        REQUIRE(vertex.is_arc);
+        REQUIRE(std::sqrt(distance_squared(vertex.point, observer)) == Approx(10));
+
+        // distance of the chord from the circle
+        auto middle = (vertex.point + next.point) / 2.f;
+        REQUIRE(10 - std::sqrt(distance_squared(middle, observer)) <= 0.0101);
+    }
+
+    std::vector<vertex_type> arcs;
+    visibility_polygon(scene, observer, 10, 0, workspace, std::back_inserter(arcs));
+    REQUIRE(arcs.size() == 2);
+    REQUIRE(arcs[0].is_arc);
+    REQUIRE(arcs[1].is_arc);
+}
+
+TEST_CASE("Radius query gives the visibility polygon clipped by the circle", "[radius]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(7, 10);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+
+    std::mt19937 engine{ 8 };
+    std::uniform_real_distribution<float> coord{ 0, 100 };
+    std::uniform_real_distribution<double> angle{ 0, 2 * 3.14159265358979323846 };
+    for (int i = 0; i < 50; ++i)
+    {
+        vector_type observer{ coord(engine), coord(engine) };
+        auto full = to_limited(visibility_polygon(scene, observer, workspace));
+        for (double radius : { 3.0, 15.0 })
+        {
+            const double tolerance = 0.01;
+            std::vector<vertex_type> polyline, arcs;
+            visibility_polygon(scene, observer, radius, tolerance, workspace,
+                std::back_inserter(polyline));
+            REQUIRE(workspace.segments.size() < scene.size() / 2);
+            visibility_polygon(scene, observer, radius, 0, workspace,
+                std::back_inserter(arcs));
+
+            for (int j = 0; j < 20; ++j)
+            {
+                auto direction = angle(engine);
+                auto expected = std::min(radius,
+                    boundary_distance(observer, direction, full, 0));
+                auto polyline_distance = boundary_distance(
+                    observer, direction, polyline, 0);
+                auto arc_distance = boundary_distance(
+                    observer, direction, arcs, radius);
+                REQUIRE(polyline_distance <= expected + 1e-3);
+                REQUIRE(polyline_distance >= expected - tolerance - 1e-3);
+                REQUIRE(arc_distance == Approx(expected).epsilon(1e-4));
+            }
+        }
+    }
+}
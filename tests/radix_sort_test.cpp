@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include <random>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <visibility/radix_sort.hpp>
+
+using item_type = std::pair<std::uint64_t, int>;
+
+void test_radix_sort(
+    const std::vector<item_type>& items, 
+    std::size_t first_bit = 0, 
+    std::size_t last_bit = 64)
+{
+    auto mask = last_bit - first_bit == 64 ? 
+        ~std::uint64_t(0) : 
+        ((std::uint64_t(1) << (last_bit - first_bit)) - 1) << first_bit;
+    auto expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [mask](auto&& a, auto&& b)
+    {
+        return (a.first & mask) < (b.first & mask);
+    });
+
+    std::vector<std::uint64_t> keys, key_buffer;
+    std::vector<int> values, value_buffer;
+    for (auto&& item : items)
+    {
+        keys.push_back(item.first);
+        values.push_back(item.second);
+    }
+    geometry::radix_sort(keys, values, key_buffer, value_buffer, first_bit, last_bit);
+
+    REQUIRE(keys.size() == expected.size());
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        REQUIRE(keys[i] == expected[i].first);
+        REQUIRE(values[i] == expected[i].second);
+    }
+}
+
+TEST_CASE("Radix sort an empty array", "[radix_sort]")
+{
+    test_radix_sort({});
+}
+
+TEST_CASE("Radix sort random keys", "[radix_sort]")
+{
+    std::mt19937_64 engine{ 3 };
+    std::vector<item_type> items;
+    for (int i = 0; i < 10000; ++i)
+        items.emplace_back(engine(), i);
+    test_radix_sort(items);
+}
+
+TEST_CASE("Radix sort by the high half of keys", "[radix_sort]")
+{
+    std::mt19937_64 engine{ 5 };
+    std::vector<item_type> items;
+    for (int i = 0; i < 10000; ++i)
+        items.emplace_back(engine() & 0xFFFF0000FFFFFFFFull, i);
+    test_radix_sort(items, 32, 64);
+}
+
+TEST_CASE("Radix sort is stable and skips constant digits", "[radix_sort]")
+{
+    std::mt19937_64 engine{ 4 };
+    std::vector<item_type> items;
+    for (int i = 0; i < 10000; ++i)
+        items.emplace_back(0x3F80000000000000ull | (engine() & 0xFF00FF), i);
+    test_radix_sort(items);
+
+    // an odd number of passes ends in the buffer
+    items.clear();
+    for (int i = 0; i < 1000; ++i)
+        items.emplace_back(engine() & 0xFF, i);
+    test_radix_sort(items);
+}
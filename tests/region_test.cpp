@@ -0,0 +1,153 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/region.hpp>
+#include <visibility/scene.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+namespace
+{
+    const double pi = 3.14159265358979323846;
+
+
+    // even-odd test of a point in a polygon
+    bool contains(const std::vector<vector_type>& polygon, vector_type point)
+    {
+        auto result = false;
+        for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            auto a = polygon[i], b = polygon[j];
+            if ((a.y > point.y) != (b.y > point.y) &&
+                point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+            {
+                result = !result;
+            }
+        }
+        return result;
+    }
+
+    // distance of a point from the boundary of a polygon
+    double boundary_distance(const std::vector<vector_type>& polygon, vector_type point)
+    {
+        auto result = std::numeric_limits<double>::infinity();
+        for (std::size_t i = 0; i < polygon.size(); ++i)
+        {
+            auto a = geometry::relative_position(point, polygon[i]);
+            auto b = geometry::relative_position(point, polygon[(i + 1) % polygon.size()]);
+            auto dir = b - a;
+            auto t = std::max(0.0, std::min(1.0, -geometry::dot(a, dir) / geometry::length_squared(dir)));
+            result = std::min(result, std::sqrt(geometry::length_squared(a + dir * t)));
+        }
+        return result;
+    }
+}
+
+TEST_CASE("Visibility region agrees with a point in polygon test", "[region]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(61, 10);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+    visibility_region<vector_type> region;
+
+    std::mt19937 engine{ 62 };
+    std::uniform_real_distribution<float> coord{ -5, 105 };
+    std::uniform_real_distribution<double> angle{ 0, 2 * pi };
+    for (int i = 0; i < 50; ++i)
+    {
+        vector_type observer{ coord(engine), coord(engine) };
+        auto&& poly = visibility_polygon(scene, observer, workspace);
+        region.assign(observer, poly.begin(), poly.end());
+        REQUIRE(region.size() == poly.size());
+        REQUIRE(region.contains(observer));
+
+        for (int j = 0; j < 500; ++j)
+        {
+            vector_type point{ coord(engine), coord(engine) };
+            if (boundary_distance(poly, point) > 1e-3)
+                REQUIRE(region.contains(point) == contains(poly, point));
+        }
+
+        // a ray through a vertex leaves the region at the vertex or
+        // farther (if the vertex is an endpoint of a shadow edge)
+        for (auto&& vertex : poly)
+        {
+            auto dir = relative_position(observer, vertex);
+            REQUIRE(region.contains(vertex));
+            auto hit = relative_position(observer, region.ray_hit(dir));
+            REQUIRE(length_squared(hit) >= length_squared(dir));
+        }
+
+        for (int j = 0; j < 50; ++j)
+        {
+            auto ray = angle(engine);
+            vector2<double> dir{ std::sin(ray), std::cos(ray) };
+            auto hit = region.ray_hit(dir);
+            auto distance = std::sqrt(length_squared(relative_position(observer, hit)));
+            REQUIRE(distance == Approx(tests::polygon_ray_distance(observer, dir, poly)).epsilon(1e-4));
+        }
+    }
+}
+
+TEST_CASE("Visibility region does not depend on the first vertex", "[region]")
+{
+    using namespace geometry;
+
+    // a square room seen from its center with a wall which casts a shadow
+    // ending on the +y axis
+    vector_type observer{ 0, 0 };
+    std::vector<vector_type> poly{
+        { 0, 10 }, { 10, 10 }, { 10, -10 }, { -10, -10 }, { -10, 10 },
+        { -1, 10 }, { -0.5f, 5 }, { 0, 5 },
+    };
+
+    // the endpoint of the shadow edge is rounded just left of the +y axis
+    auto rounded = poly;
+    rounded[0] = vector_type{ -1e-6f, 10 };
+
+    for (std::size_t shift = 0; shift < 2 * poly.size(); ++shift)
+    {
+        auto&& source = shift < poly.size() ? poly : rounded;
+        std::vector<vector_type> rotated{ source };
+        std::rotate(rotated.begin(), rotated.begin() + shift % poly.size(), rotated.end());
+        visibility_region<vector_type> region{ observer, rotated.begin(), rotated.end() };
+        REQUIRE(region.vertices().front() == vector_type(0, 5));
+        REQUIRE(region.vertices()[1] == source[0]);
+        REQUIRE(region.contains(vector_type{ 5, 5 }));
+        REQUIRE(region.contains(vector_type{ -5, -5 }));
+        REQUIRE(region.contains(vector_type{ 0.2f, 9 }));
+        REQUIRE(!region.contains(vector_type{ -0.2f, 9 }));
+        REQUIRE(!region.contains(vector_type{ 11, 0 }));
+        REQUIRE(region.contains(vector_type{ 10, 0 }));
+        REQUIRE(region.ray_hit({ 1, 0 }) == vector_type(10, 0));
+        REQUIRE(region.ray_hit({ -1, 2 }) == vector_type(-5, 10));
+        REQUIRE(region.contains(vector_type(-0.75f, 7.5f)));
+        REQUIRE(!region.contains(vector_type(-1.1f, 11)));
+        REQUIRE(region.ray_hit({ -0.5, 5 }) == vector_type(-1, 10));
+        REQUIRE(region.ray_hit({ 0, -2 }) == vector_type(0, -10));
+        REQUIRE(region.contains(vector_type{ 0, 9.5f }));
+        REQUIRE(!region.contains(vector_type{ 0, 10.5f }));
+        REQUIRE(std::abs(region.ray_hit({ 0, 1 }).y - 10) < 1e-4);
+    }
+}
+
+TEST_CASE("Empty visibility region contains no points", "[region]")
+{
+    using namespace geometry;
+
+    std::vector<vector_type> poly;
+    visibility_region<vector_type> region{ vector_type{ 1, 2 }, poly.begin(), poly.end() };
+    REQUIRE(region.empty());
+    REQUIRE(!region.contains(vector_type{ 1, 2 }));
+    REQUIRE(region.ray_hit({ 1, 0 }) == vector_type(1, 2));
+}
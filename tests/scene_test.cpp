@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/scene.hpp>
+#include <visibility/batch.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+TEST_CASE("Scene welds equal endpoints and removes degenerate line segments", "[scene]")
+{
+    using namespace geometry;
+
+    std::vector<segment_type> segments{
+        { { 0, 0 }, { 1, 0 } },
+        { { 1, 0 }, { 1, 1 } },
+        { { 1, 1 }, { 1, 1 } },
+        { { 0, 0 }, { 1, 1 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+
+    REQUIRE(scene.size() == 3);
+    REQUIRE(scene.vertices().size() == 3);
+    REQUIRE(scene.records()[0].b == scene.records()[1].a);
+    REQUIRE(scene.records()[1].b == scene.records()[2].b);
+    REQUIRE(scene.records()[0].a == scene.records()[2].a);
+    for (std::size_t i = 0; i < scene.size(); ++i)
+    {
+        REQUIRE(scene.segments()[i].a == scene.vertices()[scene.records()[i].a]);
+        REQUIRE(scene.segments()[i].b == scene.vertices()[scene.records()[i].b]);
+    }
+}
+
+TEST_CASE("Scene welds approximately equal endpoints separated in the sorted order", "[scene]")
+{
+    using namespace geometry;
+
+    // (10, 7) is between (10, 5) and its approximate copy in the
+    // lexicographic order
+    std::vector<segment_type> segments{
+        { { 10, 5 }, { 0, 5 } },
+        { { std::nextafter(10.f, 20.f), 5 }, { 20, 5 } },
+        { { 10, 7 }, { 10, 9 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+
+    REQUIRE(scene.vertices().size() == 5);
+    REQUIRE(scene.records()[0].a == scene.records()[1].a);
+}
+
+TEST_CASE("Line equations of a scene give orientation of points", "[scene]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(1, 5);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+
+    std::mt19937 engine{ 2 };
+    std::uniform_real_distribution<float> coord{ -10, 60 };
+    for (int i = 0; i < 100; ++i)
+    {
+        vector_type point{ coord(engine), coord(engine) };
+        for (std::size_t j = 0; j < scene.size(); ++j)
+        {
+            auto&& segment = scene.segments()[j];
+            REQUIRE(scene.lines()[j].side(point) == 
+                compute_orientation(point, segment.a, segment.b));
+        }
+    }
+    REQUIRE(scene.lines()[0].side(scene.segments()[0].a) == orientation::collinear);
+}
+
+TEST_CASE("Visibility polygon in a scene is the same as with a list of line segments", "[scene]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(3, 10);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+
+    std::mt19937 engine{ 4 };
+    std::uniform_real_distribution<float> coord{ 0, 100 };
+    visibility_workspace<vector_type> workspace;
+    std::vector<vector_type> observers;
+    for (int i = 0; i < 50; ++i)
+    {
+        vector_type observer{ coord(engine), coord(engine) };
+        observers.push_back(observer);
+        auto expected = visibility_polygon(observer, segments.begin(), segments.end());
+        auto&& poly = visibility_polygon(scene, observer, workspace);
+        REQUIRE(poly.size() == expected.size());
+        for (std::size_t j = 0; j < poly.size(); ++j)
+            REQUIRE(approx_equal(poly[j], expected[j]));
+    }
+
+    // batch queries from multiple threads
+    thread_pool pool{ 4 };
+    batch_workspace<vector_type> batch;
+    packed_polygons<vector_type> expected, polygons;
+    visibility_polygons(observers.begin(), observers.end(), scene, batch, expected);
+    visibility_polygons(observers.begin(), observers.end(), scene, batch, pool, polygons);
+    REQUIRE(polygons.offsets == expected.offsets);
+    for (std::size_t i = 0; i < polygons.vertices.size(); ++i)
+        REQUIRE(polygons.vertices[i] == expected.vertices[i]);
+}
@@ -0,0 +1,241 @@
+#ifndef TESTS_SCENES_HPP_
+#define TESTS_SCENES_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <visibility/vector2.hpp>
+#include <visibility/primitives.hpp>
+
+namespace tests
+{
+    using vector_type = geometry::vec2;
+    using segment_type = geometry::line_segment<vector_type>;
+    using dvec = geometry::vector2<double>;
+
+    /** Generate a random line segment in each cell of a size x size grid of
+     * cells of size 10 with a corner at the origin. The scene is enclosed
+     * in a bounding box with a margin of 10.
+     * @param seed of the random generator
+     * @param size number of rows and columns of the grid
+     * @return line segments of the scene (the bounding box first)
+     */
+    inline std::vector<segment_type> make_scene(unsigned seed, int size)
+    {
+        std::mt19937 engine{ seed };
+        std::uniform_real_distribution<float> offset{ 1, 9 };
+        auto max = size * 10.f + 10;
+        std::vector<segment_type> segments{
+            { { -10, -10 },{ -10, max } },
+            { { -10, max },{ max, max } },
+            { { max, max },{ max, -10 } },
+            { { max, -10 },{ -10, -10 } },
+        };
+        for (int i = 0; i < size; ++i)
+        {
+            for (int j = 0; j < size; ++j)
+            {
+                vector_type corner{ i * 10.f, j * 10.f };
+                segments.emplace_back(
+                    corner + vector_type{ offset(engine), offset(engine) },
+                    corner + vector_type{ offset(engine), offset(engine) });
+            }
+        }
+        return segments;
+    }
+
+    /** Generate walls of a size x size grid of rooms of size 10 with a 
+     * corner at the origin (many collinear and cocircular vertices). A wall
+     * with a door is split into 2 line segments with a gap of 2 units in 
+     * the middle.
+     * @param size number of rows and columns of rooms
+     * @param door_probability probability of a door in an inner wall
+     * @param has_outer_doors true iff outer walls have doors
+     * @param has_tables true iff a random line segment (table) is added to
+     *        each room
+     * @param seed of the random generator
+     * @return line segments of the scene
+     */
+    inline std::vector<segment_type> make_rooms(
+        int size,
+        double door_probability,
+        bool has_outer_doors,
+        bool has_tables,
+        unsigned seed = 0)
+    {
+        std::mt19937 engine{ seed };
+        std::uniform_real_distribution<float> offset{ 2, 8 };
+        std::bernoulli_distribution has_door{ door_probability };
+        std::vector<segment_type> segments;
+        for (int i = 0; i <= size; ++i)
+        {
+            for (int j = 0; j < size; ++j)
+            {
+                auto u = i * 10.f, v = j * 10.f;
+                auto is_outer = i == 0 || i == size;
+                for (auto is_vertical : { true, false })
+                {
+                    auto point = [=](float t)
+                    {
+                        return is_vertical ? vector_type{ u, v + t } : vector_type{ v + t, u };
+                    };
+                    if (is_outer ? has_outer_doors : has_door(engine))
+                    {
+                        segments.push_back({ point(0), point(4) });
+                        segments.push_back({ point(6), point(10) });
+                    }
+                    else
+                    {
+                        segments.push_back({ point(0), point(10) });
+                    }
+                }
+            }
+        }
+
+        if (!has_tables)
+            return segments;
+        for (int i = 0; i < size; ++i)
+        {
+            for (int j = 0; j < size; ++j)
+            {
+                vector_type corner{ i * 10.f, j * 10.f };
+                segments.emplace_back(
+                    corner + vector_type{ offset(engine), offset(engine) },
+                    corner + vector_type{ offset(engine), offset(engine) });
+            }
+        }
+        return segments;
+    }
+
+    /** Compute twice the signed area of a triangle in double precision.
+     * @param a 
+     * @param b 
+     * @param c 
+     * @return positive value iff abc is counterclockwise
+     */
+    inline double orient(vector_type a, vector_type b, vector_type c)
+    {
+        return (static_cast<double>(b.x) - a.x) * (static_cast<double>(c.y) - a.y) -
+            (static_cast<double>(b.y) - a.y) * (static_cast<double>(c.x) - a.x);
+    }
+
+    /** Test a line of sight against all line segments of a scene (random 
+     * scenes have no shared endpoints, so a line of sight is blocked iff it
+     * properly crosses a line segment).
+     * @param segments line segments of the scene
+     * @param a first endpoint of the line of sight
+     * @param b second endpoint of the line of sight
+     * @return true iff no line segment crosses the line of sight
+     */
+    inline bool crosses_no_segment(
+        const std::vector<segment_type>& segments, 
+        vector_type a, 
+        vector_type b)
+    {
+        for (auto&& segment : segments)
+        {
+            auto c = orient(a, b, segment.a), d = orient(a, b, segment.b);
+            auto e = orient(segment.a, segment.b, a), f = orient(segment.a, segment.b, b);
+            if (((c > 0 && d < 0) || (c < 0 && d > 0)) &&
+                ((e > 0 && f < 0) || (e < 0 && f > 0)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    inline dvec to_double(vector_type point)
+    {
+        return dvec{ point.x, point.y };
+    }
+
+    /** Compute distance from a point to a line segment.
+     * @param point 
+     * @param segment line segment (it can be degenerate)
+     * @return distance
+     */
+    inline double distance(dvec point, const segment_type& segment)
+    {
+        auto a = to_double(segment.a), b = to_double(segment.b);
+        auto dir = b - a;
+        auto length = geometry::length_squared(dir);
+        auto t = length > 0 ? geometry::dot(point - a, dir) / length : 0;
+        t = std::max(0.0, std::min(1.0, t));
+        return std::sqrt(geometry::length_squared(a + dir * t - point));
+    }
+
+    /** Compute distance from the origin of a ray to its intersection with 
+     * a line segment.
+     * @param origin origin of the ray
+     * @param dir direction of the ray (unit vector)
+     * @param segment line segment
+     * @return distance or infinity if the ray does not hit the line segment
+     */
+    inline double ray_distance(dvec origin, dvec dir, const segment_type& segment)
+    {
+        auto a = to_double(segment.a), b = to_double(segment.b);
+        auto edge = b - a;
+        auto denominator = geometry::cross(dir, edge);
+        if (denominator == 0)
+            return std::numeric_limits<double>::infinity();
+        auto t = geometry::cross(a - origin, edge) / denominator;
+        auto s = geometry::cross(a - origin, dir) / denominator;
+        return t >= 0 && s >= 0 && s <= 1 ? t : std::numeric_limits<double>::infinity();
+    }
+
+    /** Check whether a point is in a wedge. The wedge goes clockwise from 
+     * the start direction to the end direction and it can be reflex.
+     * @param apex apex of the wedge
+     * @param start direction of the first boundary ray
+     * @param end direction of the last boundary ray
+     * @param point 
+     * @return true iff the point is in the wedge (or on its boundary)
+     */
+    inline bool wedge_contains(dvec apex, dvec start, dvec end, dvec point)
+    {
+        auto v = point - apex;
+        auto after_start = geometry::cross(start, v) <= 0;
+        auto before_end = geometry::cross(end, v) >= 0;
+        if (geometry::cross(start, end) > 0)
+            return after_start || before_end;
+        return after_start && before_end && geometry::dot(start + end, v) >= 0;
+    }
+
+    /** Compute distance from a point to the nearest edge of a polygon in a
+     * direction. Edges which contain the point are ignored.
+     * @param origin point inside the polygon
+     * @param dir direction of the ray (unit vector)
+     * @param polygon vertices of the polygon
+     * @return distance or infinity if the ray does not hit any edge
+     */
+    inline double polygon_ray_distance(
+        vector_type origin,
+        dvec dir,
+        const std::vector<vector_type>& polygon)
+    {
+        auto result = std::numeric_limits<double>::infinity();
+        for (std::size_t i = 0; i < polygon.size(); ++i)
+        {
+            auto a = polygon[i], b = polygon[(i + 1) % polygon.size()];
+            auto ax = static_cast<double>(a.x) - origin.x;
+            auto ay = static_cast<double>(a.y) - origin.y;
+            auto ex = static_cast<double>(b.x) - a.x;
+            auto ey = static_cast<double>(b.y) - a.y;
+            auto denominator = dir.x * ey - dir.y * ex;
+            if (denominator == 0)
+                continue;
+            auto t = (ax * ey - ay * ex) / denominator;
+            auto s = (ax * dir.y - ay * dir.x) / denominator;
+            if (t > 1e-4 && s >= -1e-6 && s <= 1 + 1e-6)
+                result = std::min(result, t);
+        }
+        return result;
+    }
+}
+
+#endif // TESTS_SCENES_HPP_
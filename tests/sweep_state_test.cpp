@@ -0,0 +1,103 @@
+#include "catch.hpp"
+
+#include <set>
+#include <random>
+#include <functional>
+#include <vector>
+
+#include <visibility/sweep_state.hpp>
+
+template<typename State>
+void test_state_against_std_set(
+    unsigned seed, 
+    int max_value, 
+    int operations, 
+    int initial_size = 0)
+{
+    State state{ std::less<int>{} };
+    std::set<int> expected;
+    std::mt19937 engine{ seed };
+    std::uniform_int_distribution<int> value{ 0, max_value };
+    std::uniform_int_distribution<int> action{ 0, 3 };
+
+    // build the initial state at once
+    for (int i = 0; i < initial_size; ++i)
+        expected.insert(value(engine));
+    std::vector<int> initial(expected.begin(), expected.end());
+    state.assign_sorted(initial.begin(), initial.end());
+    REQUIRE(state.size() == expected.size());
+
+    for (int i = 0; i < operations; ++i)
+    {
+        auto item = value(engine);
+        auto type = action(engine);
+        if (type < 2 || expected.size() < 4)
+        {
+            REQUIRE(state.insert(item) == expected.insert(item).second);
+        }
+        else if (type == 2)
+        {
+            REQUIRE(state.erase(item) == expected.erase(item));
+        }
+        else
+        {
+            REQUIRE(state.erase_id(item) == expected.erase(item));
+        }
+
+        REQUIRE(state.size() == expected.size());
+        REQUIRE(state.empty() == expected.empty());
+        if (!expected.empty())
+            REQUIRE(state.front() == *expected.begin());
+    }
+
+    // remove everything
+    while (!expected.empty())
+    {
+        REQUIRE(state.front() == *expected.begin());
+        REQUIRE(state.erase_id(state.front()) == 1);
+        expected.erase(expected.begin());
+        REQUIRE(state.size() == expected.size());
+    }
+    REQUIRE(state.empty());
+
+    // the state is usable after a reset
+    state.insert(5);
+    state.reset(std::less<int>{});
+    REQUIRE(state.erase_id(5) == 0);
+    REQUIRE(state.insert(3));
+    REQUIRE_FALSE(state.insert(3));
+    REQUIRE(state.insert(1));
+    REQUIRE(state.front() == 1);
+}
+
+template<typename State>
+void test_state()
+{
+    test_state_against_std_set<State>(1, 20, 500);
+    test_state_against_std_set<State>(2, 1000, 5000);
+    test_state_against_std_set<State>(3, 100000, 20000);
+    test_state_against_std_set<State>(4, 100, 500, 1);
+    test_state_against_std_set<State>(5, 100, 500, 31);
+    test_state_against_std_set<State>(6, 10000, 5000, 1000);
+    test_state_against_std_set<State>(7, 100000, 20000, 20000);
+}
+
+TEST_CASE("Tree sweep state behaves like an ordered set", "[sweep_state]")
+{
+    test_state<geometry::tree_state<int, std::less<int>>>();
+}
+
+TEST_CASE("Flat sweep state behaves like an ordered set", "[sweep_state]")
+{
+    test_state<geometry::flat_state<int, std::less<int>>>();
+}
+
+TEST_CASE("B-tree sweep state behaves like an ordered set", "[sweep_state]")
+{
+    test_state<geometry::btree_state<int, std::less<int>>>();
+}
+
+TEST_CASE("Adaptive sweep state behaves like an ordered set", "[sweep_state]")
+{
+    test_state<geometry::adaptive_state<int, std::less<int>>>();
+}
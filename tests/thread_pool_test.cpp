@@ -0,0 +1,70 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <visibility/thread_pool.hpp>
+
+void test_parallel_for(std::size_t threads, std::size_t count, std::size_t grain)
+{
+    geometry::thread_pool pool{ threads };
+    REQUIRE(pool.size() == threads);
+
+    for (int run = 0; run < 3; ++run)
+    {
+        std::vector<std::atomic<int>> visits(count);
+        for (auto&& visit : visits)
+            visit = 0;
+        std::atomic<bool> valid_worker{ true };
+
+        pool.parallel_for(count, grain, [&](
+            std::size_t worker, 
+            std::size_t first, 
+            std::size_t last)
+        {
+            if (worker >= threads || last - first > grain || first >= last)
+                valid_worker = false;
+
+            // make the cost of iterations uneven
+            volatile std::size_t sink = 0;
+            for (auto i = first; i < last; ++i)
+            {
+                for (std::size_t j = 0; j < (i % 7 == 0 ? 10000 : 10); ++j)
+                    sink = sink + j;
+                ++visits[i];
+            }
+        });
+
+        REQUIRE(valid_worker);
+        for (auto&& visit : visits)
+            REQUIRE(visit == 1);
+    }
+}
+
+TEST_CASE("Parallel loop visits every iteration once", "[thread_pool]")
+{
+    test_parallel_for(1, 100, 1);
+    test_parallel_for(2, 0, 1);
+    test_parallel_for(3, 1000, 1);
+    test_parallel_for(4, 1000, 16);
+    test_parallel_for(8, 5, 1);
+}
+
+TEST_CASE("Exception in parallel loop is rethrown", "[thread_pool]")
+{
+    geometry::thread_pool pool{ 4 };
+    REQUIRE_THROWS_AS(pool.parallel_for(100, 1, [](std::size_t, std::size_t first, std::size_t)
+    {
+        if (first == 42)
+            throw std::runtime_error{ "error" };
+    }), std::runtime_error);
+
+    // the pool can be used after an exception
+    std::atomic<std::size_t> count{ 0 };
+    pool.parallel_for(100, 1, [&](std::size_t, std::size_t first, std::size_t last)
+    {
+        count += last - first;
+    });
+    REQUIRE(count == 100);
+}
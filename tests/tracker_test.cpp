@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/tracker.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+TEST_CASE("Tracker gives the same polygons as queries from scratch", "[tracker]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(5, 10);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_tracker<vector_type> tracker{ scene };
+
+    // random walk with steps of various lengths
+    std::mt19937 engine{ 6 };
+    for (float step : { 0.01f, 0.2f, 3.f })
+    {
+        std::uniform_real_distribution<float> move{ -step, step };
+        vector_type observer{ 50, 50 };
+        for (int i = 0; i < 100; ++i)
+        {
+            observer = observer + vector_type{ move(engine), move(engine) };
+            observer.x = std::min(std::max(observer.x, 0.f), 100.f);
+            observer.y = std::min(std::max(observer.y, 0.f), 100.f);
+
+            auto expected = visibility_polygon(scene, observer);
+            auto&& poly = tracker.update(observer);
+            REQUIRE(poly == expected);
+        }
+
+        if (step == 0.01f)
+        {
+            // small moves are repaired by the insertion sort
+            REQUIRE(tracker.rebuild_count() == 1);
+            REQUIRE(tracker.resort_count() == 0);
+        }
+    }
+    REQUIRE(tracker.update_count() == 300);
+    REQUIRE(tracker.rebuild_count() < tracker.update_count());
+}
+
+TEST_CASE("Tracker sorts the events from scratch after a large jump", "[tracker]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(7, 10);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_tracker<vector_type> tracker{ scene };
+
+    // jump between opposite corners of the scene so that most events 
+    // change their order
+    for (auto&& observer : { 
+        vector_type{ 0.5f, 0.5f }, 
+        vector_type{ 99.5f, 99.5f }, 
+        vector_type{ 0.5f, 99.5f },
+        vector_type{ 99.5f, 0.5f } })
+    {
+        auto expected = visibility_polygon(scene, observer);
+        REQUIRE(tracker.update(observer) == expected);
+    }
+    REQUIRE(tracker.rebuild_count() == 1);
+    REQUIRE(tracker.resort_count() > 0);
+}
+
+TEST_CASE("Tracker repairs the order of events which cross the positive y axis", "[tracker]")
+{
+    using namespace geometry;
+
+    std::vector<segment_type> segments{
+        { { -1, 2 }, { 1, 2 } },
+        { { 0, 3 }, { 2, 3 } },
+        { { -2, 4 }, { 0.5f, 4 } },
+        { { -5, -5 }, { 5, -5 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_tracker<vector_type> tracker{ scene };
+
+    // move along a horizontal line below all horizontal line segments so
+    // that the observer never crosses a supporting line
+    for (float x = -0.9f; x < 0.9f; x += 0.05f)
+    {
+        vector_type observer{ x, 0 };
+        auto expected = visibility_polygon(scene, observer);
+        REQUIRE(tracker.update(observer) == expected);
+    }
+    REQUIRE(tracker.rebuild_count() == 1);
+
+    // crossing a supporting line flips the line segment in place
+    vector_type observer{ 0, 2.5f };
+    REQUIRE(tracker.update(observer) == visibility_polygon(scene, observer));
+    REQUIRE(tracker.rebuild_count() == 1);
+
+    // a line segment collinear with the observer triggers a rebuild
+    observer = vector_type{ 0, 3 };
+    REQUIRE(tracker.update(observer) == visibility_polygon(scene, observer));
+    REQUIRE(tracker.rebuild_count() == 2);
+
+    // invalidate() forces a rebuild
+    observer = vector_type{ 0, 2.5f };
+    tracker.invalidate();
+    REQUIRE(tracker.update(observer) == visibility_polygon(scene, observer));
+    REQUIRE(tracker.rebuild_count() == 3);
+}
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/triangulation.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+using triangulation_type = geometry::constrained_triangulation<vector_type>;
+
+namespace
+{
+    // relative distance of d inside of the circumcircle of a counterclockwise
+    // triangle abc (positive inside)
+    double in_circle(vector_type a, vector_type b, vector_type c, vector_type d)
+    {
+        double ax = a.x - d.x, ay = a.y - d.y;
+        double bx = b.x - d.x, by = b.y - d.y;
+        double cx = c.x - d.x, cy = c.y - d.y;
+        auto a_lift = ax * ax + ay * ay;
+        auto b_lift = bx * bx + by * by;
+        auto c_lift = cx * cx + cy * cy;
+        auto bc = bx * cy - by * cx, ca = cx * ay - cy * ax, ab = ax * by - ay * bx;
+        auto det = a_lift * bc + b_lift * ca + c_lift * ab;
+        return det / (a_lift * std::abs(bc) + b_lift * std::abs(ca) + c_lift * std::abs(ab));
+    }
+
+    // check that the triangulation is valid and contains the line segments
+    void check_triangulation(
+        const geometry::visibility_scene<vector_type>& scene,
+        const triangulation_type& triangulation)
+    {
+        auto&& vertices = triangulation.vertices();
+        auto&& triangles = triangulation.triangles();
+        REQUIRE(vertices.size() == scene.vertices().size() + 4);
+        REQUIRE(triangles.size() == 2 * vertices.size() - 6);
+
+        std::vector<std::vector<std::uint32_t>> constrained(vertices.size());
+        for (std::uint32_t i = 0; i < triangles.size(); ++i)
+        {
+            auto&& item = triangles[i];
+            REQUIRE(tests::orient(
+                vertices[item.vertices[0]],
+                vertices[item.vertices[1]],
+                vertices[item.vertices[2]]) > 0);
+            for (std::uint32_t k = 0; k < 3; ++k)
+            {
+                auto a = item.vertices[triangulation_type::next(k)];
+                auto b = item.vertices[triangulation_type::prev(k)];
+                auto neighbor = item.neighbors[k];
+                if (neighbor == triangulation_type::none)
+                {
+                    REQUIRE(item.is_constrained(k));
+                    continue;
+                }
+
+                // the neighbor has the same edge in the opposite direction
+                auto&& other = triangles[neighbor];
+                auto edge = triangulation_type::neighbor_edge(other, i);
+                REQUIRE(other.neighbors[edge] == i);
+                REQUIRE(other.vertices[triangulation_type::next(edge)] == b);
+                REQUIRE(other.vertices[triangulation_type::prev(edge)] == a);
+                REQUIRE(other.is_constrained(edge) == item.is_constrained(k));
+                if (item.is_constrained(k))
+                    constrained[a].push_back(b);
+            }
+        }
+
+        for (auto&& record : scene.records())
+        {
+            auto&& list = constrained[record.a];
+            REQUIRE(std::find(list.begin(), list.end(), record.b) != list.end());
+        }
+    }
+}
+
+TEST_CASE("Triangulation contains line segments as constrained edges", "[triangulation]")
+{
+    using namespace geometry;
+
+    for (unsigned seed = 1; seed <= 5; ++seed)
+    {
+        auto segments = tests::make_scene(seed, 15);
+        visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+        triangulation_type triangulation{ scene };
+        check_triangulation(scene, triangulation);
+    }
+
+    auto rooms = tests::make_rooms(12, 1, true, false);
+    visibility_scene<vector_type> scene{ rooms.begin(), rooms.end() };
+    triangulation_type triangulation{ scene };
+    check_triangulation(scene, triangulation);
+}
+
+TEST_CASE("Unconstrained edges of the triangulation are Delaunay", "[triangulation]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(7, 15);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    triangulation_type triangulation{ scene };
+    auto&& vertices = triangulation.vertices();
+    auto&& triangles = triangulation.triangles();
+    for (std::uint32_t i = 0; i < triangles.size(); ++i)
+    {
+        auto&& item = triangles[i];
+        for (std::uint32_t k = 0; k < 3; ++k)
+        {
+            if (item.is_constrained(k))
+                continue;
+
+            // the opposite vertex of the neighbor is not in the circumcircle
+            auto&& other = triangles[item.neighbors[k]];
+            auto d = vertices[other.vertices[triangulation_type::neighbor_edge(other, i)]];
+            REQUIRE(in_circle(
+                vertices[item.vertices[0]],
+                vertices[item.vertices[1]],
+                vertices[item.vertices[2]],
+                d) <= 1e-9);
+        }
+    }
+}
+
+TEST_CASE("Triangulation finds the triangle which contains a point", "[triangulation]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(9, 10);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    triangulation_type triangulation{ scene };
+    auto&& vertices = triangulation.vertices();
+
+    std::mt19937 engine{ 10 };
+    std::uniform_real_distribution<float> coord{ -50, 150 };
+    for (int i = 0; i < 1000; ++i)
+    {
+        vector_type point{ coord(engine), coord(engine) };
+        auto index = triangulation.locate(point);
+        REQUIRE(index != triangulation_type::none);
+        auto&& item = triangulation.triangles()[index];
+        for (std::uint32_t k = 0; k < 3; ++k)
+        {
+            REQUIRE(tests::orient(
+                vertices[item.vertices[triangulation_type::next(k)]],
+                vertices[item.vertices[triangulation_type::prev(k)]],
+                point) >= 0);
+        }
+    }
+
+    REQUIRE(triangulation.locate(vector_type{ 1e6f, 0 }) == triangulation_type::none);
+}
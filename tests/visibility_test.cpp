@@ -1,5 +1,12 @@
 #include "catch.hpp"
 
+#include <random>
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "scenes.hpp"
+
 #include <visibility/visibility.hpp>
 
 using vector_type = geometry::vec2;
@@ -7,6 +14,144 @@ using segment_type = geometry::line_segment<vector_type>;
 using segment_comparer_type = geometry::line_segment_dist_comparer<vector_type>;
 using angle_comparer_type = geometry::angle_comparer<vector_type>;
 
+namespace
+{
+    /* The original sweep with a std::set of line segments ordered by 
+     * line_segment_dist_comparer and events sorted by angle_comparer. It 
+     * shares no code with the workspace pipeline so it is an independent 
+     * oracle of its results.
+     */
+    std::vector<vector_type> reference_polygon(
+        vector_type point, 
+        const std::vector<segment_type>& segments)
+    {
+        using namespace geometry;
+
+        struct event
+        {
+            bool is_end_vertex;
+            segment_type segment;
+
+            vector_type point() const { return segment.a; }
+        };
+
+        segment_comparer_type cmp_dist{ point };
+        std::set<segment_type, segment_comparer_type> state{ cmp_dist };
+        std::vector<event> events;
+        for (auto&& segment : segments)
+        {
+            auto pab = compute_orientation(point, segment.a, segment.b);
+            if (pab == orientation::collinear)
+                continue;
+            segment_type start = segment, end{ segment.b, segment.a };
+            if (pab == orientation::left_turn)
+                std::swap(start, end);
+            events.push_back({ false, start });
+            events.push_back({ true, end });
+
+            auto a = segment.a, b = segment.b;
+            if (a.x > b.x) 
+                std::swap(a, b);
+            if (compute_orientation(a, b, point) == orientation::right_turn && 
+                (approx_equal(b.x, point.x) || (a.x < point.x && point.x < b.x)))
+            {
+                state.insert(segment);
+            }
+        }
+
+        angle_comparer_type cmp_angle{ point };
+        std::sort(events.begin(), events.end(), [&cmp_angle](auto&& a, auto&& b) 
+        {
+            if (approx_equal(a.point(), b.point()))
+                return a.is_end_vertex && !b.is_end_vertex;
+            return cmp_angle(a.point(), b.point());
+        });
+
+        std::vector<vector_type> vertices;
+        for (auto&& e : events)
+        {
+            if (e.is_end_vertex) 
+                state.erase(e.segment);
+
+            if (state.empty())
+            {
+                vertices.push_back(e.point());
+            }
+            else if (cmp_dist(e.segment, *state.begin()))
+            {
+                vector_type intersection;
+                ray<vector_type> ray{ point, e.point() - point };
+                ray.intersects(*state.begin(), intersection);
+                if (e.is_end_vertex)
+                {
+                    vertices.push_back(e.point());
+                    vertices.push_back(intersection);
+                }
+                else
+                {
+                    vertices.push_back(intersection);
+                    vertices.push_back(e.point());
+                }
+            }
+
+            if (!e.is_end_vertex) 
+                state.insert(e.segment);
+        }
+
+        // remove collinear vertices
+        auto top = vertices.begin();
+        for (auto it = vertices.begin(); it != vertices.end(); ++it)
+        {
+            auto prev = top == vertices.begin() ? vertices.end() - 1 : top - 1;
+            auto next = it + 1 == vertices.end() ? vertices.begin() : it + 1;
+            if (compute_orientation(*prev, *it, *next) != orientation::collinear) 
+                *top++ = *it;
+        }
+        vertices.erase(top, vertices.end());
+        return vertices;
+    }
+
+    // scenes with random line segments and with closed rooms (collinear 
+    // walls and common endpoints) and random observers in them
+    struct reference_scene
+    {
+        std::vector<segment_type> segments;
+        std::vector<vector_type> observers;
+    };
+
+    std::vector<reference_scene> make_reference_scenes()
+    {
+        std::vector<reference_scene> scenes{
+            { tests::make_scene(11, 8), {} },
+            { tests::make_rooms(6, 0.5, false, true, 12), {} },
+        };
+        std::mt19937 engine{ 13 };
+        std::uniform_real_distribution<float> coord{ 1, 59 };
+        for (auto&& scene : scenes)
+        {
+            for (int i = 0; i < 40; ++i)
+                scene.observers.emplace_back(coord(engine), coord(engine));
+        }
+        return scenes;
+    }
+
+    // intersections of the oracle are computed in float, the pipeline
+    // computes them in double
+    void require_reference_polygon(
+        vector_type observer,
+        const std::vector<segment_type>& segments,
+        const std::vector<vector_type>& poly)
+    {
+        auto expected = reference_polygon(observer, segments);
+        REQUIRE(poly.size() == expected.size());
+        for (std::size_t i = 0; i < poly.size(); ++i)
+        {
+            REQUIRE(poly[i].x == Approx(expected[i].x).margin(1e-3));
+            REQUIRE(poly[i].y == Approx(expected[i].y).margin(1e-3));
+        }
+    }
+}
+
 void test_line_segment_is_closer(
     const segment_comparer_type& cmp,
     vector_type a, vector_type b,
@@ -57,6 +202,122 @@ TEST_CASE("Compare 2 line segments with common endpoints", "[visibility][dist_co
     test_line_segment_is_closer(cmp, { 2, 1 }, { 2, 0 }, { 2, 0 }, { 3, 1 });
 }
 
+// prepare line segments for prepared_segment_comparer and weld their endpoints
+std::vector<geometry::prepared_segment> prepare_segments(
+    vector_type origin, 
+    std::vector<segment_type> segments)
+{
+    using namespace geometry;
+
+    std::vector<vector_type> vertices;
+    auto weld = [&](vector_type point)
+    {
+        auto it = std::find_if(vertices.begin(), vertices.end(), [point](auto&& vertex) 
+        {
+            return approx_equal(vertex, point);
+        });
+        if (it == vertices.end())
+            it = vertices.insert(vertices.end(), point);
+        return static_cast<std::uint32_t>(it - vertices.begin());
+    };
+
+    std::vector<prepared_segment> result;
+    for (auto&& segment : segments)
+    {
+        if (compute_orientation(origin, segment.a, segment.b) == orientation::left_turn)
+            std::swap(segment.a, segment.b);
+        prepared_segment prepared;
+        prepared.start = weld(segment.a);
+        prepared.end = weld(segment.b);
+        prepared.a = relative_position(origin, vertices[prepared.start]);
+        prepared.b = relative_position(origin, vertices[prepared.end]);
+        prepared.dir = prepared.b - prepared.a;
+        result.push_back(prepared);
+    }
+    return result;
+}
+
+// compare line segments using both comparers in both orders
+void test_prepared_comparer(vector_type origin, segment_type x, segment_type y)
+{
+    segment_comparer_type cmp{ origin };
+    auto prepared = prepare_segments(origin, { x, y });
+    geometry::prepared_segment_comparer prepared_cmp{ prepared.data() };
+    REQUIRE(prepared_cmp(0, 1) == cmp(x, y));
+    REQUIRE(prepared_cmp(1, 0) == cmp(y, x));
+}
+
+TEST_CASE("Prepared comparer gives the same results as the line segment comparer", "[visibility][dist_comp]")
+{
+    vector_type origin{ 0, 0 };
+    test_prepared_comparer(origin, { { 1, 1 }, { 1, -1 } }, { { 2, 1 }, { 2, -1 } });
+    test_prepared_comparer(origin, { { 1, 1 }, { 1, -1 } }, { { 2, 2 }, { 2, 3 } });
+    test_prepared_comparer(origin, { { 1, 1 }, { 1, 0 } }, { { 1, 0 }, { 1, -1 } });
+    test_prepared_comparer(origin, { { 1, 1 }, { 1, 0 } }, { { 1, 0 }, { 1, 1 } });
+    test_prepared_comparer(origin, { { 2, 0 }, { 1, 1 } }, { { 2, 1 }, { 2, 0 } });
+    test_prepared_comparer(origin, { { 2, 1 }, { 2, 0 } }, { { 2, 0 }, { 3, 1 } });
+
+    // random line segments which do not intersect and which are 
+    // intersected by a common ray from the origin
+    std::mt19937 engine{ 7 };
+    std::uniform_real_distribution<float> coord{ -100, 100 };
+    auto random_point = [&]() { return vector_type{ coord(engine), coord(engine) }; };
+    auto in_wedge = [&](segment_type segment, vector_type point)
+    {
+        using namespace geometry;
+        if (compute_orientation(origin, segment.a, segment.b) == orientation::left_turn)
+            std::swap(segment.a, segment.b);
+        return compute_orientation(origin, segment.a, point) != orientation::left_turn &&
+            compute_orientation(origin, point, segment.b) != orientation::left_turn;
+    };
+    auto intersect = [](segment_type x, segment_type y)
+    {
+        using namespace geometry;
+        return compute_orientation(x.a, x.b, y.a) != compute_orientation(x.a, x.b, y.b) &&
+            compute_orientation(y.a, y.b, x.a) != compute_orientation(y.a, y.b, x.b);
+    };
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        segment_type x{ random_point(), random_point() };
+        segment_type y{ random_point(), random_point() };
+        if (geometry::compute_orientation(origin, x.a, x.b) == geometry::orientation::collinear ||
+            geometry::compute_orientation(origin, y.a, y.b) == geometry::orientation::collinear ||
+            intersect(x, y) ||
+            !(in_wedge(x, y.a) || in_wedge(x, y.b) || in_wedge(y, x.a) || in_wedge(y, x.b)))
+            continue;
+        test_prepared_comparer(origin, x, y);
+    }
+}
+
+TEST_CASE("Sort line segments intersected by the vertical ray", "[visibility][initial_state]")
+{
+    using namespace geometry;
+
+    vector_type origin{ 0, 0 };
+    std::vector<segment_type> segments{
+        { { -1, 3 }, { 1, 3 } },
+        { { -1, 1 }, { 0, 2 } }, // common endpoint on the ray
+        { { -1, 1 }, { 1, 1 } },
+        { { -1, 3 }, { 0, 2 } },
+        { { -1, 3 }, { 1, 3 } }, // duplicate
+        { { -2, 4 }, { 3, 5 } },
+    };
+    auto prepared = prepare_segments(origin, segments);
+
+    visibility_events state, buffer;
+    for (std::uint32_t i = 0; i < segments.size(); ++i)
+        state.push_back(vertical_distance_key(origin, segments[i]), i);
+    sort_initial_state(prepared.data(), state, buffer);
+
+    REQUIRE(state.size() == 5);
+    REQUIRE(state.refs[0] == 2);
+    REQUIRE(state.refs[1] == 1);
+    REQUIRE(state.refs[2] == 3);
+    REQUIRE((state.refs[3] == 0 || state.refs[3] == 4));
+    REQUIRE(state.refs[4] == 5);
+}
+
 TEST_CASE("Compare angle with 2 points in general position", "[visibility][angle_comp]")
 {
     angle_comparer_type cmp{ { 0, 0 } };
@@ -85,6 +346,88 @@ TEST_CASE("Compare angle with 2 points if they are collinear with the origin", "
     REQUIRE_FALSE(cmp({ 0, 0 }, { 0, 0 }));
 }
 
+void test_angle_key_order(vector_type origin, std::vector<vector_type> points)
+{
+    angle_comparer_type cmp{ origin };
+    auto expected = points;
+    std::sort(expected.begin(), expected.end(), cmp);
+    std::sort(points.begin(), points.end(), [origin](auto&& a, auto&& b)
+    {
+        return geometry::angle_key(origin, a) < geometry::angle_key(origin, b);
+    });
+
+    // points which are equivalent in the comparer can be in any order
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        REQUIRE_FALSE(cmp(points[i], expected[i]));
+        REQUIRE_FALSE(cmp(expected[i], points[i]));
+    }
+}
+
+TEST_CASE("Angle keys order points on a lattice as the angle comparer", "[visibility][angle_key]")
+{
+    std::vector<vector_type> points;
+    for (int x = -5; x <= 5; ++x)
+    {
+        for (int y = -5; y <= 5; ++y)
+        {
+            if (x != 0 || y != 0)
+                points.emplace_back(static_cast<float>(x), static_cast<float>(y));
+        }
+    }
+
+    test_angle_key_order({ 0, 0 }, points);
+    test_angle_key_order({ 1, 2 }, points);
+    test_angle_key_order({ -3, 1 }, points);
+}
+
+TEST_CASE("Angle keys order random points as the angle comparer", "[visibility][angle_key]")
+{
+    std::mt19937 engine{ 7 };
+    std::uniform_real_distribution<float> coord{ -100, 100 };
+    std::vector<vector_type> points;
+    for (int i = 0; i < 1000; ++i)
+        points.emplace_back(coord(engine), coord(engine));
+
+    test_angle_key_order({ 0, 0 }, points);
+    test_angle_key_order({ 12.5f, -3.25f }, points);
+}
+
+TEST_CASE("Line segment whose endpoints have the same pseudo-angle", "[visibility][angle_key]")
+{
+    using namespace geometry;
+
+    // the line segment is almost collinear with the observer so its 
+    // endpoints have the same pseudo-angle in float precision
+    vector_type observer{ 150.50032f, 150.500092f };
+    segment_type segment{ { 67.4191437f, 256.278351f }, { 65.5564804f, 258.649811f } };
+    std::vector<segment_type> segments{
+        { { 0, 0 },{ 0, 300 } },
+        { { 0, 300 },{ 300, 300 } },
+        { { 300, 300 },{ 300, 0 } },
+        { { 300, 0 },{ 0, 0 } },
+        segment,
+    };
+
+    auto turn = compute_orientation(observer, segment.a, segment.b);
+    REQUIRE(turn != orientation::collinear);
+    if (turn == orientation::left_turn)
+        std::swap(segment.a, segment.b);
+    auto start_key = angle_key(observer, segment.a);
+    auto end_key = angle_key(observer, segment.b);
+    REQUIRE((start_key >> 32) == (end_key >> 32));
+    REQUIRE(start_key < end_event_key(start_key, end_key));
+
+    // the line segment does not stay in the state after its end vertex
+    auto&& poly = visibility_polygon(observer, segments.begin(), segments.end());
+    REQUIRE(poly.size() >= 4);
+    for (auto&& corner : { vector_type{ 0, 0 }, vector_type{ 300, 0 }, vector_type{ 300, 300 } })
+        REQUIRE(std::find_if(poly.begin(), poly.end(), [corner](vector_type v)
+        {
+            return approx_equal(v, corner);
+        }) != poly.end());
+}
+
 TEST_CASE("Calculate visibility polygon with no line segments", "[visibility]")
 {
     std::vector<segment_type> segments;
@@ -182,4 +525,188 @@ TEST_CASE("Calculate visibility polygon with a concave polygon as an obstacle",
     REQUIRE(approx_equal(poly[4], { -250, -250 }));
     REQUIRE(approx_equal(poly[5], { -250, 250 }));
     REQUIRE(approx_equal(poly[6], { -50, 50 }));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Reuse workspace for multiple visibility polygon queries", "[visibility][workspace]")
+{
+    using namespace geometry;
+    std::vector<segment_type> segments{
+        { { -250, -250 },{ -250, 250 } },
+        { { -250, 250 },{ 250, 250 } },
+        { { 250, 250 },{ 250, -250 } },
+        { { 250, -250 },{ -250, -250 } },
+
+        { { -50, 50 },{ 0, 100 } },
+        { { 0, 100 }, { 50, 50 } },
+        { { 50, 50 },{ 0, 200 } },
+        { { 0, 200 },{ -50, 50 } },
+    };
+    std::vector<vector_type> observers{
+        { 0, 0 }, { 100, 100 }, { -200, 10 }, { 0, 0 }, { 10, -150 }
+    };
+
+    visibility_workspace<vector_type> workspace;
+    for (auto&& observer : observers)
+    {
+        auto&& poly = visibility_polygon(observer, segments.begin(), segments.end(), workspace);
+        require_reference_polygon(observer, segments, poly);
+    }
+
+    // one workspace for scenes of different sizes
+    for (auto&& scene : make_reference_scenes())
+    {
+        for (auto&& observer : scene.observers)
+        {
+            auto&& poly = visibility_polygon(
+                observer, scene.segments.begin(), scene.segments.end(), workspace);
+            require_reference_polygon(observer, scene.segments, poly);
+        }
+    }
+}
+
+TEST_CASE("Radix sort of events gives the same visibility polygon", "[visibility][radix_sort]")
+{
+    using namespace geometry;
+
+    // segments in cells of a grid enclosed in a bounding box
+    std::mt19937 engine{ 5 };
+    std::uniform_real_distribution<float> offset{ 1, 9 };
+    std::vector<segment_type> segments{
+        { { -10, -10 },{ -10, 210 } },
+        { { -10, 210 },{ 210, 210 } },
+        { { 210, 210 },{ 210, -10 } },
+        { { 210, -10 },{ -10, -10 } },
+    };
+    for (int i = 0; i < 20; ++i)
+    {
+        for (int j = 0; j < 20; ++j)
+        {
+            vector_type corner{ i * 10.f, j * 10.f };
+            segments.emplace_back(
+                corner + vector_type{ offset(engine), offset(engine) },
+                corner + vector_type{ offset(engine), offset(engine) });
+        }
+    }
+
+    visibility_workspace<vector_type> comparison, radix;
+    comparison.sort = event_sort::comparison;
+    radix.sort = event_sort::radix;
+    for (auto&& observer : { vector_type{ 100, 100 }, vector_type{ 3, 151 } })
+    {
+        auto&& expected = visibility_polygon(observer, segments.begin(), segments.end(), comparison);
+        auto&& poly = visibility_polygon(observer, segments.begin(), segments.end(), radix);
+        REQUIRE(poly.size() == expected.size());
+        for (std::size_t i = 0; i < poly.size(); ++i)
+            REQUIRE(approx_equal(poly[i], expected[i]));
+    }
+}
+
+TEST_CASE("Ray through a vertex almost collinear with an endpoint of the nearest line segment", "[visibility][precision]")
+{
+    using namespace geometry;
+
+    // the ray through the end vertex of the second line segment passes 
+    // the end vertex of the first one (in float precision, it misses it)
+    vector_type observer{ 150.593857f, 150.528152f };
+    std::vector<segment_type> segments{
+        { { 50, 50 },{ 50, 250 } },
+        { { 50, 250 },{ 250, 250 } },
+        { { 250, 250 },{ 250, 50 } },
+        { { 250, 50 },{ 50, 50 } },
+        { { 143.390625f, 72.9977417f },{ 143.504807f, 76.2064667f } },
+        { { 148.680756f, 103.511917f },{ 146.152695f, 103.967033f } },
+    };
+
+    auto&& poly = visibility_polygon(observer, segments.begin(), segments.end());
+    REQUIRE(poly.size() >= 4);
+    for (auto&& vertex : poly)
+    {
+        REQUIRE(vertex.x >= 49.99f);
+        REQUIRE(vertex.x <= 250.01f);
+        REQUIRE(vertex.y >= 49.99f);
+        REQUIRE(vertex.y <= 250.01f);
+    }
+}
+
+TEST_CASE("Write visibility polygon to an output iterator", "[visibility][output]")
+{
+    using namespace geometry;
+
+    // the top edge is split at the vertical ray from the observer
+    std::vector<segment_type> segments{
+        { { -250, 250 },{ 0, 250 } },
+        { { 0, 250 },{ 250, 250 } },
+        { { 250, 250 },{ 250, -250 } },
+        { { 250, -250 },{ 0, -250 } },
+        { { 0, -250 },{ -250, -250 } },
+        { { -250, -250 },{ -250, 250 } },
+
+        { { -50, 50 },{ 50, 50 } },
+        { { 50, 100 },{ 50, 150 } },
+    };
+
+    visibility_workspace<vector_type> workspace;
+    for (auto&& observer : { vector_type{ 0, 0 }, vector_type{ 0, 100 }, vector_type{ 100, -50 } })
+    {
+        std::vector<vector_type> poly;
+        auto out = visibility_polygon(
+            observer, segments.begin(), segments.end(), workspace, std::back_inserter(poly));
+        *out = vector_type{ 0, 0 }; // the returned iterator is usable
+        poly.pop_back();
+
+        require_reference_polygon(observer, segments, poly);
+        for (std::size_t i = 0; i < poly.size(); ++i)
+        {
+            auto&& prev = poly[i == 0 ? poly.size() - 1 : i - 1];
+            auto&& next = poly[(i + 1) % poly.size()];
+            REQUIRE(compute_orientation(prev, poly[i], next) != orientation::collinear);
+        }
+    }
+
+    for (auto&& scene : make_reference_scenes())
+    {
+        for (auto&& observer : scene.observers)
+        {
+            std::vector<vector_type> poly;
+            visibility_polygon(
+                observer, scene.segments.begin(), scene.segments.end(), 
+                workspace, std::back_inserter(poly));
+            require_reference_polygon(observer, scene.segments, poly);
+        }
+    }
+}
+
+TEST_CASE("Pass vertices of visibility polygon to a sink", "[visibility][output]")
+{
+    using namespace geometry;
+
+    std::vector<segment_type> segments{
+        { { -250, 250 },{ 250, 250 } },
+        { { 250, 250 },{ 250, -250 } },
+        { { 250, -250 },{ -250, -250 } },
+        { { -250, -250 },{ -250, 250 } },
+    };
+
+    visibility_workspace<vector_type> workspace;
+    std::vector<vector_type> poly;
+    visit_visibility_polygon(vector_type{ 0, 0 }, segments.begin(), segments.end(), workspace,
+        [&poly](vector_type vertex) { poly.push_back(vertex); });
+
+    REQUIRE(poly.size() == 4);
+    REQUIRE(poly[0] == (vector_type{ 250, 250 }));
+    REQUIRE(poly[1] == (vector_type{ 250, -250 }));
+    REQUIRE(poly[2] == (vector_type{ -250, -250 }));
+    REQUIRE(poly[3] == (vector_type{ -250, 250 }));
+
+    for (auto&& scene : make_reference_scenes())
+    {
+        for (auto&& observer : scene.observers)
+        {
+            poly.clear();
+            visit_visibility_polygon(
+                observer, scene.segments.begin(), scene.segments.end(), workspace,
+                [&poly](vector_type vertex) { poly.push_back(vertex); });
+            require_reference_polygon(observer, scene.segments, poly);
+        }
+    }
+}
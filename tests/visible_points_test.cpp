@@ -0,0 +1,183 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/visible_points.hpp>
+#include <visibility/line_of_sight.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+TEST_CASE("Visible points agree with a test of all line segments", "[visible_points]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(53, 15);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    points_workspace<vector_type> workspace;
+
+    std::mt19937 engine{ 54 };
+    std::uniform_real_distribution<float> coord{ -15, 165 };
+    std::size_t visible_count = 0;
+    std::size_t target_count = 0;
+    for (int i = 0; i < 20; ++i)
+    {
+        vector_type observer{ coord(engine), coord(engine) };
+        std::vector<vector_type> targets;
+        for (int j = 0; j < 200; ++j)
+            targets.emplace_back(coord(engine), coord(engine));
+
+        std::vector<std::uint8_t> output;
+        visible_points(scene, observer, targets.begin(), targets.end(), workspace, output);
+        REQUIRE(output.size() == targets.size());
+        for (std::size_t j = 0; j < targets.size(); ++j)
+        {
+            auto expected = tests::crosses_no_segment(scene.segments(), observer, targets[j]);
+            REQUIRE((output[j] != 0) == expected);
+            visible_count += expected;
+        }
+        target_count += targets.size();
+    }
+    REQUIRE(visible_count > target_count / 20);
+    REQUIRE(visible_count < target_count - target_count / 20);
+}
+
+TEST_CASE("Visible points agree with line of sight queries", "[visible_points]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(51, 12);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    points_workspace<vector_type> workspace;
+
+    std::mt19937 engine{ 52 };
+    std::uniform_real_distribution<float> coord{ -5, 125 };
+    for (int i = 0; i < 50; ++i)
+    {
+        vector_type observer{ coord(engine), coord(engine) };
+        std::vector<vector_type> targets;
+        for (int j = 0; j < 500; ++j)
+            targets.emplace_back(coord(engine), coord(engine));
+
+        std::vector<std::uint8_t> output;
+        visible_points(scene, observer, targets.begin(), targets.end(), workspace, output);
+        REQUIRE(output.size() == targets.size());
+        for (std::size_t j = 0; j < targets.size(); ++j)
+            REQUIRE((output[j] != 0) == line_of_sight(scene, observer, targets[j]));
+    }
+}
+
+TEST_CASE("Visible points on one ray and outside of the scene", "[visible_points]")
+{
+    using namespace geometry;
+
+    // a room with a door in the right wall and a wall behind it
+    std::vector<segment_type> segments{
+        { { 0, 0 }, { 0, 10 } },
+        { { 0, 10 }, { 10, 10 } },
+        { { 10, 10 }, { 10, 6 } },
+        { { 10, 4 }, { 10, 0 } },
+        { { 10, 0 }, { 0, 0 } },
+        { { 20, -5 }, { 20, 15 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    std::vector<vector_type> targets{
+        { 5, 5 },   // the observer
+        { 8, 8 },
+        { 15, 5 },  // through the door
+        { 25, 5 },  // behind the wall
+        { 15, 3 },  // through the door post (10, 4)
+        { 15, 2 },  // behind the door post
+        { 5, -1 },  // outside of the room
+        { 5, 12 },
+        { 10, 2 },  // on a wall
+        { 5, 10 },
+    };
+    auto output = visible_points(scene, vector_type{ 5, 5 }, targets.begin(), targets.end());
+    std::vector<std::uint8_t> expected{ 1, 1, 1, 0, 1, 0, 0, 0, 1, 1 };
+    REQUIRE(output == expected);
+
+    // the results are appended to the output
+    points_workspace<vector_type> workspace;
+    std::vector<std::uint8_t> appended{ 7 };
+    visible_points(scene, vector_type{ 8, 8 }, targets.begin(), targets.end(), workspace, appended);
+    REQUIRE(appended.size() == targets.size() + 1);
+    REQUIRE(appended[0] == 7);
+    for (std::size_t i = 0; i < targets.size(); ++i)
+        REQUIRE((appended[i + 1] != 0) == line_of_sight(scene, vector_type{ 8, 8 }, targets[i]));
+}
+
+TEST_CASE("Visible points are hidden by a corner of a closed polygon", "[visible_points]")
+{
+    using namespace geometry;
+
+    // a box in a frame
+    std::vector<segment_type> segments{
+        { { 0, 0 }, { 2, 0 } },
+        { { 2, 0 }, { 2, 2 } },
+        { { 2, 2 }, { 0, 2 } },
+        { { 0, 2 }, { 0, 0 } },
+        { { -5, -5 }, { -5, 5 } },
+        { { -5, 5 }, { 5, 5 } },
+        { { 5, 5 }, { 5, -5 } },
+        { { 5, -5 }, { -5, -5 } },
+    };
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    points_workspace<vector_type> workspace;
+
+    // through a corner into the box, through the box and along its sides
+    std::vector<segment_type> pairs{
+        { { -1, -1 }, { 1, 1 } },
+        { { -1, -1 }, { 3, 3 } },
+        { { -1, 3 }, { 3, -1 } },
+        { { -1, 2 }, { 3, 2 } },
+        { { -1, 1 }, { 1, -1 } },
+        { { -1, 1 }, { 1, 3 } },
+        { { -1, -1 }, { 0, 0 } },
+        { { 2, 0 }, { 4, -2 } },
+    };
+    std::vector<std::uint8_t> expected{ 0, 0, 0, 1, 1, 1, 1, 1 };
+    for (std::size_t i = 0; i < pairs.size(); ++i)
+    {
+        std::vector<std::uint8_t> output;
+        visible_points(scene, pairs[i].a, &pairs[i].b, &pairs[i].b + 1, workspace, output);
+        REQUIRE(output[0] == expected[i]);
+        output.clear();
+        visible_points(scene, pairs[i].b, &pairs[i].a, &pairs[i].a + 1, workspace, output);
+        REQUIRE(output[0] == expected[i]);
+    }
+}
+
+TEST_CASE("Visible points are hidden by a wall which ends just past the line of sight", "[visible_points]")
+{
+    using namespace geometry;
+
+    // a wall perpendicular to the line of sight whose end is a small
+    // distance past the line of sight
+    vector_type observer{ 100, 100 };
+    vector_type target{ 300, 200 };
+    vector2<double> normal{ -1 / std::sqrt(5.0), 2 / std::sqrt(5.0) };
+    for (auto distance : { 7e-5, 1e-3 })
+    {
+        vector_type end{ 
+            static_cast<float>(200 + distance * normal.x), 
+            static_cast<float>(150 + distance * normal.y) };
+        vector_type start{ 
+            static_cast<float>(200 - 5 * normal.x), 
+            static_cast<float>(150 - 5 * normal.y) };
+        std::vector<segment_type> segments{ { start, end } };
+        visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+
+        auto output = visible_points(scene, observer, &target, &target + 1);
+        REQUIRE(!tests::crosses_no_segment(segments, observer, target));
+        REQUIRE(output[0] == 0);
+
+        // line_of_sight() treats an endpoint within the tolerance of
+        // line_equation::side() as touching the line of sight
+        REQUIRE(line_of_sight(scene, observer, target) == (distance < 1e-4));
+    }
+}
@@ -0,0 +1,74 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "scenes.hpp"
+
+#include <visibility/wedge.hpp>
+
+using vector_type = geometry::vec2;
+using segment_type = geometry::line_segment<vector_type>;
+
+namespace
+{
+    const double pi = 3.14159265358979323846;
+}
+
+TEST_CASE("Wedge query gives the visibility polygon in the field of view", "[wedge]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(11, 10);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+
+    std::mt19937 engine{ 12 };
+    std::uniform_real_distribution<float> coord{ 0, 100 };
+    std::uniform_real_distribution<double> angle{ 0, 2 * pi };
+    std::uniform_real_distribution<double> fraction{ -0.99, 0.99 };
+    for (int i = 0; i < 50; ++i)
+    {
+        vector_type observer{ coord(engine), coord(engine) };
+        std::vector<vector_type> full = visibility_polygon(scene, observer, workspace);
+        for (double half_angle : { 0.1, 0.5, 1.5, 2.5 })
+        {
+            auto axis = angle(engine);
+            vector_type direction{
+                static_cast<float>(std::sin(axis)),
+                static_cast<float>(std::cos(axis)) };
+            auto&& wedge = visibility_wedge(scene, observer, direction, half_angle, workspace);
+            REQUIRE(wedge.size() >= 3);
+            REQUIRE(wedge[0] == observer);
+
+            for (int j = 0; j < 20; ++j)
+            {
+                auto ray = axis + half_angle * fraction(engine);
+                vector2<double> dir{ std::sin(ray), std::cos(ray) };
+                auto expected = tests::polygon_ray_distance(observer, dir, full);
+                REQUIRE(tests::polygon_ray_distance(observer, dir, wedge) ==
+                    Approx(expected).epsilon(1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("Wedge query only sweeps events in the field of view", "[wedge]")
+{
+    using namespace geometry;
+
+    auto segments = tests::make_scene(13, 20);
+    visibility_scene<vector_type> scene{ segments.begin(), segments.end() };
+    visibility_workspace<vector_type> workspace;
+    vector_type observer{ 100, 100 };
+
+    visibility_polygon(scene, observer, workspace);
+    auto full_events = workspace.events.size();
+    visibility_wedge(scene, observer, vector_type{ 1, 0 }, pi / 8, workspace);
+    REQUIRE(workspace.events.size() < full_events / 4);
+
+    // the whole circle
+    std::vector<vector_type> full = visibility_polygon(scene, observer, workspace);
+    REQUIRE(visibility_wedge(scene, observer, vector_type{ 1, 0 }, pi, workspace) == full);
+}
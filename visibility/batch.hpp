@@ -0,0 +1,432 @@
+#ifndef GEOMETRY_BATCH_HPP_
+#define GEOMETRY_BATCH_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "scene.hpp"
+#include "thread_pool.hpp"
+
+namespace geometry
+{
+    /* List of polygons stored in one array of vertices.
+     * Vertices of the i-th polygon are in the range
+     * [offsets[i], offsets[i + 1]) of the vertices array.
+     */
+    template<typename Vector>
+    struct packed_polygons
+    {
+        using vertex_iterator = typename std::vector<Vector>::const_iterator;
+
+        // vertices of all polygons
+        std::vector<Vector> vertices;
+
+        // index of the first vertex of each polygon followed by the total
+        // number of vertices
+        std::vector<std::size_t> offsets{ 0 };
+
+        // number of polygons
+        std::size_t size() const { return offsets.size() - 1; }
+
+        // remove all polygons
+        void clear()
+        {
+            vertices.clear();
+            offsets.assign(1, 0);
+        }
+
+        // iterator of the first vertex of the i-th polygon
+        vertex_iterator polygon_begin(std::size_t i) const
+        {
+            return vertices.begin() + offsets[i];
+        }
+
+        // iterator past the last vertex of the i-th polygon
+        vertex_iterator polygon_end(std::size_t i) const
+        {
+            return vertices.begin() + offsets[i + 1];
+        }
+
+        // number of vertices of the i-th polygon
+        std::size_t polygon_size(std::size_t i) const
+        {
+            return offsets[i + 1] - offsets[i];
+        }
+    };
+
+    /* Buffers used by a batch of visibility polygon queries.
+     * Obstacles are read and copied to a contiguous array and equations of
+     * their supporting lines are computed once per batch, all queries share
+     * buffers of one visibility workspace.
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State = adaptive_state>
+    struct batch_workspace
+    {
+        using segment_type = line_segment<Vector>;
+
+        // polygon computed by a worker of a parallel batch
+        struct polygon_record
+        {
+            // index of the observer
+            std::size_t observer;
+
+            // range of vertices in the vertex buffer of the worker
+            std::size_t first, last;
+        };
+
+        // buffers of a worker of a parallel batch
+        struct worker
+        {
+            visibility_workspace<Vector, State> query;
+            std::vector<Vector> vertices;
+            std::vector<polygon_record> polygons;
+        };
+
+        // obstacles shared by all queries in the batch
+        std::vector<segment_type> obstacles;
+
+        // equations of supporting lines of the obstacles
+        std::vector<line_equation> lines;
+
+        // buffers of the queries
+        visibility_workspace<Vector, State> query;
+
+        // buffers of the workers of a parallel batch
+        std::vector<worker> workers;
+    };
+
+    /** Copy line segments to the batch workspace, remove degenerate line
+     * segments (they are collinear with every observer) and compute 
+     * equations of supporting lines of the rest.
+     * @param begin iterator of the list of line segments (obstacles)
+     * @param end iterator of the list of line segments (obstacles)
+     * @param workspace buffers used by the batch
+     */
+    template<
+        typename Vector,
+        typename InputIterator,
+        template<typename, typename> class State>
+    void load_obstacles(
+        InputIterator begin,
+        InputIterator end,
+        batch_workspace<Vector, State>& workspace)
+    {
+        auto& obstacles = workspace.obstacles;
+        auto& lines = workspace.lines;
+        obstacles.clear();
+        lines.clear();
+        for (; begin != end; ++begin)
+        {
+            line_segment<Vector> segment = *begin;
+            if (!approx_equal(segment.a, segment.b))
+            {
+                obstacles.push_back(segment);
+                lines.push_back(make_line_equation(segment));
+            }
+        }
+    }
+
+    /** Calculate visibility polygon of obstacles loaded by load_obstacles()
+     * and pass its vertices in clockwise order to a sink. 
+     * @param point position of the observer
+     * @param workspace buffers of the batch with loaded obstacles
+     * @param query buffers of the query
+     * @param sink function which is called with each vertex of the 
+     *        visibility polygon
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State,
+        typename Sink>
+    void visit_loaded_obstacles(
+        Vector point,
+        const batch_workspace<Vector, State>& workspace,
+        visibility_workspace<Vector, State>& query,
+        Sink& sink)
+    {
+        auto&& obstacles = workspace.obstacles;
+        auto&& lines = workspace.lines;
+        query.clear();
+        for (std::size_t i = 0; i < obstacles.size(); ++i)
+            add_obstacle(point, obstacles[i], lines[i].side(point), query);
+        sweep_obstacles(point, query, sink);
+    }
+
+    /** Run visibility queries of multiple observers in one thread.
+     * @param first_observer iterator of the list of observer positions
+     * @param last_observer iterator of the list of observer positions
+     * @param workspace buffers used by the queries
+     * @param output polygons
+     * @param query function (observer, workspace, sink) which computes 
+     *        a visibility polygon and passes its vertices to the sink
+     */
+    template<
+        typename Vector,
+        typename ObserverIterator,
+        template<typename, typename> class State,
+        typename Query>
+    void run_batch(
+        ObserverIterator first_observer,
+        ObserverIterator last_observer,
+        visibility_workspace<Vector, State>& workspace,
+        packed_polygons<Vector>& output,
+        Query&& query)
+    {
+        auto& vertices = output.vertices;
+        auto sink = [&vertices](const Vector& vertex) { vertices.push_back(vertex); };
+        for (; first_observer != last_observer; ++first_observer)
+        {
+            Vector observer = *first_observer;
+            query(observer, workspace, sink);
+            output.offsets.push_back(vertices.size());
+        }
+    }
+
+    /** Run visibility queries of multiple observers in parallel.
+     * Observers are distributed among workers of the thread pool which 
+     * steal work from each other. Each worker has its own buffers in the
+     * workspace. The output is the same as in run_batch().
+     * @param first_observer random access iterator of the list of observer
+     *        positions
+     * @param last_observer random access iterator of the list of observer 
+     *        positions
+     * @param workspace buffers used by the queries
+     * @param pool threads which compute the polygons
+     * @param output polygons
+     * @param query function (observer, workspace, sink) which computes 
+     *        a visibility polygon and passes its vertices to the sink
+     */
+    template<
+        typename Vector,
+        typename ObserverIterator,
+        template<typename, typename> class State,
+        typename Query>
+    void run_parallel_batch(
+        ObserverIterator first_observer,
+        ObserverIterator last_observer,
+        batch_workspace<Vector, State>& workspace,
+        thread_pool& pool,
+        packed_polygons<Vector>& output,
+        Query&& query)
+    {
+        auto& workers = workspace.workers;
+        if (workers.size() < pool.size())
+            workers.resize(pool.size());
+        for (auto&& worker : workers)
+        {
+            worker.vertices.clear();
+            worker.polygons.clear();
+        }
+
+        auto count = static_cast<std::size_t>(last_observer - first_observer);
+        pool.parallel_for(count, 1, [&](
+            std::size_t index, 
+            std::size_t first, 
+            std::size_t last)
+        {
+            auto& worker = workers[index];
+            auto& vertices = worker.vertices;
+            auto sink = [&vertices](const Vector& vertex) { vertices.push_back(vertex); };
+            for (auto i = first; i < last; ++i)
+            {
+                Vector observer = first_observer[i];
+                auto offset = vertices.size();
+                query(observer, worker.query, sink);
+                worker.polygons.push_back({ i, offset, vertices.size() });
+            }
+        });
+
+        // compute offsets of the polygons in the output and copy vertices
+        auto base = output.offsets.size() - 1;
+        output.offsets.resize(base + count + 1);
+        for (auto&& worker : workers)
+        {
+            for (auto&& polygon : worker.polygons)
+                output.offsets[base + polygon.observer + 1] = polygon.last - polygon.first;
+        }
+        for (std::size_t i = 0; i < count; ++i)
+            output.offsets[base + i + 1] += output.offsets[base + i];
+
+        output.vertices.resize(output.offsets.back());
+        for (auto&& worker : workers)
+        {
+            for (auto&& polygon : worker.polygons)
+            {
+                std::copy(
+                    worker.vertices.begin() + polygon.first,
+                    worker.vertices.begin() + polygon.last,
+                    output.vertices.begin() + output.offsets[base + polygon.observer]);
+            }
+        }
+    }
+
+    /** Calculate visibility polygons of multiple observers with the same
+     * obstacles. Polygons are appended to the output in the order of
+     * observers (vertices of each polygon are in clockwise order).
+     * Obstacles are copied and equations of their supporting lines are 
+     * computed once, so a query classifies an obstacle by evaluating its 
+     * line equation. Every query still sorts events of all obstacles. 
+     * The visibility_scene overload also welds endpoints of the obstacles.
+     * @param first_observer iterator of the list of observer positions
+     * @param last_observer iterator of the list of observer positions
+     * @param begin iterator of the list of line segments (obstacles)
+     * @param end iterator of the list of line segments (obstacles)
+     * @param workspace buffers used by the algorithm
+     * @param output polygons
+     */
+    template<
+        typename Vector,
+        typename ObserverIterator,
+        typename InputIterator,
+        template<typename, typename> class State>
+    void visibility_polygons(
+        ObserverIterator first_observer,
+        ObserverIterator last_observer,
+        InputIterator begin,
+        InputIterator end,
+        batch_workspace<Vector, State>& workspace,
+        packed_polygons<Vector>& output)
+    {
+        load_obstacles(begin, end, workspace);
+        workspace.query.reserve(workspace.obstacles.size());
+        run_batch(first_observer, last_observer, workspace.query, output, [&](
+            Vector observer,
+            visibility_workspace<Vector, State>& query,
+            auto& sink)
+        {
+            visit_loaded_obstacles(observer, workspace, query, sink);
+        });
+    }
+
+    /** Calculate visibility polygons of multiple observers with the same
+     * obstacles in parallel (see run_parallel_batch()). The output is the 
+     * same as in the single threaded version.
+     * @param first_observer random access iterator of the list of observer
+     *        positions
+     * @param last_observer random access iterator of the list of observer 
+     *        positions
+     * @param begin iterator of the list of line segments (obstacles)
+     * @param end iterator of the list of line segments (obstacles)
+     * @param workspace buffers used by the algorithm
+     * @param pool threads which compute the polygons
+     * @param output polygons
+     */
+    template<
+        typename Vector,
+        typename ObserverIterator,
+        typename InputIterator,
+        template<typename, typename> class State>
+    void visibility_polygons(
+        ObserverIterator first_observer,
+        ObserverIterator last_observer,
+        InputIterator begin,
+        InputIterator end,
+        batch_workspace<Vector, State>& workspace,
+        thread_pool& pool,
+        packed_polygons<Vector>& output)
+    {
+        load_obstacles(begin, end, workspace);
+        run_parallel_batch(first_observer, last_observer, workspace, pool, output, [&](
+            Vector observer,
+            visibility_workspace<Vector, State>& query,
+            auto& sink)
+        {
+            visit_loaded_obstacles(observer, workspace, query, sink);
+        });
+    }
+
+    /** Calculate visibility polygons of multiple observers in a scene.
+     * Polygons are appended to the output in the order of observers.
+     * @param first_observer iterator of the list of observer positions
+     * @param last_observer iterator of the list of observer positions
+     * @param scene obstacles
+     * @param workspace buffers used by the algorithm
+     * @param output polygons
+     */
+    template<
+        typename Vector,
+        typename ObserverIterator,
+        template<typename, typename> class State>
+    void visibility_polygons(
+        ObserverIterator first_observer,
+        ObserverIterator last_observer,
+        const visibility_scene<Vector>& scene,
+        batch_workspace<Vector, State>& workspace,
+        packed_polygons<Vector>& output)
+    {
+        run_batch(first_observer, last_observer, workspace.query, output, [&](
+            Vector observer,
+            visibility_workspace<Vector, State>& query,
+            auto& sink)
+        {
+            visit_visibility_polygon(scene, observer, query, sink);
+        });
+    }
+
+    /** Calculate visibility polygons of multiple observers in a scene in 
+     * parallel (see run_parallel_batch()).
+     * @param first_observer random access iterator of the list of observer
+     *        positions
+     * @param last_observer random access iterator of the list of observer 
+     *        positions
+     * @param scene obstacles
+     * @param workspace buffers used by the algorithm
+     * @param pool threads which compute the polygons
+     * @param output polygons
+     */
+    template<
+        typename Vector,
+        typename ObserverIterator,
+        template<typename, typename> class State>
+    void visibility_polygons(
+        ObserverIterator first_observer,
+        ObserverIterator last_observer,
+        const visibility_scene<Vector>& scene,
+        batch_workspace<Vector, State>& workspace,
+        thread_pool& pool,
+        packed_polygons<Vector>& output)
+    {
+        run_parallel_batch(first_observer, last_observer, workspace, pool, output, [&](
+            Vector observer,
+            visibility_workspace<Vector, State>& query,
+            auto& sink)
+        {
+            visit_visibility_polygon(scene, observer, query, sink);
+        });
+    }
+
+    /** Calculate visibility polygons of multiple observers with the same
+     * obstacles.
+     * @param first_observer iterator of the list of observer positions
+     * @param last_observer iterator of the list of observer positions
+     * @param begin iterator of the list of line segments (obstacles)
+     * @param end iterator of the list of line segments (obstacles)
+     * @return polygons in the order of observers
+     */
+    template<
+        typename ObserverIterator,
+        typename InputIterator,
+        typename Vector = 
+            typename std::iterator_traits<ObserverIterator>::value_type>
+    packed_polygons<Vector> visibility_polygons(
+        ObserverIterator first_observer,
+        ObserverIterator last_observer,
+        InputIterator begin,
+        InputIterator end)
+    {
+        batch_workspace<Vector> workspace;
+        packed_polygons<Vector> output;
+        visibility_polygons(
+            first_observer, last_observer, begin, end, workspace, output);
+        return output;
+    }
+}
+
+#endif // GEOMETRY_BATCH_HPP_
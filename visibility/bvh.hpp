@@ -0,0 +1,839 @@
+#ifndef GEOMETRY_BVH_HPP_
+#define GEOMETRY_BVH_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "thread_pool.hpp"
+
+namespace geometry
+{
+    /* Intersection of a ray with a line segment.
+     */
+    template<typename Vector>
+    struct ray_hit
+    {
+        // index of the line segment
+        std::uint32_t segment;
+
+        // parameter of the intersection point (origin + t * direction)
+        double t;
+
+        // the intersection point
+        Vector point;
+    };
+
+    /* Bounding volume hierarchy of line segments.
+     * The tree is built top-down. Each node is split by the surface area
+     * heuristic evaluated on bins of centroids of its line segments (in 2D,
+     * the probability that a random line hits a box is proportional to its
+     * perimeter). Unlike uniform_grid, the tree adapts to the density of
+     * the scene so it does not degrade if dense clusters of line segments
+     * are next to empty areas.
+     * Nodes are stored in one array (24 bytes per node with float
+     * coordinates) and children of an inner node are adjacent. Line
+     * segments are copied in the order of leaves so that a leaf reads a
+     * contiguous range of memory.
+     * The tree is immutable after it is built so it can be queried from
+     * multiple threads at once.
+     */
+    template<typename Vector>
+    class segment_bvh
+    {
+    public:
+        using segment_type = line_segment<Vector>;
+        using scalar_type = typename std::decay<decltype(std::declval<Vector>().x)>::type;
+
+        // node of the tree
+        struct node
+        {
+            // bounding box of line segments in the subtree
+            scalar_type min_x, min_y, max_x, max_y;
+
+            // index of the first child (inner node) or position of the first
+            // line segment (leaf)
+            std::uint32_t index;
+
+            // number of line segments of a leaf (0 for inner nodes)
+            std::uint32_t count;
+        };
+
+        segment_bvh() {}
+
+        /** Build the tree.
+         * @param segments line segments (they are referenced by indices)
+         * @param leaf_size nodes with at most this many line segments are
+         *        leaves (the surface area heuristic can also stop at up to
+         *        twice as many line segments)
+         */
+        explicit segment_bvh(
+            const std::vector<segment_type>& segments,
+            std::size_t leaf_size = 4)
+        {
+            build(segments, nullptr, leaf_size);
+        }
+
+        /** Build the tree in parallel. Top levels of the tree are split
+         * on the calling thread until there are enough independent subtrees
+         * which are then built by workers of the pool. The result is the
+         * same as if the tree was built on one thread.
+         * @param segments line segments (they are referenced by indices)
+         * @param pool threads which build subtrees
+         * @param leaf_size nodes with at most this many line segments are
+         *        leaves (see the serial constructor)
+         */
+        segment_bvh(
+            const std::vector<segment_type>& segments,
+            thread_pool& pool,
+            std::size_t leaf_size = 4)
+        {
+            build(segments, &pool, leaf_size);
+        }
+
+        // number of line segments
+        std::size_t size() const { return segments_.size(); }
+
+        // nodes of the tree (the root is the first node)
+        const std::vector<node>& nodes() const { return nodes_; }
+
+        // number of levels of the tree
+        std::size_t depth() const { return depth_; }
+
+        /** Call a function with the index of each line segment whose
+         * bounding box intersects a rectangle.
+         * @param min corner of the rectangle
+         * @param max corner of the rectangle
+         * @param function called with the index of a line segment
+         */
+        template<typename Function>
+        void visit_box(Vector min, Vector max, Function&& function) const
+        {
+            auto overlaps = [&](
+                scalar_type min_x, scalar_type min_y,
+                scalar_type max_x, scalar_type max_y)
+            {
+                return min_x <= max.x && max_x >= min.x &&
+                    min_y <= max.y && max_y >= min.y;
+            };
+            visit([&](const node& current)
+            {
+                if (!overlaps(current.min_x, current.min_y, current.max_x, current.max_y))
+                    return overlap::none;
+                auto is_inside = current.min_x >= min.x && current.max_x <= max.x &&
+                    current.min_y >= min.y && current.max_y <= max.y;
+                return is_inside ? overlap::full : overlap::partial;
+            }, [&](const segment_type& segment)
+            {
+                return overlaps(
+                    std::min(segment.a.x, segment.b.x),
+                    std::min(segment.a.y, segment.b.y),
+                    std::max(segment.a.x, segment.b.x),
+                    std::max(segment.a.y, segment.b.y));
+            }, function);
+        }
+
+        /** Call a function with the index of each line segment which
+         * intersects a disc.
+         * @param center of the disc
+         * @param radius of the disc
+         * @param function called with the index of a line segment
+         */
+        template<typename Function>
+        void visit_disc(Vector center, double radius, Function&& function) const
+        {
+            if (!(radius >= 0))
+                return;
+
+            vector2<double> origin{
+                static_cast<double>(center.x),
+                static_cast<double>(center.y) };
+            auto limit = radius * radius * (1 + margin) + margin;
+            visit([&](const node& current)
+            {
+                auto dx = std::max(0.0, std::max(
+                    current.min_x - origin.x, origin.x - current.max_x));
+                auto dy = std::max(0.0, std::max(
+                    current.min_y - origin.y, origin.y - current.max_y));
+                if (dx * dx + dy * dy > limit)
+                    return overlap::none;
+
+                // the farthest corner is in the disc
+                auto far_x = std::max(origin.x - current.min_x, current.max_x - origin.x);
+                auto far_y = std::max(origin.y - current.min_y, current.max_y - origin.y);
+                return far_x * far_x + far_y * far_y <= radius * radius ?
+                    overlap::full : overlap::partial;
+            }, [&](const segment_type& segment)
+            {
+                auto a = to_double(segment.a) - origin;
+                auto dir = to_double(segment.b) - to_double(segment.a);
+                auto length = length_squared(dir);
+                auto t = length > 0 ? -dot(a, dir) / length : 0;
+                t = std::max(0.0, std::min(1.0, t));
+                return length_squared(a + dir * t) <= limit;
+            }, function);
+        }
+
+        /** Call a function with the index of each line segment which
+         * intersects a wedge. The wedge goes clockwise from the start ray
+         * to the end ray (it can be wider than pi).
+         * @param apex of the wedge
+         * @param start_dir direction of the start ray
+         * @param end_dir direction of the end ray
+         * @param function called with the index of a line segment
+         */
+        template<typename Function>
+        void visit_wedge(
+            Vector apex,
+            vector2<double> start_dir,
+            vector2<double> end_dir,
+            Function&& function) const
+        {
+            wedge_planes wedge{ to_double(apex), start_dir, end_dir };
+            visit([&](const node& current)
+            {
+                vector2<double> corners[4] = {
+                    { current.min_x, current.min_y },
+                    { current.min_x, current.max_y },
+                    { current.max_x, current.max_y },
+                    { current.max_x, current.min_y } };
+                return wedge.classify(corners, 4);
+            }, [&](const segment_type& segment)
+            {
+                vector2<double> points[2] = { to_double(segment.a), to_double(segment.b) };
+                return wedge.classify(points, 2) != overlap::none;
+            }, function);
+        }
+
+        /** Find the nearest intersection of a ray with a line segment.
+         * Nodes are visited front to back and nodes behind the nearest
+         * intersection found so far are skipped.
+         * @param query the ray
+         * @param hit the nearest intersection (it is only modified if the
+         *        ray hits a line segment)
+         * @param max_t maximal parameter of the intersection point
+         * @return true iff the ray hits a line segment
+         */
+        bool nearest_hit(
+            const ray<Vector>& query,
+            ray_hit<Vector>& hit,
+            double max_t = std::numeric_limits<double>::infinity()) const
+        {
+            auto origin = to_double(query.origin);
+            auto dir = to_double(query.direction);
+            if (nodes_.empty() || length_squared(dir) == 0)
+                return false;
+
+            // stack of nodes with the parameter where the ray enters them
+            std::pair<std::uint32_t, double> stack[stack_size];
+            std::size_t top = 0;
+            auto best = max_t;
+            auto found = false;
+            double root_entry = 0;
+            if (enters(nodes_[0], origin, dir, best, root_entry))
+                stack[top++] = std::make_pair(0u, root_entry);
+            while (top > 0)
+            {
+                auto item = stack[--top];
+                if (item.second > best)
+                    continue;
+
+                auto&& current = nodes_[item.first];
+                if (current.count == 0)
+                {
+                    // push the farther child first
+                    auto near_index = current.index, far_index = current.index + 1;
+                    double near_entry = 0, far_entry = 0;
+                    auto near_hit = enters(nodes_[near_index], origin, dir, best, near_entry);
+                    auto far_hit = enters(nodes_[far_index], origin, dir, best, far_entry);
+                    if (far_hit && (!near_hit || far_entry < near_entry))
+                    {
+                        std::swap(near_index, far_index);
+                        std::swap(near_entry, far_entry);
+                        std::swap(near_hit, far_hit);
+                    }
+                    if (far_hit)
+                        stack[top++] = std::make_pair(far_index, far_entry);
+                    if (near_hit)
+                        stack[top++] = std::make_pair(near_index, near_entry);
+                    continue;
+                }
+
+                for (auto i = current.index; i < current.index + current.count; ++i)
+                {
+                    auto t = intersect(origin, dir, segments_[i]);
+                    if (std::isfinite(t) && t <= best && (!found || t < best))
+                    {
+                        best = t;
+                        found = true;
+                        hit.segment = indices_[i];
+                    }
+                }
+            }
+
+            if (found)
+            {
+                hit.t = best;
+                auto point = origin + dir * best;
+                hit.point = Vector{
+                    static_cast<scalar_type>(point.x),
+                    static_cast<scalar_type>(point.y) };
+            }
+            return found;
+        }
+
+    private:
+        // line segment during the build
+        struct build_item
+        {
+            scalar_type min_x, min_y, max_x, max_y;
+            std::uint32_t index;
+        };
+
+        // bounding box of line segments
+        struct build_bounds
+        {
+            scalar_type min_x, min_y, max_x, max_y;
+
+            static build_bounds empty()
+            {
+                auto max = std::numeric_limits<scalar_type>::max();
+                auto min = std::numeric_limits<scalar_type>::lowest();
+                return build_bounds{ max, max, min, min };
+            }
+
+            void add(const build_item& item)
+            {
+                min_x = std::min(min_x, item.min_x);
+                min_y = std::min(min_y, item.min_y);
+                max_x = std::max(max_x, item.max_x);
+                max_y = std::max(max_y, item.max_y);
+            }
+
+            void add(const build_bounds& other)
+            {
+                min_x = std::min(min_x, other.min_x);
+                min_y = std::min(min_y, other.min_y);
+                max_x = std::max(max_x, other.max_x);
+                max_y = std::max(max_y, other.max_y);
+            }
+
+            // half of the perimeter
+            double area() const
+            {
+                return (static_cast<double>(max_x) - min_x) +
+                    (static_cast<double>(max_y) - min_y);
+            }
+        };
+
+        // node whose subtree has not been built yet
+        struct build_task
+        {
+            std::uint32_t node;
+            std::uint32_t first, last;
+            std::uint32_t depth;
+            build_bounds bounds;
+        };
+
+        // relation of a node and a query region
+        enum class overlap
+        {
+            none,
+            partial,
+            full,
+        };
+
+        // wedge given by half-planes (see visit_wedge())
+        struct wedge_planes
+        {
+            vector2<double> apex;
+
+            // normals of half-planes (the wedge is their intersection if it
+            // is convex, otherwise it is the complement of the intersection)
+            vector2<double> normals[3];
+            int count;
+            bool is_convex;
+
+            wedge_planes(vector2<double> apex, vector2<double> start_dir, vector2<double> end_dir) :
+                apex(apex)
+            {
+                start_dir = normalize(start_dir);
+                end_dir = normalize(end_dir);
+                auto turn = cross(start_dir, end_dir);
+                is_convex = turn <= 0;
+                if (is_convex)
+                {
+                    normals[0] = vector2<double>{ start_dir.y, -start_dir.x };
+                    normals[1] = vector2<double>{ -end_dir.y, end_dir.x };
+                    count = turn < 0 || dot(start_dir, end_dir) > 0 ? 3 : 2;
+                }
+                else
+                {
+                    normals[0] = vector2<double>{ end_dir.y, -end_dir.x };
+                    normals[1] = vector2<double>{ -start_dir.y, start_dir.x };
+                    count = 3;
+                }
+                normals[2] = normalize(start_dir + end_dir);
+            }
+
+            /** Check whether a convex polygon intersects the wedge.
+             * @param points vertices of the polygon
+             * @param point_count number of vertices
+             * @return overlap::none if the polygon is outside of the wedge,
+             *         overlap::full if it is inside of the wedge (polygons
+             *         close to the boundary overlap partially)
+             */
+            overlap classify(const vector2<double>* points, std::size_t point_count) const
+            {
+                auto is_inside_all = true;
+                for (int i = 0; i < count; ++i)
+                {
+                    auto is_outside = true;
+                    auto is_inside = true;
+                    for (std::size_t j = 0; j < point_count; ++j)
+                    {
+                        auto v = points[j] - apex;
+                        auto side = dot(normals[i], v);
+                        auto tolerance = margin * (std::abs(v.x) + std::abs(v.y));
+                        is_outside = is_outside && side < -tolerance;
+                        is_inside = is_inside && side > tolerance;
+                    }
+
+                    // the polygon is outside of a half-plane of a convex
+                    // wedge or outside of the complement of a wedge
+                    if (is_outside)
+                        return is_convex ? overlap::none : overlap::full;
+                    is_inside_all = is_inside_all && is_inside;
+                }
+
+                // the polygon is in the intersection of all half-planes
+                if (is_inside_all)
+                    return is_convex ? overlap::full : overlap::none;
+                return overlap::partial;
+            }
+        };
+
+        // relative tolerance of queries
+        static constexpr double margin = 1e-7;
+
+        // number of bins of the surface area heuristic
+        static constexpr std::size_t bin_count = 16;
+
+        // depth from which nodes are split at the median (it bounds the
+        // depth of the tree by max_sah_depth + 32)
+        static constexpr std::uint32_t max_sah_depth = 64;
+
+        // size of the traversal stack (greater than the depth of the tree)
+        static constexpr std::size_t stack_size = 128;
+
+        std::vector<node> nodes_;
+        std::vector<segment_type> segments_;
+        std::vector<std::uint32_t> indices_;
+        std::size_t depth_ = 0;
+
+        static vector2<double> to_double(Vector point)
+        {
+            return vector2<double>{
+                static_cast<double>(point.x),
+                static_cast<double>(point.y) };
+        }
+
+        /** Visit nodes which overlap a query region and report line
+         * segments in their leaves which pass a test. Line segments in
+         * subtrees of nodes inside of the region are reported without tests.
+         * @param node_test function which computes overlap of a node
+         * @param segment_test function which checks a line segment
+         * @param function called with the index of a line segment
+         */
+        template<typename NodeTest, typename SegmentTest, typename Function>
+        void visit(NodeTest&& node_test, SegmentTest&& segment_test, Function&& function) const
+        {
+            if (nodes_.empty())
+                return;
+
+            // the highest bit of a stack entry marks nodes inside of the region
+            const std::uint32_t inside_flag = 0x80000000u;
+            std::uint32_t stack[stack_size];
+            std::size_t top = 0;
+            stack[top++] = 0;
+            while (top > 0)
+            {
+                auto entry = stack[--top];
+                auto&& current = nodes_[entry & ~inside_flag];
+                auto flag = entry & inside_flag;
+                if (flag == 0)
+                {
+                    auto result = node_test(current);
+                    if (result == overlap::none)
+                        continue;
+                    if (result == overlap::full)
+                        flag = inside_flag;
+                }
+
+                if (current.count == 0)
+                {
+                    stack[top++] = (current.index + 1) | flag;
+                    stack[top++] = current.index | flag;
+                    continue;
+                }
+
+                for (auto i = current.index; i < current.index + current.count; ++i)
+                {
+                    if (flag != 0 || segment_test(segments_[i]))
+                        function(indices_[i]);
+                }
+            }
+        }
+
+        /** Compute the parameter where a ray enters a node.
+         * @param current the node
+         * @param origin of the ray
+         * @param dir direction of the ray
+         * @param max_t maximal parameter
+         * @param t_entry the parameter where the ray enters the node
+         * @return true iff the ray intersects the node before max_t
+         */
+        static bool enters(
+            const node& current,
+            vector2<double> origin,
+            vector2<double> dir,
+            double max_t,
+            double& t_entry)
+        {
+            double t_min = 0, t_max = max_t;
+            auto clip = [&](double min, double max, double position, double direction)
+            {
+                if (direction == 0)
+                    return position >= min && position <= max;
+                auto a = (min - position) / direction, b = (max - position) / direction;
+                t_min = std::max(t_min, std::min(a, b));
+                t_max = std::min(t_max, std::max(a, b));
+                return t_min <= t_max * (1 + margin) + margin;
+            };
+            if (!clip(current.min_x, current.max_x, origin.x, dir.x) ||
+                !clip(current.min_y, current.max_y, origin.y, dir.y))
+            {
+                return false;
+            }
+            t_entry = t_min;
+            return true;
+        }
+
+        /** Intersect a ray with a line segment.
+         * @param origin of the ray
+         * @param dir direction of the ray
+         * @param segment the line segment
+         * @return parameter of the nearest intersection point or infinity
+         */
+        static double intersect(
+            vector2<double> origin,
+            vector2<double> dir,
+            const segment_type& segment)
+        {
+            auto infinity = std::numeric_limits<double>::infinity();
+            auto a = to_double(segment.a) - origin;
+            auto edge = to_double(segment.b) - to_double(segment.a);
+            auto denominator = cross(dir, edge);
+            if (denominator == 0)
+            {
+                // the nearest point of a collinear line segment
+                if (cross(a, dir) != 0)
+                    return infinity;
+                auto length = length_squared(dir);
+                auto t_a = dot(a, dir) / length;
+                auto t_b = dot(a + edge, dir) / length;
+                if (std::max(t_a, t_b) < 0)
+                    return infinity;
+                return std::max(0.0, std::min(t_a, t_b));
+            }
+
+            auto t = cross(a, edge) / denominator;
+            auto u = cross(a, dir) / denominator;
+            return t >= 0 && u >= 0 && u <= 1 ? t : infinity;
+        }
+
+        void build(
+            const std::vector<segment_type>& segments,
+            thread_pool* pool,
+            std::size_t leaf_size)
+        {
+            if (segments.empty())
+                return;
+
+            leaf_size = std::max<std::size_t>(leaf_size, 1);
+            auto count = segments.size();
+            std::vector<build_item> items(count);
+            auto make_items = [&](std::size_t, std::size_t first, std::size_t last)
+            {
+                for (auto i = first; i < last; ++i)
+                {
+                    auto&& segment = segments[i];
+                    items[i] = build_item{
+                        std::min(segment.a.x, segment.b.x),
+                        std::min(segment.a.y, segment.b.y),
+                        std::max(segment.a.x, segment.b.x),
+                        std::max(segment.a.y, segment.b.y),
+                        static_cast<std::uint32_t>(i) };
+                }
+            };
+            if (pool != nullptr)
+                pool->parallel_for(count, 1 << 14, make_items);
+            else
+                make_items(0, 0, count);
+
+            // split top levels until there are enough subtrees for workers
+            auto task_size = pool == nullptr ? count :
+                std::max<std::size_t>(count / (4 * pool->size()), 1 << 12);
+            std::vector<build_task> tasks;
+            std::vector<build_task> pending{ build_task{
+                0, 0, static_cast<std::uint32_t>(count), 1,
+                compute_bounds(items.begin(), items.end()) } };
+            nodes_.assign(1, node{});
+            while (!pending.empty())
+            {
+                auto task = pending.back();
+                pending.pop_back();
+                build_task children[2];
+                if (task.last - task.first <= task_size)
+                    tasks.push_back(task);
+                else if (split(nodes_, items, task, leaf_size, children))
+                    pending.insert(pending.end(), children, children + 2);
+            }
+
+            // build the subtrees (the root of a subtree is its first node)
+            std::vector<std::vector<node>> subtrees(tasks.size());
+            std::vector<std::size_t> depths(tasks.size());
+            auto build_subtrees = [&](std::size_t, std::size_t first, std::size_t last)
+            {
+                for (auto i = first; i < last; ++i)
+                {
+                    auto& subtree = subtrees[i];
+                    subtree.assign(1, node{});
+                    std::vector<build_task> stack{ tasks[i] };
+                    stack.back().node = 0;
+                    while (!stack.empty())
+                    {
+                        auto task = stack.back();
+                        stack.pop_back();
+                        depths[i] = std::max<std::size_t>(depths[i], task.depth);
+                        build_task children[2];
+                        if (split(subtree, items, task, leaf_size, children))
+                            stack.insert(stack.end(), children, children + 2);
+                    }
+                }
+            };
+            if (pool != nullptr)
+                pool->parallel_for(tasks.size(), 1, build_subtrees);
+            else
+                build_subtrees(0, 0, tasks.size());
+
+            // append the subtrees and relocate their child indices
+            for (std::size_t i = 0; i < tasks.size(); ++i)
+            {
+                auto&& subtree = subtrees[i];
+                auto offset = static_cast<std::uint32_t>(nodes_.size() - 1);
+                for (std::size_t j = 0; j < subtree.size(); ++j)
+                {
+                    auto value = subtree[j];
+                    if (value.count == 0)
+                        value.index += offset;
+                    if (j == 0)
+                        nodes_[tasks[i].node] = value;
+                    else
+                        nodes_.push_back(value);
+                }
+                depth_ = std::max(depth_, depths[i]);
+            }
+
+            // copy line segments in the order of leaves
+            segments_.resize(count);
+            indices_.resize(count);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                indices_[i] = items[i].index;
+                segments_[i] = segments[items[i].index];
+            }
+        }
+
+        // compute bounds of a range of line segments
+        template<typename Iterator>
+        static build_bounds compute_bounds(Iterator first, Iterator last)
+        {
+            auto result = build_bounds::empty();
+            for (auto it = first; it != last; ++it)
+                result.add(*it);
+            return result;
+        }
+
+        /** Create a node and split it if it is worth it.
+         * @param nodes array of nodes which contains the node
+         * @param items line segments (they are partitioned in place)
+         * @param task the node, its range of line segments and their bounds
+         * @param leaf_size number of line segments of nodes which are leaves
+         * @param children tasks of the new children of the node
+         * @return true iff the node has been split
+         */
+        static bool split(
+            std::vector<node>& nodes,
+            std::vector<build_item>& items,
+            const build_task& task,
+            std::size_t leaf_size,
+            build_task* children)
+        {
+            auto&& bounds = task.bounds;
+            auto count = static_cast<std::size_t>(task.last - task.first);
+            nodes[task.node] = node{
+                bounds.min_x, bounds.min_y, bounds.max_x, bounds.max_y, task.first,
+                static_cast<std::uint32_t>(count) };
+            if (count <= leaf_size)
+                return false;
+
+            // centroids (with doubled coordinates) are binned along the
+            // longer axis of the bounding box
+            auto first = items.begin() + task.first, last = items.begin() + task.last;
+            auto extent_x = 2 * (static_cast<double>(bounds.max_x) - bounds.min_x);
+            auto extent_y = 2 * (static_cast<double>(bounds.max_y) - bounds.min_y);
+            auto axis = extent_x >= extent_y ? 0 : 1;
+            auto extent = axis == 0 ? extent_x : extent_y;
+            auto offset = 2 * (axis == 0 ? bounds.min_x : bounds.min_y);
+            auto centroid = [axis](const build_item& item)
+            {
+                return axis == 0 ? item.min_x + item.max_x : item.min_y + item.max_y;
+            };
+
+            auto middle = first;
+            build_bounds left_bounds, right_bounds;
+            if (extent > 0 && task.depth < max_sah_depth)
+            {
+                // small nodes use fewer bins
+                auto used_bins = std::min(bin_count, count);
+                auto scale = static_cast<scalar_type>(used_bins / extent);
+                auto bin_of = [&](const build_item& item)
+                {
+                    auto bin = static_cast<std::int32_t>((centroid(item) - offset) * scale);
+                    return std::min(static_cast<std::size_t>(bin), used_bins - 1);
+                };
+
+                // neighbouring line segments usually fall into the same bin
+                // so odd and even line segments are binned separately to
+                // break dependencies between iterations
+                build_bounds bins[2][bin_count];
+                std::size_t counts[2][bin_count] = {};
+                std::fill(bins[0], bins[0] + used_bins, build_bounds::empty());
+                std::fill(bins[1], bins[1] + used_bins, build_bounds::empty());
+                auto it = first;
+                for (; last - it >= 2; it += 2)
+                {
+                    auto even = bin_of(it[0]), odd = bin_of(it[1]);
+                    bins[0][even].add(it[0]);
+                    bins[1][odd].add(it[1]);
+                    ++counts[0][even];
+                    ++counts[1][odd];
+                }
+                if (it != last)
+                {
+                    auto bin = bin_of(*it);
+                    bins[0][bin].add(*it);
+                    ++counts[0][bin];
+                }
+                for (std::size_t i = 0; i < used_bins; ++i)
+                {
+                    bins[0][i].add(bins[1][i]);
+                    counts[0][i] += counts[1][i];
+                }
+
+                // cost of splits between bins (the split i puts bins less
+                // than i to the left child)
+                double right_cost[bin_count];
+                auto right = build_bounds::empty();
+                std::size_t right_count = 0;
+                for (auto i = used_bins - 1; i > 0; --i)
+                {
+                    right.add(bins[0][i]);
+                    right_count += counts[0][i];
+                    right_cost[i] = right_count == 0 ? 0 : right.area() * right_count;
+                }
+                auto left = build_bounds::empty();
+                std::size_t left_count = 0;
+                auto best_cost = std::numeric_limits<double>::infinity();
+                std::size_t best_split = 0;
+                for (std::size_t i = 1; i < used_bins; ++i)
+                {
+                    left.add(bins[0][i - 1]);
+                    left_count += counts[0][i - 1];
+                    auto cost = left.area() * left_count + right_cost[i];
+                    if (left_count > 0 && left_count < count && cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_split = i;
+                    }
+                }
+
+                // cost relative to the cost of a line segment test (the
+                // cost of a node test is 1)
+                auto node_area = bounds.area();
+                auto split_cost = node_area > 0 ? 1 + best_cost / node_area : count;
+                if (count <= 2 * leaf_size && split_cost >= count)
+                    return false;
+                if (best_split > 0)
+                {
+                    middle = std::partition(first, last, [&](const build_item& item)
+                    {
+                        return bin_of(item) < best_split;
+                    });
+                    left_bounds = build_bounds::empty();
+                    right_bounds = build_bounds::empty();
+                    for (std::size_t i = 0; i < used_bins; ++i)
+                        (i < best_split ? left_bounds : right_bounds).add(bins[0][i]);
+                }
+            }
+
+            if (middle == first || middle == last)
+            {
+                // split at the median if centroids cannot be separated
+                middle = first + count / 2;
+                std::nth_element(first, middle, last, [&](
+                    const build_item& a,
+                    const build_item& b)
+                {
+                    return centroid(a) < centroid(b);
+                });
+                left_bounds = compute_bounds(first, middle);
+                right_bounds = compute_bounds(middle, last);
+            }
+
+            auto child = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back(node{});
+            nodes.push_back(node{});
+            nodes[task.node].index = child;
+            nodes[task.node].count = 0;
+            auto split_position = static_cast<std::uint32_t>(middle - items.begin());
+            children[0] = build_task{
+                child, task.first, split_position, task.depth + 1, left_bounds };
+            children[1] = build_task{
+                child + 1, split_position, task.last, task.depth + 1, right_bounds };
+            return true;
+        }
+    };
+
+    template<typename Vector>
+    constexpr double segment_bvh<Vector>::margin;
+
+    template<typename Vector>
+    constexpr std::size_t segment_bvh<Vector>::bin_count;
+
+    template<typename Vector>
+    constexpr std::uint32_t segment_bvh<Vector>::max_sah_depth;
+
+    template<typename Vector>
+    constexpr std::size_t segment_bvh<Vector>::stack_size;
+}
+
+#endif // GEOMETRY_BVH_HPP_
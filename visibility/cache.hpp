@@ -0,0 +1,301 @@
+#ifndef GEOMETRY_CACHE_HPP_
+#define GEOMETRY_CACHE_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "visibility.hpp"
+#include "scene.hpp"
+#include "dynamic_scene.hpp"
+
+namespace geometry
+{
+    /* Least recently used cache of visibility polygons.
+     * Polygons are keyed by the position of the observer quantized to a
+     * grid of square cells and by a version of the scene. Observers in the
+     * same cell share the polygon computed for the first of them, so the
+     * cell size trades accuracy for the hit rate (stationary observers
+     * always hit their own polygon). Queries with a new scene version miss
+     * and entries of older versions are evicted as the least recently used.
+     * Vertices of each entry are stored in an array of exact size and the
+     * total memory of entries is bounded.
+     */
+    template<typename Vector>
+    class visibility_cache
+    {
+    public:
+        /** Create an empty cache.
+         * @param cell_size size of the grid used to quantize positions
+         * @param max_bytes maximal memory used by the entries
+         */
+        visibility_cache(double cell_size, std::size_t max_bytes) :
+            inverse_cell_size_(1 / cell_size),
+            max_bytes_(max_bytes) {}
+
+        /** Find a cached polygon or compute and cache it. Polygons of
+         * observers at non-finite positions are computed but not cached.
+         * @param position position of the observer
+         * @param version version of the scene
+         * @param query function which computes visibility polygon at given
+         *        position and returns a reference to its vertices
+         * @return vertices of the polygon (reference which is valid until
+         *         the next call)
+         */
+        template<typename Query>
+        const std::vector<Vector>& find(
+            Vector position,
+            std::size_t version,
+            Query&& query)
+        {
+            if (!std::isfinite(position.x) || !std::isfinite(position.y))
+            {
+                ++miss_count_;
+                return query(position);
+            }
+
+            auto key = make_key(position, version);
+            auto it = index_.find(key);
+            if (it != index_.end())
+            {
+                ++hit_count_;
+                unlink(it->second);
+                push_front(it->second);
+                return entries_[it->second].vertices;
+            }
+
+            ++miss_count_;
+            auto&& vertices = query(position);
+            auto bytes = entry_bytes(vertices.size());
+            if (bytes > max_bytes_)
+                return vertices; // the polygon does not fit in the cache
+            while (bytes_ + bytes > max_bytes_)
+                evict();
+
+            auto entry = allocate();
+            entries_[entry].key = key;
+            entries_[entry].vertices.assign(vertices.begin(), vertices.end());
+            entries_[entry].vertices.shrink_to_fit();
+            push_front(entry);
+            index_.emplace(key, entry);
+            bytes_ += bytes;
+            return entries_[entry].vertices;
+        }
+
+        // remove all entries (counters are kept)
+        void clear()
+        {
+            entries_.clear();
+            free_.clear();
+            index_.clear();
+            head_ = tail_ = no_entry;
+            bytes_ = 0;
+        }
+
+        // reset hit, miss and eviction counters
+        void reset_counters()
+        {
+            hit_count_ = miss_count_ = eviction_count_ = 0;
+        }
+
+        // number of cached polygons
+        std::size_t size() const { return index_.size(); }
+
+        // memory used by the entries in bytes
+        std::size_t memory() const { return bytes_; }
+
+        // maximal memory used by the entries in bytes
+        std::size_t max_memory() const { return max_bytes_; }
+
+        // number of queries answered from the cache
+        std::size_t hit_count() const { return hit_count_; }
+
+        // number of queries which computed the polygon
+        std::size_t miss_count() const { return miss_count_; }
+
+        // number of entries removed to make space for new entries
+        std::size_t eviction_count() const { return eviction_count_; }
+
+        // ratio of hits and all queries (0 if there were no queries)
+        double hit_rate() const
+        {
+            auto count = hit_count_ + miss_count_;
+            return count == 0 ? 0 : static_cast<double>(hit_count_) / count;
+        }
+
+    private:
+        static constexpr std::uint32_t no_entry = ~static_cast<std::uint32_t>(0);
+
+        struct cache_key
+        {
+            std::int64_t x, y;
+            std::size_t version;
+
+            bool operator==(const cache_key& other) const
+            {
+                return x == other.x && y == other.y && version == other.version;
+            }
+        };
+
+        struct key_hash
+        {
+            std::size_t operator()(const cache_key& key) const
+            {
+                auto hash = static_cast<std::uint64_t>(key.x) * 0x9E3779B97F4A7C15ull;
+                hash ^= static_cast<std::uint64_t>(key.y) + 0x632BE59BD9B4E019ull +
+                    (hash << 6) + (hash >> 2);
+                hash ^= static_cast<std::uint64_t>(key.version) +
+                    (hash << 6) + (hash >> 2);
+                return static_cast<std::size_t>(hash);
+            }
+        };
+
+        // cached polygon in a doubly linked list ordered by the last use
+        struct cache_entry
+        {
+            cache_key key;
+            std::vector<Vector> vertices;
+            std::uint32_t prev, next;
+        };
+
+        double inverse_cell_size_;
+        std::size_t max_bytes_;
+        std::size_t bytes_ = 0;
+        std::vector<cache_entry> entries_;
+        std::vector<std::uint32_t> free_;
+        std::unordered_map<cache_key, std::uint32_t, key_hash> index_;
+
+        // the most and the least recently used entry
+        std::uint32_t head_ = no_entry;
+        std::uint32_t tail_ = no_entry;
+
+        std::size_t hit_count_ = 0;
+        std::size_t miss_count_ = 0;
+        std::size_t eviction_count_ = 0;
+
+        cache_key make_key(Vector position, std::size_t version) const
+        {
+            return cache_key{
+                quantize(position.x * inverse_cell_size_),
+                quantize(position.y * inverse_cell_size_),
+                version };
+        }
+
+        // index of a cell clamped to the range of std::int64_t (converting
+        // NaN or a value out of the range is undefined behavior), so cells
+        // far from the origin are merged
+        static std::int64_t quantize(double coordinate)
+        {
+            const double limit = 9223372036854775808.0; // 2^63
+            auto cell = std::floor(coordinate);
+            if (cell >= limit)
+                return std::numeric_limits<std::int64_t>::max();
+            if (!(cell > -limit))
+                return std::numeric_limits<std::int64_t>::min();
+            return static_cast<std::int64_t>(cell);
+        }
+
+        // memory of an entry with given number of vertices (including an
+        // estimate of the hash table node)
+        static std::size_t entry_bytes(std::size_t vertex_count)
+        {
+            return sizeof(cache_entry) + sizeof(cache_key) + 4 * sizeof(void*) +
+                vertex_count * sizeof(Vector);
+        }
+
+        std::uint32_t allocate()
+        {
+            if (free_.empty())
+            {
+                entries_.emplace_back();
+                return static_cast<std::uint32_t>(entries_.size() - 1);
+            }
+            auto entry = free_.back();
+            free_.pop_back();
+            return entry;
+        }
+
+        // remove the least recently used entry
+        void evict()
+        {
+            auto entry = tail_;
+            unlink(entry);
+            auto& vertices = entries_[entry].vertices;
+            bytes_ -= entry_bytes(vertices.size());
+            index_.erase(entries_[entry].key);
+            std::vector<Vector>{}.swap(vertices);
+            free_.push_back(entry);
+            ++eviction_count_;
+        }
+
+        void unlink(std::uint32_t entry)
+        {
+            auto prev = entries_[entry].prev, next = entries_[entry].next;
+            (prev == no_entry ? head_ : entries_[prev].next) = next;
+            (next == no_entry ? tail_ : entries_[next].prev) = prev;
+        }
+
+        void push_front(std::uint32_t entry)
+        {
+            entries_[entry].prev = no_entry;
+            entries_[entry].next = head_;
+            (head_ == no_entry ? tail_ : entries_[head_].prev) = entry;
+            head_ = entry;
+        }
+    };
+
+    /** Calculate visibility polygon in a scene or find it in a cache.
+     * @param cache cache of polygons in the scene
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param workspace buffers used by the algorithm
+     * @return vertices of the visibility polygon (reference which is valid
+     *         until the next query)
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    const std::vector<Vector>& visibility_polygon(
+        visibility_cache<Vector>& cache,
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        return cache.find(point, 0, [&](Vector position) -> const std::vector<Vector>&
+        {
+            return visibility_polygon(scene, position, workspace);
+        });
+    }
+
+    /** Calculate visibility polygon in a dynamic scene or find it in a
+     * cache. Edits of the scene change its version so polygons cached
+     * before an edit are not used.
+     * @param cache cache of polygons in the scene
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param workspace buffers used by the algorithm
+     * @return vertices of the visibility polygon (reference which is valid
+     *         until the next query)
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    const std::vector<Vector>& visibility_polygon(
+        visibility_cache<Vector>& cache,
+        const dynamic_scene<Vector>& scene,
+        Vector point,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        return cache.find(point, scene.version(),
+            [&](Vector position) -> const std::vector<Vector>&
+        {
+            return visibility_polygon(scene, position, workspace);
+        });
+    }
+}
+
+#endif // GEOMETRY_CACHE_HPP_
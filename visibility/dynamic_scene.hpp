@@ -0,0 +1,560 @@
+#ifndef GEOMETRY_DYNAMIC_SCENE_HPP_
+#define GEOMETRY_DYNAMIC_SCENE_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "grid.hpp"
+#include "scene.hpp"
+
+namespace geometry
+{
+    /* Set of obstacles which can be edited between visibility queries.
+     * Line segments are identified by ids which do not change when other
+     * line segments are inserted or removed. They are stored in dense
+     * arrays together with equations of their supporting lines (a removed
+     * line segment is replaced by the last one) so a query iterates them as
+     * fast as in an immutable scene. Each edit updates a grid of line
+     * segments which is used to weld endpoints of an inserted line segment
+     * to approximately equal endpoints in the scene. The grid is rebuilt for
+     * the current bounds of the scene whenever the number of line segments
+     * doubles, so the cost of an edit does not grow with the scene.
+     * The scene caches visibility polygons of registered observers. An edit
+     * reports the observers whose cached polygon it has invalidated, other
+     * cached polygons are still valid:
+     * - an inserted line segment invalidates polygons which it intersects,
+     * - a removed line segment invalidates polygons to which it contributes.
+     */
+    template<typename Vector>
+    class dynamic_scene
+    {
+    public:
+        using segment_type = line_segment<Vector>;
+
+        dynamic_scene() {}
+
+        /** Create an empty scene.
+         * @param min corner of the area where most obstacles will be
+         * @param max corner of the area where most obstacles will be
+         * @param expected_size expected number of line segments used to
+         *        choose the cell size of the grid
+         */
+        dynamic_scene(Vector min, Vector max, std::size_t expected_size) :
+            grid_(min, max, expected_size / segments_per_cell),
+            grid_size_(expected_size) {}
+
+        /** Create a scene with initial obstacles.
+         * @param begin iterator of the list of line segments (obstacles)
+         * @param end iterator of the list of line segments (obstacles)
+         */
+        template<typename InputIterator>
+        dynamic_scene(InputIterator begin, InputIterator end)
+        {
+            std::vector<segment_type> input(begin, end);
+            if (input.empty())
+                return;
+
+            auto min = input[0].a, max = input[0].a;
+            for (auto&& segment : input)
+            {
+                for (auto&& point : { segment.a, segment.b })
+                {
+                    min.x = std::min(min.x, point.x);
+                    min.y = std::min(min.y, point.y);
+                    max.x = std::max(max.x, point.x);
+                    max.y = std::max(max.y, point.y);
+                }
+            }
+            grid_ = dynamic_grid<Vector>{
+                min, max, input.size() / segments_per_cell };
+            grid_size_ = input.size();
+            for (auto&& segment : input)
+                insert_segment(segment);
+        }
+
+        // number of line segments
+        std::size_t size() const { return segments_.size(); }
+
+        // line segments (the order changes when a line segment is removed)
+        const std::vector<segment_type>& segments() const { return segments_; }
+
+        // equations of supporting lines of line segments
+        const std::vector<line_equation>& lines() const { return lines_; }
+
+        // id of each line segment in segments()
+        const std::vector<std::uint32_t>& ids() const { return ids_; }
+
+        // spatial index of line segments (indexed by ids)
+        const dynamic_grid<Vector>& grid() const { return grid_; }
+
+        // number of edits of the scene
+        std::size_t version() const { return version_; }
+
+        /** Check whether the scene contains a line segment.
+         * @param id id of the line segment
+         * @return true iff the line segment has not been removed
+         */
+        bool contains(std::uint32_t id) const
+        {
+            return id < slots_.size() && slots_[id] != no_segment;
+        }
+
+        /** Find a line segment.
+         * @param id id of a line segment in the scene
+         * @return the line segment with welded endpoints
+         */
+        const segment_type& segment(std::uint32_t id) const
+        {
+            return segments_[slots_[id]];
+        }
+
+        /** Insert a line segment. Its endpoints are welded to approximately
+         * equal endpoints of line segments in the scene.
+         * @param segment new line segment (obstacle)
+         * @return id of the line segment or no_segment if it is degenerate
+         */
+        std::uint32_t insert_segment(segment_type segment)
+        {
+            segment.a = weld(segment.a);
+            segment.b = weld(segment.b);
+            if (approx_equal(segment.a, segment.b))
+                return no_segment;
+
+            begin_edit();
+            for (std::uint32_t i = 0; i < observers_.size(); ++i)
+            {
+                auto&& observer = observers_[i];
+                if (observer.is_valid && overlaps(observer, segment))
+                    invalidate(i);
+            }
+
+            std::uint32_t id;
+            if (free_ids_.empty())
+            {
+                id = static_cast<std::uint32_t>(slots_.size());
+                slots_.push_back(0);
+            }
+            else
+            {
+                id = free_ids_.back();
+                free_ids_.pop_back();
+            }
+            slots_[id] = static_cast<std::uint32_t>(segments_.size());
+            segments_.push_back(segment);
+            lines_.push_back(make_line_equation(segment));
+            ids_.push_back(id);
+            if (segments_.size() > 2 * grid_size_)
+                rebuild_grid();
+            else
+                grid_.insert(id, segment);
+            return id;
+        }
+
+        /** Remove a line segment.
+         * @param id id of the line segment
+         * @return false if there is no such line segment in the scene
+         */
+        bool remove_segment(std::uint32_t id)
+        {
+            if (!contains(id))
+                return false;
+
+            begin_edit();
+            for (std::uint32_t i = 0; i < observers_.size(); ++i)
+            {
+                auto&& observer = observers_[i];
+                if (observer.is_valid && std::binary_search(
+                    observer.visible.begin(), observer.visible.end(), id))
+                {
+                    invalidate(i);
+                }
+            }
+
+            auto slot = slots_[id];
+            grid_.erase(id, segments_[slot]);
+            segments_[slot] = segments_.back();
+            lines_[slot] = lines_.back();
+            ids_[slot] = ids_.back();
+            slots_[ids_[slot]] = slot;
+            segments_.pop_back();
+            lines_.pop_back();
+            ids_.pop_back();
+            slots_[id] = no_segment;
+            free_ids_.push_back(id);
+            return true;
+        }
+
+        /** Register an observer whose visibility polygon is cached.
+         * @param position position of the observer
+         * @return id of the observer
+         */
+        std::uint32_t add_observer(Vector position)
+        {
+            std::uint32_t id;
+            if (free_observers_.empty())
+            {
+                id = static_cast<std::uint32_t>(observers_.size());
+                observers_.emplace_back();
+            }
+            else
+            {
+                id = free_observers_.back();
+                free_observers_.pop_back();
+            }
+            observers_[id].position = position;
+            return id;
+        }
+
+        /** Move an observer (its cached polygon is invalidated).
+         * @param id id of the observer
+         * @param position new position of the observer
+         */
+        void move_observer(std::uint32_t id, Vector position)
+        {
+            observers_[id].position = position;
+            observers_[id].is_valid = false;
+        }
+
+        /** Unregister an observer.
+         * @param id id of the observer
+         */
+        void remove_observer(std::uint32_t id)
+        {
+            auto& observer = observers_[id];
+            observer.is_valid = false;
+            observer.vertices.clear();
+            observer.visible.clear();
+            free_observers_.push_back(id);
+        }
+
+        // number of registered observers
+        std::size_t observer_count() const
+        {
+            return observers_.size() - free_observers_.size();
+        }
+
+        /** Check whether the cached polygon of an observer is up to date.
+         * @param id id of the observer
+         * @return true iff polygon(id) does not run a query
+         */
+        bool is_valid(std::uint32_t id) const { return observers_[id].is_valid; }
+
+        // observers whose valid cached polygon has been invalidated by the
+        // last insert_segment() or remove_segment()
+        const std::vector<std::uint32_t>& invalidated() const { return invalidated_; }
+
+        /** Get visibility polygon of an observer. The polygon is computed if
+         * the cached polygon is not valid.
+         * @param id id of the observer
+         * @param workspace buffers used by the algorithm
+         * @return vertices of the visibility polygon in clockwise order
+         *         (reference to the cache which is valid until the
+         *         observer is moved or removed)
+         */
+        template<template<typename, typename> class State>
+        const std::vector<Vector>& polygon(
+            std::uint32_t id,
+            visibility_workspace<Vector, State>& workspace)
+        {
+            auto& observer = observers_[id];
+            if (!observer.is_valid)
+                compute(observer, workspace);
+            return observer.vertices;
+        }
+
+    private:
+        // average number of line segments per cell of the grid
+        static constexpr double segments_per_cell = 2;
+
+        struct observer_record
+        {
+            Vector position;
+
+            // cached visibility polygon and its bounding box
+            std::vector<Vector> vertices;
+            Vector min, max;
+
+            // sorted ids of line segments which contribute to the polygon
+            std::vector<std::uint32_t> visible;
+
+            bool is_valid = false;
+
+            // false if some ray from the observer does not hit any line
+            // segment (the polygon does not enclose the visible area)
+            bool is_bounded = false;
+        };
+
+        std::vector<segment_type> segments_;
+        std::vector<line_equation> lines_;
+        std::vector<std::uint32_t> ids_;
+        std::vector<std::uint32_t> slots_;
+        std::vector<std::uint32_t> free_ids_;
+        dynamic_grid<Vector> grid_;
+        std::size_t version_ = 0;
+
+        // number of line segments for which the grid was built
+        std::size_t grid_size_ = 0;
+
+        std::vector<observer_record> observers_;
+        std::vector<std::uint32_t> free_observers_;
+        std::vector<std::uint32_t> invalidated_;
+
+        // ids of line segments in the workspace of the last query
+        std::vector<std::uint32_t> query_ids_;
+
+        void begin_edit()
+        {
+            ++version_;
+            invalidated_.clear();
+        }
+
+        void invalidate(std::uint32_t observer)
+        {
+            observers_[observer].is_valid = false;
+            invalidated_.push_back(observer);
+        }
+
+        // build the grid for bounds of the current line segments
+        void rebuild_grid()
+        {
+            auto min = segments_[0].a, max = segments_[0].a;
+            for (auto&& segment : segments_)
+            {
+                for (auto&& point : { segment.a, segment.b })
+                {
+                    min.x = std::min(min.x, point.x);
+                    min.y = std::min(min.y, point.y);
+                    max.x = std::max(max.x, point.x);
+                    max.y = std::max(max.y, point.y);
+                }
+            }
+            grid_ = dynamic_grid<Vector>{
+                min, max, segments_.size() / segments_per_cell };
+            grid_size_ = segments_.size();
+            for (std::size_t i = 0; i < segments_.size(); ++i)
+                grid_.insert(ids_[i], segments_[i]);
+        }
+
+        // find the nearest approximately equal endpoint in the scene
+        Vector weld(Vector point) const
+        {
+            // approximately equal points can be in adjacent cells
+            using scalar = decltype(point.x);
+            auto epsilon = 2 * std::numeric_limits<scalar>::epsilon();
+            Vector offset{ std::abs(point.x) * epsilon, std::abs(point.y) * epsilon };
+
+            auto result = point;
+            auto min_distance = std::numeric_limits<scalar>::infinity();
+            auto consider = [&](Vector endpoint)
+            {
+                if (!approx_equal(endpoint, point))
+                    return;
+                auto distance = distance_squared(endpoint, point);
+                if (distance < min_distance)
+                {
+                    min_distance = distance;
+                    result = endpoint;
+                }
+            };
+            grid_.visit_box(point - offset, point + offset, [&](std::uint32_t id)
+            {
+                auto&& segment = segments_[slots_[id]];
+                consider(segment.a);
+                consider(segment.b);
+            });
+            return result;
+        }
+
+        template<template<typename, typename> class State>
+        void compute(
+            observer_record& observer,
+            visibility_workspace<Vector, State>& workspace)
+        {
+            auto point = observer.position;
+            workspace.clear();
+            query_ids_.clear();
+            for (std::size_t i = 0; i < segments_.size(); ++i)
+            {
+                auto side = lines_[i].side(point);
+                if (side == orientation::collinear)
+                    continue;
+                query_ids_.push_back(ids_[i]);
+                add_obstacle(point, segments_[i], side, workspace);
+            }
+            sort_obstacles(workspace);
+            prepare_sweep(point, workspace);
+
+            auto& vertices = observer.vertices;
+            auto& visible = observer.visible;
+            vertices.clear();
+            visible.clear();
+            auto sink = [&vertices](const Vector& vertex)
+            {
+                vertices.push_back(vertex);
+            };
+            collinear_filter<Vector, decltype(sink)> filter{ sink };
+            auto& state = workspace.state;
+            if (!state.empty())
+            {
+                auto&& nearest_segment = workspace.segments[state.front()];
+                filter.set_closing_point(
+                    nearest_segment.a.x < nearest_segment.b.x ?
+                    nearest_segment.a : nearest_segment.b);
+            }
+
+            // The state is empty between an end vertex and the next start 
+            // vertex iff rays between them do not hit any line segment. 
+            // This is not a gap if both are the same vertex (ids of welded
+            // vertices are assigned by prepare_sweep()).
+            auto&& prepared = workspace.prepared;
+            auto is_bounded = workspace.events.size() > 0;
+            auto first_start = no_segment, last_end = no_segment;
+            run_sweep(point, workspace, [&](
+                const Vector& vertex,
+                std::uint32_t ref,
+                std::uint32_t segment)
+            {
+                filter.push(vertex);
+                visible.push_back(query_ids_[
+                    segment == no_segment ? event_segment(ref) : segment]);
+                if (!state.empty())
+                    return;
+
+                auto&& event = prepared[event_segment(ref)];
+                if (is_end_vertex(ref))
+                {
+                    last_end = event.end;
+                }
+                else if (last_end == no_segment)
+                {
+                    first_start = event.start;
+                }
+                else
+                {
+                    is_bounded = is_bounded && last_end == event.start;
+                    last_end = no_segment;
+                }
+            });
+            if (last_end != no_segment)
+                is_bounded = is_bounded && last_end == first_start;
+            filter.finish();
+
+            std::sort(visible.begin(), visible.end());
+            visible.erase(std::unique(visible.begin(), visible.end()), visible.end());
+
+            observer.min = observer.max = point;
+            for (auto&& vertex : vertices)
+            {
+                observer.min.x = std::min(observer.min.x, vertex.x);
+                observer.min.y = std::min(observer.min.y, vertex.y);
+                observer.max.x = std::max(observer.max.x, vertex.x);
+                observer.max.y = std::max(observer.max.y, vertex.y);
+            }
+            observer.is_bounded = is_bounded;
+            observer.is_valid = true;
+        }
+
+        // check whether a line segment intersects the cached polygon of an
+        // observer (touching counts as an intersection)
+        static bool overlaps(const observer_record& observer, const segment_type& segment)
+        {
+            auto&& vertices = observer.vertices;
+            if (!observer.is_bounded || vertices.empty())
+                return true;
+            if (std::max(segment.a.x, segment.b.x) < observer.min.x ||
+                std::min(segment.a.x, segment.b.x) > observer.max.x ||
+                std::max(segment.a.y, segment.b.y) < observer.min.y ||
+                std::min(segment.a.y, segment.b.y) > observer.max.y)
+            {
+                return false;
+            }
+
+            auto ax = static_cast<double>(segment.a.x);
+            auto ay = static_cast<double>(segment.a.y);
+            auto bx = static_cast<double>(segment.b.x);
+            auto by = static_cast<double>(segment.b.y);
+            auto is_inside = false;
+            for (std::size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++)
+            {
+                auto px = static_cast<double>(vertices[j].x);
+                auto py = static_cast<double>(vertices[j].y);
+                auto qx = static_cast<double>(vertices[i].x);
+                auto qy = static_cast<double>(vertices[i].y);
+
+                // the line segment intersects an edge of the polygon
+                auto pab = (ax - px) * (by - py) - (ay - py) * (bx - px);
+                auto qab = (ax - qx) * (by - qy) - (ay - qy) * (bx - qx);
+                auto apq = (px - ax) * (qy - ay) - (py - ay) * (qx - ax);
+                auto bpq = (px - bx) * (qy - by) - (py - by) * (qx - bx);
+                if (pab * qab <= 0 && apq * bpq <= 0)
+                    return true;
+
+                // crossing number of a horizontal ray from a
+                if ((py > ay) != (qy > ay) &&
+                    ax < px + (ay - py) * (qx - px) / (qy - py))
+                {
+                    is_inside = !is_inside;
+                }
+            }
+            return is_inside;
+        }
+    };
+
+    /** Calculate visibility polygon in a dynamic scene and pass its vertices
+     * in clockwise order to a sink function. Collinear vertices are removed.
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param workspace buffers used by the algorithm
+     * @param sink function which is called with each vertex of the
+     *        visibility polygon
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State,
+        typename Sink>
+    void visit_visibility_polygon(
+        const dynamic_scene<Vector>& scene,
+        Vector point,
+        visibility_workspace<Vector, State>& workspace,
+        Sink sink)
+    {
+        auto&& segments = scene.segments();
+        auto&& lines = scene.lines();
+        workspace.clear();
+        for (std::size_t i = 0; i < segments.size(); ++i)
+            add_obstacle(point, segments[i], lines[i].side(point), workspace);
+        sweep_obstacles(point, workspace, sink);
+    }
+
+    /** Calculate visibility polygon vertices in a dynamic scene in clockwise
+     * order.
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param workspace buffers used by the algorithm
+     * @return vertices of the visibility polygon (reference to a buffer in
+     *         the workspace which is valid until the next query)
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    const std::vector<Vector>& visibility_polygon(
+        const dynamic_scene<Vector>& scene,
+        Vector point,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        auto& vertices = workspace.vertices;
+        vertices.clear();
+        visit_visibility_polygon(scene, point, workspace,
+            [&vertices](const Vector& vertex) { vertices.push_back(vertex); });
+        return vertices;
+    }
+}
+
+#endif // GEOMETRY_DYNAMIC_SCENE_HPP_
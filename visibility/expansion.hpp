@@ -0,0 +1,188 @@
+#ifndef GEOMETRY_EXPANSION_HPP_
+#define GEOMETRY_EXPANSION_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "triangulation.hpp"
+
+namespace geometry
+{
+    /* Part of the view of an observer which leaves a triangle through one
+     * of its edges. The cone is bounded by rays from the observer through
+     * 2 vertices of the triangulation.
+     */
+    struct expansion_cone
+    {
+        // index of the triangle
+        std::uint32_t triangle;
+
+        // index of the edge in the triangle (see constrained_triangulation)
+        std::uint32_t edge;
+
+        // vertices on the boundary rays in clockwise order
+        std::uint32_t left, right;
+    };
+
+    /* Buffers used by the triangular expansion. Once they are large
+     * enough, a query does not allocate any memory.
+     */
+    template<typename Vector>
+    struct expansion_workspace
+    {
+        // cones which have not been expanded yet (the top of the stack is
+        // the next cone in clockwise order)
+        std::vector<expansion_cone> cones;
+
+        // endpoints of visible parts of constrained edges in clockwise order
+        std::vector<Vector> points;
+
+        // vertices of the polygon returned by visibility_polygon()
+        std::vector<Vector> vertices;
+    };
+
+    /** Calculate visibility polygon by triangular expansion and pass its
+     * vertices in clockwise order to a sink function. The expansion starts
+     * in the triangle which contains the observer and recursively enters
+     * neighboring triangles through unconstrained edges. The view cone is
+     * narrowed at each vertex so the expansion only visits triangles which
+     * are (at least partially) visible and its cost depends on the size of
+     * the output rather than the size of the scene. Collinear vertices are
+     * removed.
+     * @param triangulation constrained triangulation of the obstacles
+     * @param point position of the observer (it must not be on an
+     *        obstacle)
+     * @param workspace buffers used by the algorithm
+     * @param sink function which is called with each vertex of the
+     *        visibility polygon (it is not called if the observer is
+     *        outside of the frame of the triangulation)
+     */
+    template<typename Vector, typename Sink>
+    void visit_visibility_polygon(
+        const constrained_triangulation<Vector>& triangulation,
+        Vector point,
+        expansion_workspace<Vector>& workspace,
+        Sink sink)
+    {
+        using triangulation_type = constrained_triangulation<Vector>;
+        auto& cones = workspace.cones;
+        auto& points = workspace.points;
+        cones.clear();
+        points.clear();
+
+        auto start = triangulation.locate(point);
+        if (start == triangulation_type::none)
+            return;
+
+        auto&& triangles = triangulation.triangles();
+        auto&& vertices = triangulation.vertices();
+        auto position = [&vertices, point](std::uint32_t vertex)
+        {
+            return relative_position(point, vertices[vertex]);
+        };
+
+        // cones through edges of the first triangle in clockwise order
+        auto&& first = triangles[start];
+        cones.push_back(expansion_cone{ start, 2, first.vertices[1], first.vertices[0] });
+        cones.push_back(expansion_cone{ start, 0, first.vertices[2], first.vertices[1] });
+        cones.push_back(expansion_cone{ start, 1, first.vertices[0], first.vertices[2] });
+        while (!cones.empty())
+        {
+            auto cone = cones.back();
+            cones.pop_back();
+
+            // endpoints of the edge in clockwise order
+            auto&& item = triangles[cone.triangle];
+            auto x0 = item.vertices[triangulation_type::prev(cone.edge)];
+            auto x1 = item.vertices[triangulation_type::next(cone.edge)];
+            if (item.is_constrained(cone.edge))
+            {
+                // intersection of a boundary ray with the edge
+                auto a = position(x0);
+                auto dir = position(x1) - a;
+                auto boundary = [&](std::uint32_t vertex)
+                {
+                    if (vertex == x0 || vertex == x1)
+                        return vertices[vertex];
+                    auto ray = position(vertex);
+                    auto denominator = cross(ray, dir);
+                    auto t = denominator == 0 ? 0 : -cross(ray, a) / denominator;
+                    auto offset = a + dir * std::max(0.0, std::min(1.0, t));
+                    return Vector{
+                        static_cast<decltype(point.x)>(point.x + offset.x),
+                        static_cast<decltype(point.y)>(point.y + offset.y) };
+                };
+                points.push_back(boundary(cone.left));
+                points.push_back(boundary(cone.right));
+                continue;
+            }
+
+            // the neighbor is split by the ray through its third vertex
+            auto index = item.neighbors[cone.edge];
+            auto&& other = triangles[index];
+            auto edge = triangulation_type::neighbor_edge(other, cone.triangle);
+            auto c = position(other.vertices[edge]);
+            auto before_edge = triangulation_type::prev(edge);
+            auto after_edge = triangulation_type::next(edge);
+            if (cross(position(cone.left), c) >= 0)
+            {
+                // the vertex is before the cone
+                cones.push_back(expansion_cone{ index, after_edge, cone.left, cone.right });
+            }
+            else if (cross(position(cone.right), c) <= 0)
+            {
+                // the vertex is after the cone
+                cones.push_back(expansion_cone{ index, before_edge, cone.left, cone.right });
+            }
+            else
+            {
+                auto vertex = other.vertices[edge];
+                cones.push_back(expansion_cone{ index, after_edge, vertex, cone.right });
+                cones.push_back(expansion_cone{ index, before_edge, cone.left, vertex });
+            }
+        }
+
+        // the last point which differs from the first one closes the polygon
+        collinear_filter<Vector, Sink> filter{ sink };
+        for (auto it = points.rbegin(); it != points.rend(); ++it)
+        {
+            if (!approx_equal(*it, points.front()))
+            {
+                filter.set_closing_point(*it);
+                break;
+            }
+        }
+        for (auto&& vertex : points)
+            filter.push(vertex);
+        filter.finish();
+    }
+
+    /** Calculate visibility polygon by triangular expansion (see
+     * visit_visibility_polygon()).
+     * @param triangulation constrained triangulation of the obstacles
+     * @param point position of the observer
+     * @param workspace buffers used by the algorithm
+     * @return vertices of the visibility polygon in clockwise order
+     *         (reference to a buffer in the workspace which is valid until
+     *         the next query)
+     */
+    template<typename Vector>
+    const std::vector<Vector>& visibility_polygon(
+        const constrained_triangulation<Vector>& triangulation,
+        Vector point,
+        expansion_workspace<Vector>& workspace)
+    {
+        auto& vertices = workspace.vertices;
+        vertices.clear();
+        visit_visibility_polygon(triangulation, point, workspace,
+            [&vertices](const Vector& vertex) { vertices.push_back(vertex); });
+        return vertices;
+    }
+}
+
+#endif // GEOMETRY_EXPANSION_HPP_
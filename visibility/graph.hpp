@@ -0,0 +1,375 @@
+#ifndef GEOMETRY_GRAPH_HPP_
+#define GEOMETRY_GRAPH_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "scene.hpp"
+#include "visible_points.hpp"
+#include "thread_pool.hpp"
+
+namespace geometry
+{
+    // vertices of a visibility graph
+    enum class graph_vertices
+    {
+        // all vertices of the scene
+        all,
+        // only reflex vertices (see reflex_vertices())
+        reflex
+    };
+
+    /* Visibility graph of vertices of a scene in compressed sparse row
+     * format. Neighbors of the i-th vertex of the scene are in the range
+     * [offsets[i], offsets[i + 1]) of the neighbors array (sorted by index).
+     * Vertices which are not in the graph have no neighbors.
+     */
+    struct visibility_graph
+    {
+        using neighbor_iterator = std::vector<std::uint32_t>::const_iterator;
+
+        // index of the first neighbor of each vertex followed by the total
+        // number of neighbors
+        std::vector<std::size_t> offsets{ 0 };
+
+        // indices of neighbors of all vertices
+        std::vector<std::uint32_t> neighbors;
+
+        // number of vertices
+        std::size_t size() const { return offsets.size() - 1; }
+
+        // remove all vertices
+        void clear()
+        {
+            offsets.assign(1, 0);
+            neighbors.clear();
+        }
+
+        // iterator of the first neighbor of the i-th vertex
+        neighbor_iterator neighbors_begin(std::size_t i) const
+        {
+            return neighbors.begin() + offsets[i];
+        }
+
+        // iterator past the last neighbor of the i-th vertex
+        neighbor_iterator neighbors_end(std::size_t i) const
+        {
+            return neighbors.begin() + offsets[i + 1];
+        }
+
+        // number of neighbors of the i-th vertex
+        std::size_t degree(std::size_t i) const
+        {
+            return offsets[i + 1] - offsets[i];
+        }
+    };
+
+    /* Buffers of one worker of the visibility graph builder.
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State = adaptive_state>
+    struct graph_worker
+    {
+        // neighbors of a vertex in the neighbors buffer
+        struct neighbor_list
+        {
+            std::uint32_t vertex;
+            std::size_t first, last;
+        };
+
+        // buffers of the sweep around a vertex
+        visibility_workspace<Vector, State> query;
+
+        // vertices of the graph sorted by their angle keys
+        visibility_events targets;
+
+        // neighbors found by this worker
+        std::vector<std::uint32_t> neighbors;
+        std::vector<neighbor_list> lists;
+    };
+
+    /* Buffers used by the visibility graph builder.
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State = adaptive_state>
+    struct graph_workspace
+    {
+        // flag of each vertex of the scene which is in the graph
+        std::vector<bool> is_included;
+
+        // buffers of the workers (a serial build uses the first one)
+        std::vector<graph_worker<Vector, State>> workers;
+    };
+
+    /** Find reflex vertices of a scene: endpoints of one line segment and
+     * vertices where the angle between 2 consecutive line segments is
+     * greater than pi. A shortest path around obstacles can only turn at
+     * these vertices.
+     * @param scene obstacles
+     * @return flag of each vertex of the scene which is reflex
+     */
+    template<typename Vector>
+    std::vector<bool> reflex_vertices(const visibility_scene<Vector>& scene)
+    {
+        const double pi = 3.14159265358979323846;
+        auto&& vertices = scene.vertices();
+        auto&& records = scene.records();
+
+        // angles of the line segments around each vertex
+        std::vector<std::size_t> offsets(vertices.size() + 1, 0);
+        for (auto&& record : records)
+        {
+            ++offsets[record.a + 1];
+            ++offsets[record.b + 1];
+        }
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+            offsets[i + 1] += offsets[i];
+        std::vector<double> angles(offsets.back());
+        auto positions = offsets;
+        auto add_angle = [&](std::uint32_t vertex, std::uint32_t other)
+        {
+            auto dir = relative_position(vertices[vertex], vertices[other]);
+            angles[positions[vertex]++] = std::atan2(dir.y, dir.x);
+        };
+        for (auto&& record : records)
+        {
+            add_angle(record.a, record.b);
+            add_angle(record.b, record.a);
+        }
+
+        std::vector<bool> result(vertices.size(), false);
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            auto first = angles.begin() + offsets[i];
+            auto last = angles.begin() + offsets[i + 1];
+            if (last - first <= 1)
+            {
+                result[i] = last != first;
+                continue;
+            }
+
+            std::sort(first, last);
+            auto max_gap = *first + 2 * pi - *(last - 1);
+            for (auto it = first + 1; it != last; ++it)
+                max_gap = std::max(max_gap, *it - *(it - 1));
+            result[i] = max_gap > pi;
+        }
+        return result;
+    }
+
+    /** Find vertices of a scene visible from one of its vertices by a
+     * rotational sweep around the vertex. Line segments collinear with the
+     * vertex (including line segments incident to it) are skipped since a
+     * line of sight along them only touches them. Other vertices of the
+     * graph are targets of the sweep (see sweep_targets()): lines of sight
+     * which touch an obstacle at its endpoint are not blocked. Neighbors
+     * are appended to the buffer of the worker.
+     * @param scene obstacles
+     * @param source index of the vertex
+     * @param is_included flag of each vertex which can be a neighbor
+     * @param worker buffers used by the algorithm
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    void find_visible_vertices(
+        const visibility_scene<Vector>& scene,
+        std::uint32_t source,
+        const std::vector<bool>& is_included,
+        graph_worker<Vector, State>& worker)
+    {
+        auto&& vertices = scene.vertices();
+        auto&& segments = scene.segments();
+        auto&& lines = scene.lines();
+        auto point = vertices[source];
+
+        auto& query = worker.query;
+        auto& targets = worker.targets;
+        auto& neighbors = worker.neighbors;
+        auto first = neighbors.size();
+        query.clear();
+        targets.clear();
+        for (std::size_t i = 0; i < segments.size(); ++i)
+        {
+            auto turn = lines[i].side(point);
+            if (turn != orientation::collinear)
+                add_obstacle(point, segments[i], turn, query);
+        }
+        for (std::uint32_t i = 0; i < vertices.size(); ++i)
+        {
+            if (i != source && is_included[i])
+                targets.push_back(angle_key(point, vertices[i]), i);
+        }
+
+        sort_obstacles(query);
+        prepare_sweep(point, query);
+        sweep_targets(point, query, targets,
+            [&](std::uint32_t vertex) { return vertices[vertex]; },
+            [&](std::uint32_t vertex) { neighbors.push_back(vertex); });
+
+        std::sort(neighbors.begin() + first, neighbors.end());
+        worker.lists.push_back({ source, first, neighbors.size() });
+    }
+
+    /** Choose vertices of the graph and clear buffers of the workers.
+     * @param scene obstacles
+     * @param mode vertices of the graph
+     * @param worker_count number of workers
+     * @param workspace buffers of the builder
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    void prepare_graph(
+        const visibility_scene<Vector>& scene,
+        graph_vertices mode,
+        std::size_t worker_count,
+        graph_workspace<Vector, State>& workspace)
+    {
+        if (mode == graph_vertices::reflex)
+            workspace.is_included = reflex_vertices(scene);
+        else
+            workspace.is_included.assign(scene.vertices().size(), true);
+
+        auto& workers = workspace.workers;
+        if (workers.size() < worker_count)
+            workers.resize(worker_count);
+        for (auto&& worker : workers)
+        {
+            worker.neighbors.clear();
+            worker.lists.clear();
+        }
+    }
+
+    /** Copy neighbors found by the workers to the graph.
+     * @param vertex_count number of vertices of the scene
+     * @param workspace buffers of the builder
+     * @param output the graph
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    void collect_graph(
+        std::size_t vertex_count,
+        const graph_workspace<Vector, State>& workspace,
+        visibility_graph& output)
+    {
+        output.offsets.assign(vertex_count + 1, 0);
+        for (auto&& worker : workspace.workers)
+        {
+            for (auto&& list : worker.lists)
+                output.offsets[list.vertex + 1] = list.last - list.first;
+        }
+        for (std::size_t i = 0; i < vertex_count; ++i)
+            output.offsets[i + 1] += output.offsets[i];
+
+        output.neighbors.resize(output.offsets.back());
+        for (auto&& worker : workspace.workers)
+        {
+            for (auto&& list : worker.lists)
+            {
+                std::copy(
+                    worker.neighbors.begin() + list.first,
+                    worker.neighbors.begin() + list.last,
+                    output.neighbors.begin() + output.offsets[list.vertex]);
+            }
+        }
+    }
+
+    /** Build the visibility graph of vertices of a scene. Each vertex is
+     * connected to all vertices of the graph which are visible from it
+     * (see find_visible_vertices()). The cost is one rotational sweep over
+     * all line segments per vertex of the graph.
+     * @param scene obstacles
+     * @param mode vertices of the graph (all vertices or only reflex
+     *        vertices for a reduced graph)
+     * @param workspace buffers used by the algorithm
+     * @param output the graph
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    void build_visibility_graph(
+        const visibility_scene<Vector>& scene,
+        graph_vertices mode,
+        graph_workspace<Vector, State>& workspace,
+        visibility_graph& output)
+    {
+        prepare_graph(scene, mode, 1, workspace);
+        auto&& is_included = workspace.is_included;
+        auto& worker = workspace.workers[0];
+        worker.query.reserve(scene.size());
+        for (std::uint32_t i = 0; i < is_included.size(); ++i)
+        {
+            if (is_included[i])
+                find_visible_vertices(scene, i, is_included, worker);
+        }
+        collect_graph(scene.vertices().size(), workspace, output);
+    }
+
+    /** Build the visibility graph of vertices of a scene in parallel.
+     * Vertices are distributed among workers of the thread pool which steal
+     * work from each other. The output is the same as in the single
+     * threaded version.
+     * @param scene obstacles
+     * @param mode vertices of the graph
+     * @param workspace buffers used by the algorithm
+     * @param pool threads which find neighbors of the vertices
+     * @param output the graph
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    void build_visibility_graph(
+        const visibility_scene<Vector>& scene,
+        graph_vertices mode,
+        graph_workspace<Vector, State>& workspace,
+        thread_pool& pool,
+        visibility_graph& output)
+    {
+        prepare_graph(scene, mode, pool.size(), workspace);
+        auto&& is_included = workspace.is_included;
+        auto& workers = workspace.workers;
+        pool.parallel_for(is_included.size(), 16, [&](
+            std::size_t index,
+            std::size_t first,
+            std::size_t last)
+        {
+            for (auto i = first; i < last; ++i)
+            {
+                if (is_included[i])
+                {
+                    find_visible_vertices(
+                        scene, static_cast<std::uint32_t>(i), is_included, workers[index]);
+                }
+            }
+        });
+        collect_graph(scene.vertices().size(), workspace, output);
+    }
+
+    /** Build the visibility graph of vertices of a scene.
+     * @param scene obstacles
+     * @param mode vertices of the graph
+     * @return the graph
+     */
+    template<typename Vector>
+    visibility_graph build_visibility_graph(
+        const visibility_scene<Vector>& scene,
+        graph_vertices mode = graph_vertices::all)
+    {
+        graph_workspace<Vector> workspace;
+        visibility_graph output;
+        build_visibility_graph(scene, mode, workspace, output);
+        return output;
+    }
+}
+
+#endif // GEOMETRY_GRAPH_HPP_
@@ -0,0 +1,701 @@
+#ifndef GEOMETRY_GRID_HPP_
+#define GEOMETRY_GRID_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+
+namespace geometry
+{
+    /* Layout of square cells of a uniform grid which covers a rectangle.
+     * Coordinates outside of the rectangle are clamped to the boundary 
+     * cells.
+     */
+    template<typename Vector>
+    class grid_layout
+    {
+    public:
+        // rectangle of cells (bounds are inclusive)
+        struct cell_range
+        {
+            std::size_t min_x, min_y, max_x, max_y;
+        };
+
+        grid_layout() {}
+
+        /** Choose square cells which cover a rectangle.
+         * @param min corner of the rectangle
+         * @param max corner of the rectangle
+         * @param cell_count approximate number of cells
+         */
+        grid_layout(Vector min, Vector max, double cell_count)
+        {
+            double width = max.x - min.x, height = max.y - min.y;
+            cell_count = std::max(1.0, cell_count);
+            auto size = std::max(width, height) / std::sqrt(cell_count);
+            if (width * height > 0)
+                size = std::sqrt(width * height / cell_count);
+            if (!(size > 0))
+                size = 1;
+
+            min_ = min;
+            cell_size_ = size;
+            inverse_cell_size_ = 1 / size;
+            columns_ = static_cast<std::size_t>(width / size) + 1;
+            rows_ = static_cast<std::size_t>(height / size) + 1;
+        }
+
+        // number of columns of the grid
+        std::size_t columns() const { return columns_; }
+
+        // number of rows of the grid
+        std::size_t rows() const { return rows_; }
+
+        // size of a cell
+        double cell_size() const { return cell_size_; }
+
+        // corner of the grid with the least coordinates
+        Vector min() const { return min_; }
+
+        // column of cells which contains an x coordinate (clamped)
+        std::size_t column(double x) const
+        {
+            return clamp((x - min_.x) * inverse_cell_size_, columns_);
+        }
+
+        // row of cells which contains a y coordinate (clamped)
+        std::size_t row(double y) const
+        {
+            return clamp((y - min_.y) * inverse_cell_size_, rows_);
+        }
+
+        /** Find cells which intersect a rectangle (clamped to the grid).
+         * @param min corner of the rectangle
+         * @param max corner of the rectangle
+         * @return range of cells
+         */
+        cell_range cells(Vector min, Vector max) const
+        {
+            return cell_range{
+                column(min.x), row(min.y),
+                column(max.x), row(max.y) };
+        }
+
+        // cells which intersect bounding box of a line segment
+        cell_range segment_cells(const line_segment<Vector>& segment) const
+        {
+            return cells(
+                Vector{
+                    std::min(segment.a.x, segment.b.x),
+                    std::min(segment.a.y, segment.b.y) },
+                Vector{
+                    std::max(segment.a.x, segment.b.x),
+                    std::max(segment.a.y, segment.b.y) });
+        }
+
+    private:
+        Vector min_{ 0, 0 };
+        double cell_size_ = 1;
+        double inverse_cell_size_ = 1;
+        std::size_t columns_ = 0;
+        std::size_t rows_ = 0;
+
+        std::size_t clamp(double coordinate, std::size_t size) const
+        {
+            if (!(coordinate > 0))
+                return 0;
+            auto index = static_cast<std::size_t>(
+                std::min(coordinate, static_cast<double>(size - 1)));
+            return index;
+        }
+    };
+
+    // cell with the least coordinates of a line segment in a grid
+    struct grid_cell_position
+    {
+        std::uint32_t x, y;
+    };
+
+    // cells of a line segment in a grid (bounds are inclusive)
+    struct grid_cell_box
+    {
+        std::uint32_t min_x, min_y, max_x, max_y;
+    };
+
+    /* Uniform grid of line segments.
+     * Each line segment is stored in all cells which intersect its bounding
+     * box. Cells are stored in compressed form: line segments of cell i are
+     * in the range [cell_offsets[i], cell_offsets[i + 1]) of one array.
+     * The grid is immutable after it is built so it can be queried from
+     * multiple threads at once.
+     *
+     * Queries are conservative: they report all line segments which
+     * intersect the query region and possibly some other line segments in
+     * the same cells. Each line segment is reported at most once.
+     */
+    template<typename Vector>
+    class uniform_grid
+    {
+    public:
+        using segment_type = line_segment<Vector>;
+        using cell_range = typename grid_layout<Vector>::cell_range;
+
+        uniform_grid() {}
+
+        /** Build the grid.
+         * @param segments line segments (they are referenced by indices)
+         * @param segments_per_cell average number of line segments per cell
+         *        used to choose the cell size
+         */
+        explicit uniform_grid(
+            const std::vector<segment_type>& segments,
+            double segments_per_cell = 2)
+        {
+            build(segments, segments_per_cell);
+        }
+
+        // number of columns of the grid
+        std::size_t columns() const { return layout_.columns(); }
+
+        // number of rows of the grid
+        std::size_t rows() const { return layout_.rows(); }
+
+        // size of a cell
+        double cell_size() const { return layout_.cell_size(); }
+
+        /** Find cells which intersect a rectangle (clamped to the grid).
+         * @param min corner of the rectangle
+         * @param max corner of the rectangle
+         * @return range of cells
+         */
+        cell_range cells(Vector min, Vector max) const
+        {
+            return layout_.cells(min, max);
+        }
+
+        /** Call a function with the index of each line segment stored in
+         * cells which intersect a rectangle. Each line segment is reported
+         * at most once.
+         * @param min corner of the rectangle
+         * @param max corner of the rectangle
+         * @param function called with the index of a line segment
+         */
+        template<typename Function>
+        void visit_box(Vector min, Vector max, Function&& function) const
+        {
+            auto columns = layout_.columns();
+            if (columns == 0)
+                return;
+
+            auto range = cells(min, max);
+            for (auto y = range.min_y; y <= range.max_y; ++y)
+            {
+                for (auto x = range.min_x; x <= range.max_x; ++x)
+                {
+                    auto cell = y * columns + x;
+                    for (auto i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i)
+                    {
+                        // report the line segment in the first cell of the
+                        // range which contains it
+                        auto index = cell_segments_[i];
+                        auto&& box = segment_boxes_[index];
+                        if (x == std::max<std::size_t>(box.min_x, range.min_x) &&
+                            y == std::max<std::size_t>(box.min_y, range.min_y))
+                        {
+                            function(index);
+                        }
+                    }
+                }
+            }
+        }
+
+        /** Call a function with the index of each line segment stored in
+         * cells which intersect a disc.
+         * @param center of the disc
+         * @param radius of the disc
+         * @param function called with the index of a line segment
+         */
+        template<typename Function>
+        void visit_disc(Vector center, double radius, Function&& function) const
+        {
+            if (layout_.columns() == 0 || !(radius >= 0))
+                return;
+
+            double x = center.x, y = center.y;
+            auto size = layout_.cell_size();
+            auto bottom = static_cast<double>(layout_.min().y);
+            radius += size * margin;
+            visit_cells(layout_.row(y - radius), layout_.row(y + radius),
+                [&](std::size_t row, std::size_t& min_x, std::size_t& max_x)
+            {
+                // horizontal extent of the disc in the row
+                auto row_min = bottom + row * size;
+                auto distance = std::max(0.0,
+                    std::max(row_min - y, y - (row_min + size)));
+                if (distance > radius)
+                    return false;
+                auto extent = std::sqrt(radius * radius - distance * distance);
+                min_x = layout_.column(x - extent);
+                max_x = layout_.column(x + extent);
+                return true;
+            }, function);
+        }
+
+        /** Call a function with the index of each line segment stored in
+         * cells which intersect a wedge. The wedge goes clockwise from the
+         * start ray to the end ray. Wedges wider than pi are not culled.
+         * @param apex of the wedge
+         * @param start_dir direction of the start ray
+         * @param end_dir direction of the end ray
+         * @param function called with the index of a line segment
+         */
+        template<typename Function>
+        void visit_wedge(
+            Vector apex,
+            vector2<double> start_dir,
+            vector2<double> end_dir,
+            Function&& function) const
+        {
+            if (layout_.columns() == 0)
+                return;
+
+            // the wedge is an intersection of half-planes given by their
+            // normals (dot(normal, point - apex) >= 0)
+            start_dir = normalize(start_dir);
+            end_dir = normalize(end_dir);
+            vector2<double> normals[3] = {
+                { start_dir.y, -start_dir.x },
+                { -end_dir.y, end_dir.x },
+                normalize(start_dir + end_dir) };
+            auto turn = cross(start_dir, end_dir);
+            auto is_convex = turn <= 0;
+            auto normal_count = turn < 0 || dot(start_dir, end_dir) > 0 ? 3 : 2;
+
+            auto size = layout_.cell_size();
+            auto min = layout_.min();
+            vector2<double> origin{ 
+                static_cast<double>(apex.x) - min.x, 
+                static_cast<double>(apex.y) - min.y };
+            auto width = layout_.columns() * size;
+            visit_cells(0, layout_.rows() - 1,
+                [&](std::size_t row, std::size_t& min_x, std::size_t& max_x)
+            {
+                if (!is_convex)
+                {
+                    min_x = 0;
+                    max_x = layout_.columns() - 1;
+                    return true;
+                }
+
+                // clip the row by the half-planes
+                vector2<double> polygon[8] = {
+                    { 0, row * size },
+                    { 0, (row + 1) * size },
+                    { width, (row + 1) * size },
+                    { width, row * size } };
+                std::size_t count = 4;
+                for (int i = 0; i < normal_count && count > 0; ++i)
+                    count = clip(polygon, count, normals[i], origin, -size * margin);
+                if (count == 0)
+                    return false;
+
+                auto left = polygon[0].x, right = polygon[0].x;
+                for (std::size_t i = 1; i < count; ++i)
+                {
+                    left = std::min(left, polygon[i].x);
+                    right = std::max(right, polygon[i].x);
+                }
+                min_x = layout_.column(min.x + left - size * margin);
+                max_x = layout_.column(min.x + right + size * margin);
+                return true;
+            }, function);
+        }
+
+        /** Call a function with the index of each line segment stored in
+         * cells which intersect a ray. Cells are visited in the order in
+         * which the ray passes through them. The function returns the
+         * maximal distance along the ray which is still of interest (e.g.,
+         * the distance of the nearest intersection found so far) and the
+         * traversal stops at the first cell beyond it.
+         * @param origin of the ray
+         * @param direction of the ray
+         * @param max_distance maximal distance from the origin
+         * @param function called with the index of a line segment, it
+         *        returns the new maximal distance
+         */
+        template<typename Function>
+        void visit_ray(
+            Vector origin,
+            vector2<double> direction,
+            double max_distance,
+            Function&& function) const
+        {
+            if (layout_.columns() == 0 || length_squared(direction) == 0)
+                return;
+
+            // clip the ray by the rectangle of the grid
+            direction = normalize(direction);
+            auto size = layout_.cell_size();
+            auto min = layout_.min();
+            vector2<double> start{
+                static_cast<double>(origin.x) - min.x,
+                static_cast<double>(origin.y) - min.y };
+            double t_min = 0, t_max = max_distance;
+            if (!clip_ray(start.x, direction.x, layout_.columns() * size, t_min, t_max) ||
+                !clip_ray(start.y, direction.y, layout_.rows() * size, t_min, t_max))
+            {
+                return;
+            }
+
+            // walk through the cells (3D-DDA in 2 dimensions)
+            auto entry = start + direction * t_min;
+            auto x = layout_.column(min.x + entry.x);
+            auto y = layout_.row(min.y + entry.y);
+            auto step_x = direction.x >= 0 ? 1 : -1;
+            auto step_y = direction.y >= 0 ? 1 : -1;
+            auto infinity = std::numeric_limits<double>::infinity();
+            auto next_x = direction.x == 0 ? infinity :
+                ((x + (step_x > 0)) * size - start.x) / direction.x;
+            auto next_y = direction.y == 0 ? infinity :
+                ((y + (step_y > 0)) * size - start.y) / direction.y;
+            auto delta_x = size / std::abs(direction.x);
+            auto delta_y = size / std::abs(direction.y);
+            auto columns = layout_.columns();
+            // the previous cell is outside of the grid at the start
+            auto previous_x = std::numeric_limits<std::size_t>::max();
+            auto previous_y = previous_x;
+            for (;;)
+            {
+                auto cell = y * columns + x;
+                for (auto i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i)
+                {
+                    // report the line segment in the first visited cell
+                    // which contains it (the path is monotone so it does
+                    // not return to the cells of a line segment)
+                    auto index = cell_segments_[i];
+                    auto&& box = segment_boxes_[index];
+                    if (!contains(box, previous_x, previous_y))
+                        t_max = std::min<double>(t_max, function(index));
+                }
+
+                previous_x = x;
+                previous_y = y;
+                if (next_x < next_y)
+                {
+                    if (next_x > t_max || (step_x < 0 ? x == 0 : x + 1 == columns))
+                        return;
+                    x += step_x;
+                    next_x += delta_x;
+                }
+                else
+                {
+                    if (next_y > t_max || (step_y < 0 ? y == 0 : y + 1 == layout_.rows()))
+                        return;
+                    y += step_y;
+                    next_y += delta_y;
+                }
+            }
+        }
+
+    private:
+        grid_layout<Vector> layout_;
+        std::vector<std::uint32_t> cell_offsets_;
+        std::vector<std::uint32_t> cell_segments_;
+        std::vector<grid_cell_box> segment_boxes_;
+
+        // relative tolerance of queries (in cell sizes)
+        static constexpr double margin = 1e-6;
+
+        // check whether a cell is in a box of cells
+        static bool contains(const grid_cell_box& box, std::size_t x, std::size_t y)
+        {
+            return box.min_x <= x && x <= box.max_x && box.min_y <= y && y <= box.max_y;
+        }
+
+        /** Visit cells of a region row by row. Each row of the region must
+         * be a contiguous range of cells and rows of the region which
+         * intersect a range of columns must be contiguous (it holds for
+         * convex regions).
+         * @param first_row the least row of the region
+         * @param last_row the greatest row of the region
+         * @param span function which computes the range of cells of a row,
+         *        it returns false if the region does not intersect the row
+         * @param function called with the index of each line segment in the
+         *        region (once)
+         */
+        template<typename Span, typename Function>
+        void visit_cells(
+            std::size_t first_row,
+            std::size_t last_row,
+            Span&& span,
+            Function&& function) const
+        {
+            auto columns = layout_.columns();
+            auto has_previous = false;
+            std::size_t previous_min = 0, previous_max = 0;
+            for (auto y = first_row; y <= last_row; ++y)
+            {
+                std::size_t min_x = 0, max_x = 0;
+                auto is_visited = span(y, min_x, max_x);
+                for (auto x = min_x; is_visited && x <= max_x; ++x)
+                {
+                    auto cell = y * columns + x;
+                    for (auto i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i)
+                    {
+                        // report the line segment in the first visited cell
+                        // which contains it
+                        auto index = cell_segments_[i];
+                        auto&& box = segment_boxes_[index];
+                        auto is_first_row = !has_previous || y == box.min_y ||
+                            previous_max < box.min_x || previous_min > box.max_x;
+                        if (is_first_row && x == std::max<std::size_t>(box.min_x, min_x))
+                            function(index);
+                    }
+                }
+
+                has_previous = is_visited;
+                previous_min = min_x;
+                previous_max = max_x;
+            }
+        }
+
+        /** Clip a convex polygon by a half-plane.
+         * @param polygon vertices of the polygon (it is modified in place, 
+         *        there must be space for 1 more vertex)
+         * @param count number of vertices
+         * @param normal of the half-plane
+         * @param origin point on the boundary of the half-plane
+         * @param tolerance minimal value of dot(normal, point - origin) of 
+         *        points in the half-plane
+         * @return number of vertices of the clipped polygon
+         */
+        static std::size_t clip(
+            vector2<double>* polygon,
+            std::size_t count,
+            vector2<double> normal,
+            vector2<double> origin,
+            double tolerance)
+        {
+            vector2<double> input[8];
+            std::copy(polygon, polygon + count, input);
+            std::size_t result = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto a = input[i], b = input[(i + 1) % count];
+                auto side_a = dot(normal, a - origin) - tolerance;
+                auto side_b = dot(normal, b - origin) - tolerance;
+                if (side_a >= 0)
+                    polygon[result++] = a;
+                if ((side_a < 0) != (side_b < 0))
+                    polygon[result++] = a + (b - a) * (side_a / (side_a - side_b));
+            }
+            return result;
+        }
+
+        /** Clip parameters of a ray by a slab.
+         * @param origin coordinate of the origin of the ray
+         * @param direction coordinate of the direction of the ray
+         * @param size of the slab [0, size]
+         * @param t_min minimal parameter (clipped in place)
+         * @param t_max maximal parameter (clipped in place)
+         * @return true iff the clipped range is not empty
+         */
+        static bool clip_ray(
+            double origin,
+            double direction,
+            double size,
+            double& t_min,
+            double& t_max)
+        {
+            if (direction == 0)
+                return origin >= 0 && origin <= size && t_min <= t_max;
+            auto a = -origin / direction, b = (size - origin) / direction;
+            t_min = std::max(t_min, std::min(a, b));
+            t_max = std::min(t_max, std::max(a, b));
+            return t_min <= t_max;
+        }
+
+        void build(const std::vector<segment_type>& segments, double segments_per_cell)
+        {
+            if (segments.empty())
+                return;
+
+            // bounding box of the scene
+            auto min = segments[0].a, max = segments[0].a;
+            for (auto&& segment : segments)
+            {
+                min.x = std::min(min.x, std::min(segment.a.x, segment.b.x));
+                min.y = std::min(min.y, std::min(segment.a.y, segment.b.y));
+                max.x = std::max(max.x, std::max(segment.a.x, segment.b.x));
+                max.y = std::max(max.y, std::max(segment.a.y, segment.b.y));
+            }
+
+            // choose square cells so that there are about
+            // segments.size() / segments_per_cell cells
+            layout_ = grid_layout<Vector>{ 
+                min, max, segments.size() / segments_per_cell };
+            auto columns = layout_.columns();
+
+            // count line segments in each cell and compute offsets
+            cell_offsets_.assign(columns * layout_.rows() + 1, 0);
+            segment_boxes_.resize(segments.size());
+            for (std::size_t i = 0; i < segments.size(); ++i)
+            {
+                auto range = layout_.segment_cells(segments[i]);
+                segment_boxes_[i] = grid_cell_box{
+                    static_cast<std::uint32_t>(range.min_x),
+                    static_cast<std::uint32_t>(range.min_y),
+                    static_cast<std::uint32_t>(range.max_x),
+                    static_cast<std::uint32_t>(range.max_y) };
+                for (auto y = range.min_y; y <= range.max_y; ++y)
+                {
+                    for (auto x = range.min_x; x <= range.max_x; ++x)
+                        ++cell_offsets_[y * columns + x + 1];
+                }
+            }
+            for (std::size_t i = 1; i < cell_offsets_.size(); ++i)
+                cell_offsets_[i] += cell_offsets_[i - 1];
+
+            // store line segments (cell_offsets_[i] is used as the insert
+            // position of cell i, then the offsets are shifted back)
+            cell_segments_.resize(cell_offsets_.back());
+            for (std::size_t i = 0; i < segments.size(); ++i)
+            {
+                auto&& box = segment_boxes_[i];
+                for (std::size_t y = box.min_y; y <= box.max_y; ++y)
+                {
+                    for (std::size_t x = box.min_x; x <= box.max_x; ++x)
+                    {
+                        cell_segments_[cell_offsets_[y * columns + x]++] =
+                            static_cast<std::uint32_t>(i);
+                    }
+                }
+            }
+            for (std::size_t i = cell_offsets_.size() - 1; i > 0; --i)
+                cell_offsets_[i] = cell_offsets_[i - 1];
+            cell_offsets_[0] = 0;
+        }
+    };
+
+    template<typename Vector>
+    constexpr double uniform_grid<Vector>::margin;
+
+    /* Uniform grid of line segments which can be modified.
+     * Each cell has its own array of line segment indices so that a line 
+     * segment can be inserted or erased in time proportional to the number
+     * of its cells and their sizes. The layout of cells is fixed when the 
+     * grid is created (line segments outside of its rectangle are stored in
+     * the boundary cells).
+     */
+    template<typename Vector>
+    class dynamic_grid
+    {
+    public:
+        using segment_type = line_segment<Vector>;
+        using cell_range = typename grid_layout<Vector>::cell_range;
+
+        dynamic_grid() : dynamic_grid(Vector{ 0, 0 }, Vector{ 0, 0 }, 1) {}
+
+        /** Create an empty grid.
+         * @param min corner of the rectangle covered by the grid
+         * @param max corner of the rectangle covered by the grid
+         * @param cell_count approximate number of cells
+         */
+        dynamic_grid(Vector min, Vector max, double cell_count) : 
+            layout_(min, max, cell_count),
+            cells_(layout_.columns() * layout_.rows()) {}
+
+        // number of columns of the grid
+        std::size_t columns() const { return layout_.columns(); }
+
+        // number of rows of the grid
+        std::size_t rows() const { return layout_.rows(); }
+
+        // size of a cell
+        double cell_size() const { return layout_.cell_size(); }
+
+        /** Store a line segment in the grid.
+         * @param index index of the line segment (it must not be in the grid)
+         * @param segment the line segment
+         */
+        void insert(std::uint32_t index, const segment_type& segment)
+        {
+            auto range = layout_.segment_cells(segment);
+            if (index >= first_cells_.size())
+                first_cells_.resize(index + 1);
+            first_cells_[index] = grid_cell_position{
+                static_cast<std::uint32_t>(range.min_x),
+                static_cast<std::uint32_t>(range.min_y) };
+            for (auto y = range.min_y; y <= range.max_y; ++y)
+            {
+                for (auto x = range.min_x; x <= range.max_x; ++x)
+                    cells_[y * layout_.columns() + x].push_back(index);
+            }
+        }
+
+        /** Remove a line segment from the grid.
+         * @param index index of the line segment
+         * @param segment the line segment (as it was inserted)
+         */
+        void erase(std::uint32_t index, const segment_type& segment)
+        {
+            auto range = layout_.segment_cells(segment);
+            for (auto y = range.min_y; y <= range.max_y; ++y)
+            {
+                for (auto x = range.min_x; x <= range.max_x; ++x)
+                {
+                    auto& cell = cells_[y * layout_.columns() + x];
+                    auto it = std::find(cell.begin(), cell.end(), index);
+                    if (it != cell.end())
+                    {
+                        *it = cell.back();
+                        cell.pop_back();
+                    }
+                }
+            }
+        }
+
+        /** Call a function with the index of each line segment stored in
+         * cells which intersect a rectangle. Each line segment is reported
+         * at most once.
+         * @param min corner of the rectangle
+         * @param max corner of the rectangle
+         * @param function called with the index of a line segment
+         */
+        template<typename Function>
+        void visit_box(Vector min, Vector max, Function&& function) const
+        {
+            auto range = layout_.cells(min, max);
+            for (auto y = range.min_y; y <= range.max_y; ++y)
+            {
+                for (auto x = range.min_x; x <= range.max_x; ++x)
+                {
+                    for (auto index : cells_[y * layout_.columns() + x])
+                    {
+                        // report the line segment in the first cell of the
+                        // range which contains it
+                        auto&& first = first_cells_[index];
+                        if (x == std::max<std::size_t>(first.x, range.min_x) &&
+                            y == std::max<std::size_t>(first.y, range.min_y))
+                        {
+                            function(index);
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        grid_layout<Vector> layout_;
+        std::vector<std::vector<std::uint32_t>> cells_;
+        std::vector<grid_cell_position> first_cells_;
+    };
+}
+
+#endif // GEOMETRY_GRID_HPP_
@@ -0,0 +1,736 @@
+#ifndef GEOMETRY_KINETIC_HPP_
+#define GEOMETRY_KINETIC_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "scene.hpp"
+
+namespace geometry
+{
+    /* Combinatorial description of a vertex of a visibility polygon.
+     * If segment is no_segment, the polygon vertex is the scene vertex.
+     * Otherwise, it is the intersection of the ray from the observer
+     * through the scene vertex with the line segment of the scene.
+     */
+    struct kinetic_feature
+    {
+        std::uint32_t vertex;
+        std::uint32_t segment;
+
+        bool operator==(const kinetic_feature& other) const
+        {
+            return vertex == other.vertex && segment == other.segment;
+        }
+
+        bool operator!=(const kinetic_feature& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    /* Visibility polygon of an observer which moves along a polyline.
+     * The path parameter is the arc length from the first point of the
+     * polyline. The path is split into pieces such that the combinatorial
+     * description of the polygon (a list of kinetic_feature) is the same
+     * for all observers in a piece, so the polygon is computed once per
+     * piece and evaluated at any parameter in constant time per vertex.
+     *
+     * The description can only change when the observer becomes collinear
+     * with two scene vertices which are adjacent in the angular order or
+     * when it crosses the supporting line of a line segment. The angular
+     * order of scene vertices is maintained as a kinetic sorted list: each
+     * pair of adjacent vertices has a certificate with the time at which
+     * they swap and the certificates are processed in the order of time.
+     * A swap can only change the polygon if one of the vertices is a
+     * vertex of the polygon and a crossed line can only change it if the
+     * line segment contributes to the polygon. Only these events trigger
+     * a sweep (in the middle of the interval before the next certificate)
+     * so the number of sweeps follows the number of changes of the polygon
+     * and not the number of samples. Other swaps cost O(log n).
+     * The sweep works in single precision so a sample taken right after an
+     * event may not observe it yet, such sample is repeated once all its 
+     * events can be observed.
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State = adaptive_state>
+    class kinetic_visibility
+    {
+    public:
+        kinetic_visibility() {}
+
+        /** Compute visibility polygons along a trajectory.
+         * @param scene obstacles (the scene must outlive this object)
+         * @param begin iterator of the list of points of the polyline
+         * @param end iterator of the list of points of the polyline
+         */
+        template<typename InputIterator>
+        kinetic_visibility(
+            const visibility_scene<Vector>& scene,
+            InputIterator begin,
+            InputIterator end) :
+            scene_(&scene),
+            points_(begin, end)
+        {
+            lengths_.push_back(0);
+            for (std::size_t i = 1; i < points_.size(); ++i)
+            {
+                auto dir = to_double(points_[i]) - to_double(points_[i - 1]);
+                lengths_.push_back(lengths_.back() + std::sqrt(dot(dir, dir)));
+            }
+            build();
+        }
+
+        // number of pieces
+        std::size_t size() const { return firsts_.size(); }
+
+        // length of the trajectory
+        double length() const { return lengths_.empty() ? 0 : lengths_.back(); }
+
+        // path parameter where the i-th piece starts
+        double piece_first(std::size_t i) const { return firsts_[i]; }
+
+        // path parameter where the i-th piece ends
+        double piece_last(std::size_t i) const
+        {
+            return i + 1 < firsts_.size() ? firsts_[i + 1] : length();
+        }
+
+        // combinatorial description of the polygon in the i-th piece
+        std::vector<kinetic_feature> piece_features(std::size_t i) const
+        {
+            return std::vector<kinetic_feature>(
+                features_.begin() + offsets_[i],
+                features_.begin() + offsets_[i + 1]);
+        }
+
+        // number of sweeps used to compute the pieces
+        std::size_t sweep_count() const { return sweep_count_; }
+
+        // number of processed certificates of the kinetic order
+        std::size_t certificate_count() const { return certificate_count_; }
+
+        /** Find the piece which contains a path parameter.
+         * @param parameter arc length from the start of the trajectory
+         *        (clamped to the trajectory)
+         * @return index of the piece
+         */
+        std::size_t find_piece(double parameter) const
+        {
+            auto it = std::upper_bound(firsts_.begin(), firsts_.end(), parameter);
+            return it == firsts_.begin() ? 0 : (it - firsts_.begin()) - 1;
+        }
+
+        /** Compute position of the observer.
+         * @param parameter arc length from the start of the trajectory
+         * @return point of the trajectory
+         */
+        Vector position(double parameter) const
+        {
+            if (points_.size() < 2 || parameter <= 0)
+                return points_.empty() ? Vector{ 0, 0 } : points_.front();
+            auto leg = static_cast<std::size_t>(std::upper_bound(
+                lengths_.begin(), lengths_.end(), parameter) - lengths_.begin());
+            if (leg >= lengths_.size())
+                return points_.back();
+            auto t = (parameter - lengths_[leg - 1]) / (lengths_[leg] - lengths_[leg - 1]);
+
+            // interpolate in the precision of Vector: the observer is 
+            // rounded anyway and a round trip through double could be 
+            // optimized out (the result must be the same point everywhere)
+            auto a = points_[leg - 1], b = points_[leg];
+            return a + (b - a) * static_cast<decltype(a.x)>(t);
+        }
+
+        /** Evaluate the visibility polygon at a path parameter.
+         * @param parameter arc length from the start of the trajectory
+         * @return vertices of the visibility polygon in clockwise order
+         *         starting at the positive y axis (collinear vertices are
+         *         removed)
+         */
+        std::vector<Vector> polygon(double parameter) const
+        {
+            std::vector<Vector> result;
+            if (firsts_.empty())
+                return result;
+
+            auto point = position(parameter);
+            auto piece = find_piece(parameter);
+            auto origin = to_double(point);
+            auto&& vertices = scene_->vertices();
+            auto&& segments = scene_->segments();
+
+            // the description was computed at a different point so the 
+            // sweep could start elsewhere, rotate it to start at the 
+            // positive y axis (where the angle of features decreases)
+            auto first = offsets_[piece], last = offsets_[piece + 1];
+            auto start = first;
+            for (auto i = first + 1; i < last; ++i)
+            {
+                if ((angle_key(point, vertices[features_[i].vertex]) >> 32) <
+                    (angle_key(point, vertices[features_[i - 1].vertex]) >> 32))
+                {
+                    start = i;
+                    break;
+                }
+            }
+
+            std::vector<Vector> raw;
+            for (std::size_t j = 0; j < last - first; ++j)
+            {
+                auto i = start + j < last ? start + j : start + j - (last - first);
+                auto feature = features_[i];
+                auto vertex = vertices[feature.vertex];
+                if (feature.segment != no_segment)
+                {
+                    // intersection of the ray with the supporting line
+                    auto&& segment = segments[feature.segment];
+                    auto a = to_double(segment.a), b = to_double(segment.b);
+                    auto dir = to_double(vertex) - origin;
+                    auto denominator = cross(dir, b - a);
+                    if (denominator != 0)
+                    {
+                        vertex = to_vector(origin + dir * (cross(a - origin, b - a) / denominator));
+                    }
+                }
+                raw.push_back(vertex);
+            }
+            if (raw.empty())
+                return result;
+
+            // remove collinear vertices, the last vertex is on the line of
+            // the closing edge
+            auto sink = [&result](const Vector& vertex) { result.push_back(vertex); };
+            collinear_filter<Vector, decltype(sink)> filter{ sink };
+            if (!approx_equal(raw.back(), raw.front()))
+                filter.set_closing_point(raw.back());
+            for (auto&& vertex : raw)
+                filter.push(vertex);
+            filter.finish();
+            return result;
+        }
+
+    private:
+        // relevant event: vertex `second` follows vertex `first` in the 
+        // clockwise order after a swap or the observer has crossed the 
+        // supporting line of the line segment `first` (second is no_segment)
+        struct pending_event
+        {
+            std::uint32_t first;
+            std::uint32_t second;
+        };
+
+        // scheduled failure of a certificate
+        struct certificate
+        {
+            double time;
+
+            // position in the kinetic order (swap) or number of vertices
+            // plus index of a line segment (crossed supporting line)
+            std::uint32_t item;
+
+            // version of the swap certificate at the position
+            std::uint32_t version;
+
+            bool operator<(const certificate& other) const
+            {
+                // std::push_heap makes a max-heap
+                return time > other.time;
+            }
+        };
+
+        const visibility_scene<Vector>* scene_ = nullptr;
+        std::vector<Vector> points_;
+        std::vector<double> lengths_;
+
+        // pieces: start parameter and range of features
+        std::vector<double> firsts_;
+        std::vector<std::size_t> offsets_{ 0 };
+        std::vector<kinetic_feature> features_;
+
+        std::size_t sweep_count_ = 0;
+        std::size_t certificate_count_ = 0;
+
+        // kinetic order of scene vertices
+        std::vector<std::uint32_t> order_;
+        std::vector<std::uint32_t> versions_;
+        std::vector<certificate> queue_;
+
+        // relevant events which have not been observed by a sample yet
+        std::vector<pending_event> pending_;
+
+        // description of the current piece and its vertices and line
+        // segments
+        std::vector<kinetic_feature> current_;
+        std::vector<kinetic_feature> candidate_;
+        std::vector<bool> visible_;
+        std::vector<bool> hit_;
+
+        // line segment hit by the ray from the observer through a visible
+        // vertex (see shadow_of())
+        std::vector<std::uint32_t> shadows_;
+
+        // buffers of the sweep
+        visibility_workspace<Vector, State> workspace_;
+        std::vector<std::uint32_t> scene_index_;
+        std::vector<bool> swapped_;
+
+        // line segments which were skipped by the last sample because they
+        // were collinear with the observer (in single precision)
+        std::vector<std::uint32_t> collinear_;
+
+        // values of shadows_ other than a line segment index: the vertex
+        // has no intersection (there is nothing behind it), only blocked
+        // intersections or intersections with multiple line segments
+        enum : std::uint32_t
+        {
+            no_shadow = no_segment,
+            blocked_shadow = no_segment - 1,
+            many_shadows = no_segment - 2
+        };
+
+        static vector2<double> to_double(Vector point)
+        {
+            return vector2<double>{ point.x, point.y };
+        }
+
+        static Vector to_vector(vector2<double> point)
+        {
+            Vector result;
+            result.x = static_cast<decltype(result.x)>(point.x);
+            result.y = static_cast<decltype(result.y)>(point.y);
+            return result;
+        }
+
+        void build()
+        {
+            if (points_.empty())
+                return;
+            auto&& vertices = scene_->vertices();
+            visible_.assign(vertices.size(), false);
+            hit_.assign(scene_->size(), false);
+            shadows_.assign(vertices.size(), no_shadow);
+            versions_.assign(vertices.size(), 0);
+
+            // angular order of vertices around the first point
+            auto origin = to_double(points_[0]);
+            order_.resize(vertices.size());
+            for (std::size_t i = 0; i < order_.size(); ++i)
+                order_[i] = static_cast<std::uint32_t>(i);
+            std::vector<double> angles(vertices.size());
+            for (std::size_t i = 0; i < vertices.size(); ++i)
+            {
+                // clockwise angle from the positive y axis
+                auto dir = to_double(vertices[i]) - origin;
+                angles[i] = std::atan2(dir.x, dir.y);
+            }
+            std::sort(order_.begin(), order_.end(), [&angles](auto a, auto b)
+            {
+                return angles[a] < angles[b];
+            });
+
+            if (points_.size() == 1)
+            {
+                sample(points_[0]);
+                start_piece(0);
+                return;
+            }
+
+            // a sample is needed after a relevant event, if it did not 
+            // observe all events, it is repeated once they can be observed
+            auto need_sample = true;
+            auto is_retry = false;
+            double change = 0;
+            for (std::size_t leg = 1; leg < points_.size(); ++leg)
+            {
+                auto first = lengths_[leg - 1], last = lengths_[leg];
+                if (!(last > first))
+                    continue;
+                auto from = to_double(points_[leg - 1]);
+                auto dir = to_double(points_[leg]) - from;
+                schedule_leg(from, dir);
+                pending_.clear();
+
+                double time = 0;
+                for (;;)
+                {
+                    auto next = std::min(next_time(), 1.0);
+                    if (need_sample)
+                    {
+                        auto middle = first + (last - first) * (time + next) / 2;
+                        auto point = position(middle);
+                        auto is_observed = observed(point, dir);
+                        if (!is_retry || is_observed || next >= 1)
+                        {
+                            // a repeated sample starts the piece where the
+                            // first sample should have observed the change
+                            if (!is_retry)
+                                change = first + (last - first) * time;
+                            sample(point);
+                            if (firsts_.empty() || !cyclic_equal(candidate_, current_))
+                                start_piece(change);
+                            need_sample = is_retry = !is_observed;
+                        }
+                    }
+                    if (next >= 1)
+                        break;
+
+                    // process all certificates which fail at this time
+                    time = next;
+                    while (!queue_.empty() && queue_.front().time <= time)
+                    {
+                        auto cert = queue_.front();
+                        std::pop_heap(queue_.begin(), queue_.end());
+                        queue_.pop_back();
+                        if (process(cert, from, dir, time))
+                        {
+                            need_sample = true;
+                            is_retry = false;
+                        }
+                    }
+                }
+            }
+            if (firsts_.empty())
+            {
+                sample(points_[0]);
+                start_piece(0);
+            }
+        }
+
+        // time of the next valid certificate (2 if there is none)
+        double next_time()
+        {
+            while (!queue_.empty())
+            {
+                auto&& top = queue_.front();
+                if (top.item >= order_.size() || versions_[top.item] == top.version)
+                    return top.time;
+                std::pop_heap(queue_.begin(), queue_.end());
+                queue_.pop_back();
+            }
+            return 2;
+        }
+
+        // compute all certificates of a leg of the trajectory
+        void schedule_leg(vector2<double> from, vector2<double> dir)
+        {
+            queue_.clear();
+            for (std::size_t i = 0; i < order_.size(); ++i)
+                schedule_swap(static_cast<std::uint32_t>(i), from, dir, 0, false);
+
+            // crossed supporting lines
+            auto&& lines = scene_->lines();
+            for (std::size_t i = 0; i < lines.size(); ++i)
+            {
+                auto value = lines[i].value(from);
+                auto slope = dot(lines[i].normal, dir);
+                if (slope == 0)
+                    continue;
+                auto time = -value / slope;
+                if (time > 0 && time < 1)
+                {
+                    queue_.push_back(certificate{
+                        time, static_cast<std::uint32_t>(order_.size() + i), 0 });
+                }
+            }
+            std::make_heap(queue_.begin(), queue_.end());
+        }
+
+        // compute the time at which vertices at a position and the next
+        // position swap
+        void schedule_swap(
+            std::uint32_t position,
+            vector2<double> from,
+            vector2<double> dir,
+            double now,
+            bool push_heap)
+        {
+            auto count = order_.size();
+            if (count < 2)
+                return;
+            auto&& vertices = scene_->vertices();
+            auto u = to_double(vertices[order_[position]]);
+            auto w = to_double(vertices[order_[(position + 1) % count]]);
+
+            // cross(u - o, w - o) is linear in time and it is negative if
+            // w follows u in the clockwise order
+            auto value = cross(u - from, w - from);
+            auto slope = cross(dir, u - w);
+            if (!(slope > 0))
+                return;
+            auto time = std::max(-value / slope, now);
+            if (time >= 1)
+                return;
+            auto observer = from + dir * time;
+            if (dot(u - observer, w - observer) <= 0)
+                return; // opposite directions do not swap
+
+            queue_.push_back(certificate{ time, position, versions_[position] });
+            if (push_heap)
+                std::push_heap(queue_.begin(), queue_.end());
+        }
+
+        // process a failed certificate, return true if the polygon may
+        // have changed
+        bool process(
+            const certificate& cert,
+            vector2<double> from,
+            vector2<double> dir,
+            double time)
+        {
+            auto count = static_cast<std::uint32_t>(order_.size());
+            if (cert.item >= count)
+            {
+                // crossed supporting line
+                ++certificate_count_;
+                auto segment = cert.item - count;
+                auto&& record = scene_->records()[segment];
+                auto is_skipped = std::find(
+                    collinear_.begin(), collinear_.end(), segment) != collinear_.end();
+                if (!hit_[segment] && !visible_[record.a] && !visible_[record.b] && 
+                    !is_skipped)
+                    return false;
+                add_pending(pending_event{ segment, no_segment });
+                return true;
+            }
+            if (versions_[cert.item] != cert.version)
+                return false; // outdated certificate
+            ++certificate_count_;
+
+            auto i = cert.item, j = (cert.item + 1) % count;
+            auto relevant = swap_changes_polygon(
+                order_[i], order_[j], from + dir * time);
+            std::swap(order_[i], order_[j]);
+            if (relevant)
+                add_pending(pending_event{ order_[i], order_[j] });
+
+            // the swapped pair and its neighbors have new certificates
+            auto previous = (i + count - 1) % count;
+            for (auto position : { previous, i, j })
+            {
+                ++versions_[position];
+                schedule_swap(position, from, dir, time, true);
+            }
+            return relevant;
+        }
+
+        // add a relevant event, it replaces the opposite event with the same
+        // vertices or line segment
+        void add_pending(pending_event event)
+        {
+            auto it = std::find_if(pending_.begin(), pending_.end(), [event](auto other)
+            {
+                return event.second == no_segment ? 
+                    other.second == no_segment && other.first == event.first :
+                    other.first == event.second && other.second == event.first;
+            });
+            if (it != pending_.end())
+                *it = event;
+            else
+                pending_.push_back(event);
+        }
+
+        // Check whether a sample at a point observed all pending events and
+        // remove the events which it observed. The sweep works in single 
+        // precision: it orders vertices by their pseudo-angle in float and
+        // skips line segments which are almost collinear with the observer.
+        // If the interval between certificates is short, the sample can be
+        // taken before some of its events.
+        bool observed(Vector point, vector2<double> dir)
+        {
+            auto&& vertices = scene_->vertices();
+            auto&& lines = scene_->lines();
+            auto it = std::remove_if(pending_.begin(), pending_.end(), [&](auto event)
+            {
+                if (event.second == no_segment)
+                {
+                    auto&& line = lines[event.first];
+                    auto value = line.value(point) * (dot(line.normal, dir) > 0 ? 1 : -1);
+                    return value > line.tolerance(point);
+                }
+
+                // the second vertex follows the first one (the order is 
+                // cyclic, it starts at the positive y axis)
+                auto first = key_angle(angle_key(point, vertices[event.first]));
+                auto second = key_angle(angle_key(point, vertices[event.second]));
+                return first < second ? second - first < 2 : first - second > 2;
+            });
+            pending_.erase(it, pending_.end());
+            return pending_.empty();
+        }
+
+        // check whether the polygon can change when the observer becomes
+        // collinear with two vertices
+        bool swap_changes_polygon(
+            std::uint32_t u,
+            std::uint32_t w,
+            vector2<double> observer) const
+        {
+            if (!visible_[u])
+                std::swap(u, w);
+            if (!visible_[u])
+                return false; // both vertices are hidden
+            if (visible_[w])
+                return true;
+
+            // the hidden vertex w can only appear if it is in front of u
+            // or in front of the line segment hit by the ray through u
+            auto&& vertices = scene_->vertices();
+            auto du = to_double(vertices[u]) - observer;
+            auto dw = to_double(vertices[w]) - observer;
+            auto reach = dot(du, du);
+            if (dot(dw, dw) <= reach)
+                return true;
+
+            auto shadow = shadows_[u];
+            if (shadow == no_shadow)
+                return true; // nothing is behind u
+            if (shadow == many_shadows)
+                return true;
+            if (shadow != blocked_shadow)
+            {
+                auto&& segment = scene_->segments()[shadow];
+                auto a = to_double(segment.a) - observer;
+                auto b = to_double(segment.b) - observer;
+                auto denominator = cross(du, b - a);
+                if (denominator == 0)
+                    return true;
+                auto scale = cross(a, b - a) / denominator;
+                reach *= scale * scale;
+            }
+            return dot(dw, dw) <= reach * (1 + 1e-9);
+        }
+
+        // compute description of the polygon at a point to candidate_
+        void sample(Vector point)
+        {
+            ++sweep_count_;
+            auto&& segments = scene_->segments();
+            auto&& lines = scene_->lines();
+            auto&& records = scene_->records();
+            workspace_.clear();
+            scene_index_.clear();
+            swapped_.clear();
+            collinear_.clear();
+            for (std::size_t i = 0; i < segments.size(); ++i)
+            {
+                auto side = lines[i].side(point);
+                if (side == orientation::collinear)
+                {
+                    collinear_.push_back(static_cast<std::uint32_t>(i));
+                    continue;
+                }
+                scene_index_.push_back(static_cast<std::uint32_t>(i));
+                swapped_.push_back(side == orientation::left_turn);
+                add_obstacle(point, segments[i], side, workspace_);
+            }
+            sort_obstacles(workspace_);
+            prepare_sweep(point, workspace_);
+
+            candidate_.clear();
+            run_sweep(point, workspace_, [&](
+                const Vector&,
+                std::uint32_t ref,
+                std::uint32_t segment)
+            {
+                auto index = event_segment(ref);
+                auto&& record = records[scene_index_[index]];
+                auto is_b = is_end_vertex(ref) != swapped_[index];
+                candidate_.push_back(kinetic_feature{
+                    is_b ? record.b : record.a,
+                    segment == no_segment ? no_segment : scene_index_[segment] });
+            });
+        }
+
+        // start a new piece with the candidate description
+        void start_piece(double parameter)
+        {
+            for (auto&& feature : current_)
+            {
+                visible_[feature.vertex] = false;
+                if (feature.segment != no_segment)
+                    hit_[feature.segment] = false;
+            }
+            for (auto&& feature : current_)
+                shadows_[feature.vertex] = no_shadow;
+            current_.swap(candidate_);
+            for (auto&& feature : current_)
+            {
+                visible_[feature.vertex] = true;
+                if (feature.segment != no_segment)
+                    hit_[feature.segment] = true;
+            }
+
+            // The sweep emits two equal intersections at a vertex where one
+            // line segment ends and another one starts (the ray through
+            // such vertex is blocked by the vertex itself).
+            auto size = current_.size();
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                auto feature = current_[i];
+                if (feature.segment == no_segment)
+                    continue;
+                auto& shadow = shadows_[feature.vertex];
+                auto is_blocked = 
+                    current_[(i + 1) % size] == feature ||
+                    current_[(i + size - 1) % size] == feature;
+                if (is_blocked)
+                {
+                    if (shadow == no_shadow)
+                        shadow = blocked_shadow;
+                }
+                else if (shadow == no_shadow || shadow == blocked_shadow)
+                {
+                    shadow = feature.segment;
+                }
+                else if (shadow != feature.segment)
+                {
+                    shadow = many_shadows;
+                }
+            }
+
+            // a repeated sample replaces the piece of the previous sample
+            if (!firsts_.empty() && !(firsts_.back() < parameter))
+            {
+                firsts_.pop_back();
+                offsets_.pop_back();
+                features_.resize(offsets_.back());
+            }
+            firsts_.push_back(parameter);
+            features_.insert(features_.end(), current_.begin(), current_.end());
+            offsets_.push_back(features_.size());
+        }
+
+        // check whether two cyclic sequences are equal
+        static bool cyclic_equal(
+            const std::vector<kinetic_feature>& a,
+            const std::vector<kinetic_feature>& b)
+        {
+            if (a.size() != b.size())
+                return false;
+            auto size = a.size();
+            if (size == 0)
+                return true;
+            for (std::size_t shift = 0; shift < size; ++shift)
+            {
+                if (b[shift] != a[0])
+                    continue;
+                std::size_t i = 1;
+                while (i < size && a[i] == b[(i + shift) % size])
+                    ++i;
+                if (i == size)
+                    return true;
+            }
+            return false;
+        }
+    };
+}
+
+#endif // GEOMETRY_KINETIC_HPP_
@@ -0,0 +1,210 @@
+#ifndef GEOMETRY_LINE_OF_SIGHT_HPP_
+#define GEOMETRY_LINE_OF_SIGHT_HPP_
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "scene.hpp"
+#include "thread_pool.hpp"
+
+namespace geometry
+{
+    /** Check whether a line segment crosses a line of sight. Both tests use
+     * the tolerance of line_equation::side() so a line of sight which only
+     * touches the line segment (it passes through an endpoint of the line
+     * segment, it ends on the line segment or it is collinear with it) is
+     * not blocked.
+     * @param segment obstacle
+     * @param line equation of the supporting line of the obstacle
+     * @param sight line of sight
+     * @param sight_line equation of the supporting line of the line of sight
+     * @return true iff the line segment crosses the line of sight
+     */
+    template<typename Vector>
+    bool crosses_line_of_sight(
+        const line_segment<Vector>& segment,
+        const line_equation& line,
+        const line_segment<Vector>& sight,
+        const line_equation& sight_line)
+    {
+        auto is_opposite = [](orientation first, orientation second)
+        {
+            return first != orientation::collinear &&
+                second != orientation::collinear &&
+                first != second;
+        };
+        return is_opposite(sight_line.side(segment.a), sight_line.side(segment.b)) &&
+            is_opposite(line.side(sight.a), line.side(sight.b));
+    }
+
+    /** Check whether a line of sight passes between obstacles through one
+     * of their vertices, i.e. line segments incident to the vertex are on
+     * both sides of the line of sight. Line segments collinear with the
+     * line of sight are ignored.
+     * @param scene obstacles
+     * @param vertex index of the vertex in scene.vertices()
+     * @param sight_line equation of the supporting line of the line of sight
+     * @return true iff the line of sight is blocked at the vertex
+     */
+    template<typename Vector>
+    bool separates_line_of_sight(
+        const visibility_scene<Vector>& scene,
+        std::uint32_t vertex,
+        const line_equation& sight_line)
+    {
+        // all line segments incident to the vertex are stored in its cell
+        auto&& vertices = scene.vertices();
+        auto&& records = scene.records();
+        auto point = vertices[vertex];
+        auto has_left = false;
+        auto has_right = false;
+        scene.grid().visit_box(point, point, [&](std::uint32_t index)
+        {
+            auto record = records[index];
+            if (record.a != vertex && record.b != vertex)
+                return;
+            auto side = sight_line.side(vertices[record.a == vertex ? record.b : record.a]);
+            has_left = has_left || side == orientation::left_turn;
+            has_right = has_right || side == orientation::right_turn;
+        });
+        return has_left && has_right;
+    }
+
+    /** Check whether 2 points see each other. Cells of the grid of the
+     * scene are visited along the line of sight from `a` to `b` and line
+     * segments stored in them are tested by crosses_line_of_sight(). If the
+     * line of sight passes through an endpoint of a line segment, the other
+     * line segments at the vertex are tested by separates_line_of_sight().
+     * The query stops at the first obstacle which blocks the line of sight
+     * so its cost depends on the distance to the nearest obstacle rather
+     * than the size of the scene.
+     * Endpoints of line segments within the tolerance of 
+     * line_equation::side() from the line of sight are considered to touch
+     * it, so a line of sight which grazes the end of a wall is not blocked
+     * (visible_points() can report the target as hidden in this case).
+     * @param scene obstacles
+     * @param a first point
+     * @param b second point
+     * @return true iff no line segment of the scene crosses the line
+     *         segment from `a` to `b` and it does not pass between 2 line
+     *         segments through their common vertex
+     */
+    template<typename Vector>
+    bool line_of_sight(const visibility_scene<Vector>& scene, Vector a, Vector b)
+    {
+        auto dir = relative_position(a, b);
+        auto distance = std::sqrt(length_squared(dir));
+        if (distance == 0)
+            return true;
+
+        auto&& segments = scene.segments();
+        auto&& records = scene.records();
+        auto&& lines = scene.lines();
+        line_segment<Vector> sight{ a, b };
+        auto sight_line = make_line_equation(sight);
+
+        // check whether the line of sight passes through a vertex (it is
+        // called with an endpoint of a line segment which is collinear with
+        // the line of sight)
+        auto last_vertex = std::numeric_limits<std::uint32_t>::max();
+        auto is_blocked_at = [&](std::uint32_t vertex)
+        {
+            if (vertex == last_vertex)
+                return false;
+            last_vertex = vertex;
+
+            auto point = scene.vertices()[vertex];
+            auto offset = dot(relative_position(a, point), dir);
+            return offset > 0 && offset < distance * distance &&
+                !approx_equal(point, a) && !approx_equal(point, b) &&
+                separates_line_of_sight(scene, vertex, sight_line);
+        };
+
+        auto is_visible = true;
+        scene.grid().visit_ray(a, dir, distance, [&](std::uint32_t index)
+        {
+            // stop the traversal after the current cell if the line of
+            // sight is blocked
+            if (is_visible)
+            {
+                auto&& segment = segments[index];
+                auto side_a = sight_line.side(segment.a);
+                auto side_b = sight_line.side(segment.b);
+                if (side_a == orientation::collinear && side_b != orientation::collinear)
+                    is_visible = !is_blocked_at(records[index].a);
+                else if (side_b == orientation::collinear && side_a != orientation::collinear)
+                    is_visible = !is_blocked_at(records[index].b);
+                else
+                    is_visible = !crosses_line_of_sight(segment, lines[index], sight, sight_line);
+            }
+            return is_visible ? std::numeric_limits<double>::infinity() : -1.0;
+        });
+        return is_visible;
+    }
+
+    /** Check whether pairs of points see each other. Results are appended
+     * to the output in the order of the pairs (1 iff the endpoints of the
+     * pair see each other, see line_of_sight()).
+     * @param scene obstacles
+     * @param first iterator of the list of pairs (line segments whose
+     *        endpoints are tested)
+     * @param last iterator of the list of pairs
+     * @param output results
+     */
+    template<typename Vector, typename InputIterator>
+    void lines_of_sight(
+        const visibility_scene<Vector>& scene,
+        InputIterator first,
+        InputIterator last,
+        std::vector<std::uint8_t>& output)
+    {
+        for (; first != last; ++first)
+        {
+            line_segment<Vector> pair = *first;
+            output.push_back(line_of_sight(scene, pair.a, pair.b));
+        }
+    }
+
+    /** Check whether pairs of points see each other in parallel. Pairs
+     * are distributed among workers of the thread pool which steal work
+     * from each other. The output is the same as in the single threaded
+     * version.
+     * @param scene obstacles
+     * @param first random access iterator of the list of pairs (line
+     *        segments whose endpoints are tested)
+     * @param last random access iterator of the list of pairs
+     * @param pool threads which run the queries
+     * @param output results
+     */
+    template<typename Vector, typename RandomAccessIterator>
+    void lines_of_sight(
+        const visibility_scene<Vector>& scene,
+        RandomAccessIterator first,
+        RandomAccessIterator last,
+        thread_pool& pool,
+        std::vector<std::uint8_t>& output)
+    {
+        // each worker writes its own range of the output
+        auto base = output.size();
+        auto count = static_cast<std::size_t>(last - first);
+        output.resize(base + count);
+        pool.parallel_for(count, 256, [&](
+            std::size_t,
+            std::size_t begin,
+            std::size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                line_segment<Vector> pair = first[i];
+                output[base + i] = line_of_sight(scene, pair.a, pair.b);
+            }
+        });
+    }
+}
+
+#endif // GEOMETRY_LINE_OF_SIGHT_HPP_
@@ -0,0 +1,163 @@
+#ifndef GEOMETRY_NODE_POOL_HPP_
+#define GEOMETRY_NODE_POOL_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace geometry
+{
+    /* Free list of fixed size memory blocks.
+     * Memory is allocated in chunks and it is never returned to the system
+     * until the pool is destroyed. Freed blocks are reused by subsequent
+     * allocations. The block size is determined by the first allocation.
+     * Requests of any other size are forwarded to the global operator new.
+     */
+    class node_pool
+    {
+    public:
+        node_pool() = default;
+        node_pool(const node_pool&) = delete;
+        node_pool& operator=(const node_pool&) = delete;
+        node_pool(node_pool&&) = default;
+        node_pool& operator=(node_pool&&) = default;
+
+        /** Allocate a memory block.
+         * @param size of the block in bytes
+         * @return pointer to the block
+         */
+        void* allocate(std::size_t size)
+        {
+            if (block_size_ == 0)
+                block_size_ = round_up(size);
+            if (round_up(size) != block_size_)
+                return ::operator new(size);
+
+            if (free_list_ == nullptr)
+                grow();
+            auto block = free_list_;
+            free_list_ = free_list_->next;
+            return block;
+        }
+
+        /** Return a memory block to the pool.
+         * @param pointer to the block returned by allocate()
+         * @param size of the block in bytes (the same value as in allocate())
+         */
+        void deallocate(void* pointer, std::size_t size)
+        {
+            if (round_up(size) != block_size_)
+            {
+                ::operator delete(pointer);
+                return;
+            }
+
+            auto block = static_cast<free_block*>(pointer);
+            block->next = free_list_;
+            free_list_ = block;
+        }
+
+        /** Allocate memory for at least count blocks in advance.
+         * This has no effect until the block size is known.
+         * @param count number of blocks
+         */
+        void reserve(std::size_t count)
+        {
+            if (block_size_ == 0)
+                return;
+            while (capacity_ < count)
+                grow();
+        }
+
+        /** Number of blocks that this pool owns (free or used)
+         * @return capacity of the pool
+         */
+        std::size_t capacity() const { return capacity_; }
+
+    private:
+        struct free_block
+        {
+            free_block* next;
+        };
+
+        static constexpr std::size_t alignment = alignof(std::max_align_t);
+
+        free_block* free_list_ = nullptr;
+        std::size_t block_size_ = 0;
+        std::size_t capacity_ = 0;
+        std::vector<std::unique_ptr<char[]>> chunks_;
+
+        static std::size_t round_up(std::size_t size)
+        {
+            if (size < sizeof(free_block))
+                size = sizeof(free_block);
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        void grow()
+        {
+            // double the capacity with each chunk
+            auto count = capacity_ < 16 ? 16 : capacity_;
+            chunks_.emplace_back(new char[count * block_size_]);
+            auto memory = chunks_.back().get();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto block = reinterpret_cast<free_block*>(
+                    memory + i * block_size_);
+                block->next = free_list_;
+                free_list_ = block;
+            }
+            capacity_ += count;
+        }
+    };
+
+    /* Standard allocator which allocates single objects from a node_pool.
+     * It is meant to be used with node based containers (std::set, std::map)
+     * so that erased nodes can be reused.
+     */
+    template<typename T>
+    class pool_allocator
+    {
+    public:
+        using value_type = T;
+
+        explicit pool_allocator(node_pool& pool) : pool_(&pool) {}
+
+        template<typename U>
+        pool_allocator(const pool_allocator<U>& other) : pool_(other.pool()) {}
+
+        T* allocate(std::size_t count)
+        {
+            if (count != 1)
+                return static_cast<T*>(::operator new(count * sizeof(T)));
+            return static_cast<T*>(pool_->allocate(sizeof(T)));
+        }
+
+        void deallocate(T* pointer, std::size_t count)
+        {
+            if (count != 1)
+                ::operator delete(pointer);
+            else
+                pool_->deallocate(pointer, sizeof(T));
+        }
+
+        node_pool* pool() const { return pool_; }
+
+        template<typename U>
+        bool operator==(const pool_allocator<U>& other) const
+        {
+            return pool_ == other.pool();
+        }
+
+        template<typename U>
+        bool operator!=(const pool_allocator<U>& other) const
+        {
+            return pool_ != other.pool();
+        }
+    private:
+        node_pool* pool_;
+    };
+}
+
+#endif // GEOMETRY_NODE_POOL_HPP_
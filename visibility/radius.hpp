@@ -0,0 +1,373 @@
+#ifndef GEOMETRY_RADIUS_HPP_
+#define GEOMETRY_RADIUS_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "scene.hpp"
+
+namespace geometry
+{
+    /* Vertex of a visibility polygon limited by a circle around the
+     * observer.
+     */
+    template<typename Vector>
+    struct limited_vertex
+    {
+        Vector point;
+
+        // true iff the edge from this vertex to the next one lies on the
+        // circle (it is an arc or a chord of its polyline approximation)
+        bool is_arc;
+    };
+
+    template<typename Vector>
+    bool approx_equal(limited_vertex<Vector> a, limited_vertex<Vector> b)
+    {
+        return approx_equal(a.point, b.point);
+    }
+
+    // orientation of vertices of a limited polygon (an arc is not 
+    // collinear with any edge so collinear_filter keeps its endpoints)
+    template<typename Vector>
+    orientation compute_orientation(
+        limited_vertex<Vector> a,
+        limited_vertex<Vector> b,
+        limited_vertex<Vector> c)
+    {
+        if (a.is_arc || b.is_arc)
+            return orientation::right_turn;
+        return compute_orientation(a.point, b.point, c.point);
+    }
+
+    /* Circle around the observer which limits a visibility query.
+     * Arcs of the circle are approximated by chords whose distance from
+     * the circle is at most the tolerance. If the tolerance is not
+     * positive, an arc is given by its endpoints only (the first one is
+     * tagged as an arc).
+     */
+    template<typename Vector>
+    class sight_circle
+    {
+    public:
+        /** Create a circle.
+         * @param center position of the observer
+         * @param radius maximal distance of visible points
+         * @param tolerance maximal distance of chords from the circle
+         */
+        sight_circle(Vector center, double radius, double tolerance) :
+            center_(center),
+            radius_(radius),
+            max_step_(tolerance > 0 && tolerance < radius ?
+                2 * std::acos(1 - tolerance / radius) :
+                tolerance > 0 ? pi / 2 : 4 * pi) {}
+
+        // maximal distance of visible points
+        double radius() const { return radius_; }
+
+        /** Check whether a point lies on the circle up to rounding errors.
+         * @param point
+         * @return true iff the distance of the point from the center is
+         *         approximately equal to the radius
+         */
+        bool contains(Vector point) const
+        {
+            auto dir = relative_position(center_, point);
+            auto error = 4 * std::numeric_limits<float>::epsilon() * (
+                std::abs(center_.x) + std::abs(center_.y) + radius_);
+            return std::abs(std::sqrt(length_squared(dir)) - radius_) <= error;
+        }
+
+        /** Find a point on the circle.
+         * @param angle clockwise angle from the positive y axis
+         * @return point on the circle
+         */
+        Vector at(double angle) const
+        {
+            return Vector{
+                static_cast<decltype(center_.x)>(center_.x + radius_ * std::sin(angle)),
+                static_cast<decltype(center_.y)>(center_.y + radius_ * std::cos(angle)) };
+        }
+
+        /** Pass vertices of a polygon from a vertex to a clockwise arc and 
+         * along the arc to a sink (the vertex after the arc is not passed).
+         * @param from the last vertex before the arc (its direction is the
+         *        start of the arc)
+         * @param to the first vertex after the arc (its direction is the end
+         *        of the arc)
+         * @param sink function called with each limited_vertex of the arc
+         */
+        template<typename Sink>
+        void visit_arc(Vector from, Vector to, Sink&& sink) const
+        {
+            auto start_dir = relative_position(center_, from);
+            auto end_dir = relative_position(center_, to);
+            auto start = std::atan2(start_dir.x, start_dir.y);
+            auto sweep = std::atan2(end_dir.x, end_dir.y) - start;
+            if (sweep < 0)
+                sweep += 2 * pi;
+
+            if (contains(from))
+            {
+                sink(limited_vertex<Vector>{ from, true });
+            }
+            else
+            {
+                sink(limited_vertex<Vector>{ from, false });
+                sink(limited_vertex<Vector>{ at(start), true });
+            }
+            auto count = static_cast<std::size_t>(std::ceil(sweep / max_step_));
+            for (std::size_t i = 1; i < count; ++i)
+                sink(limited_vertex<Vector>{ at(start + sweep * i / count), true });
+            if (!contains(to))
+                sink(limited_vertex<Vector>{ at(start + sweep), false });
+        }
+
+        /** Pass vertices of the whole circle to a sink in clockwise order
+         * starting at the positive y axis.
+         * @param sink function called with each limited_vertex of the circle
+         */
+        template<typename Sink>
+        void visit_circle(Sink&& sink) const
+        {
+            auto count = std::max<std::size_t>(2,
+                static_cast<std::size_t>(std::ceil(2 * pi / max_step_)));
+            for (std::size_t i = 0; i < count; ++i)
+                sink(limited_vertex<Vector>{ at(2 * pi * i / count), true });
+        }
+
+        /** Clip a line segment to the disc.
+         * @param segment line segment
+         * @param out_segment part of the line segment in the disc
+         * @return false if the line segment does not intersect the disc
+         */
+        bool clip(const line_segment<Vector>& segment, line_segment<Vector>& out_segment) const
+        {
+            // solve |a + t * dir - center| = radius for t in [0, 1]
+            auto a = relative_position(center_, segment.a);
+            auto dir = relative_position(segment.a, segment.b);
+            auto qa = dot(dir, dir);
+            auto qb = dot(a, dir);
+            auto qc = dot(a, a) - radius_ * radius_;
+            auto discriminant = qb * qb - qa * qc;
+            if (discriminant < 0 || qa == 0)
+                return false;
+            auto root = std::sqrt(discriminant);
+            auto t0 = std::max(0.0, (-qb - root) / qa);
+            auto t1 = std::min(1.0, (-qb + root) / qa);
+            if (t0 > t1)
+                return false;
+
+            out_segment = segment;
+            if (t0 > 0)
+                out_segment.a = point_at(segment.a, dir, t0);
+            if (t1 < 1)
+                out_segment.b = point_at(segment.a, dir, t1);
+            return true;
+        }
+
+    private:
+        static constexpr double pi = 3.14159265358979323846;
+
+        Vector center_;
+        double radius_;
+
+        // maximal angle of a chord
+        double max_step_;
+
+        static Vector point_at(Vector origin, vector2<double> dir, double t)
+        {
+            return Vector{
+                static_cast<decltype(origin.x)>(origin.x + dir.x * t),
+                static_cast<decltype(origin.y)>(origin.y + dir.y * t) };
+        }
+    };
+
+    /** Calculate visibility polygon limited by a circle around the observer
+     * and pass its vertices in clockwise order to a sink function. Only line
+     * segments in cells of the scene grid which intersect the disc are
+     * considered and they are clipped to the disc before their events are
+     * sorted, so the cost of the query depends on the number of line
+     * segments near the observer. Collinear vertices are removed.
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param max_distance radius of the circle
+     * @param tolerance maximal distance of chords which approximate arcs of
+     *        the circle from the circle (if it is not positive, arcs are
+     *        given by their endpoints only)
+     * @param workspace buffers used by the algorithm
+     * @param sink function which is called with each limited_vertex of the
+     *        visibility polygon
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State,
+        typename Sink>
+    void visit_visibility_polygon(
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        double max_distance,
+        double tolerance,
+        visibility_workspace<Vector, State>& workspace,
+        Sink sink)
+    {
+        visit_visibility_polygon(scene, scene.grid(), point, max_distance,
+            tolerance, workspace, sink);
+    }
+
+    /** Calculate visibility polygon limited by a circle around the observer
+     * (see visit_visibility_polygon()) with line segments found by another
+     * spatial index of the scene.
+     * @param scene obstacles
+     * @param spatial_index index of scene.segments() with a method
+     *        visit_disc(center, radius, function) (e.g., segment_bvh)
+     * @param point position of the observer
+     * @param max_distance radius of the circle
+     * @param tolerance maximal distance of chords which approximate arcs of
+     *        the circle from the circle (if it is not positive, arcs are
+     *        given by their endpoints only)
+     * @param workspace buffers used by the algorithm
+     * @param sink function which is called with each limited_vertex of the
+     *        visibility polygon
+     */
+    template<
+        typename Vector,
+        typename Index,
+        template<typename, typename> class State,
+        typename Sink>
+    void visit_visibility_polygon(
+        const visibility_scene<Vector>& scene,
+        const Index& spatial_index,
+        Vector point,
+        double max_distance,
+        double tolerance,
+        visibility_workspace<Vector, State>& workspace,
+        Sink sink)
+    {
+        using vertex_type = limited_vertex<Vector>;
+        sight_circle<Vector> circle{ point, max_distance, tolerance };
+
+        auto&& segments = scene.segments();
+        auto&& lines = scene.lines();
+        workspace.clear();
+        spatial_index.visit_disc(point, max_distance, [&](std::uint32_t index)
+        {
+            line_segment<Vector> clipped;
+            if (circle.clip(segments[index], clipped) &&
+                !approx_equal(clipped.a, clipped.b))
+            {
+                add_obstacle(point, clipped, lines[index].side(point), workspace);
+            }
+        });
+        if (workspace.events.size() == 0)
+        {
+            circle.visit_circle(sink);
+            return;
+        }
+
+        sort_obstacles(workspace);
+        prepare_sweep(point, workspace);
+
+        collinear_filter<vertex_type, Sink> vertices{ sink };
+        auto& state = workspace.state;
+        if (!state.empty())
+        {
+            auto&& nearest_segment = workspace.segments[state.front()];
+            vertices.set_closing_point(vertex_type{
+                nearest_segment.a.x < nearest_segment.b.x ?
+                nearest_segment.a : nearest_segment.b, false });
+        }
+
+        // The state is empty between an end vertex and the next start
+        // vertex iff rays between them do not hit any line segment in the
+        // disc, i.e. the polygon follows the circle. This is not a gap if
+        // both are the same vertex.
+        auto&& prepared = workspace.prepared;
+        auto last_end = no_segment, first_start = no_segment;
+        Vector last_end_point, first_start_point;
+        auto close_gap = [&](Vector next_point, std::uint32_t next_start)
+        {
+            auto is_ray = key_angle(angle_key(point, last_end_point)) ==
+                key_angle(angle_key(point, next_point));
+            if (last_end == next_start || is_ray)
+                vertices.push(vertex_type{ last_end_point, false });
+            else
+                circle.visit_arc(last_end_point, next_point,
+                    [&vertices](vertex_type vertex) { vertices.push(vertex); });
+        };
+        run_sweep(point, workspace, [&](
+            const Vector& vertex,
+            std::uint32_t ref,
+            std::uint32_t)
+        {
+            if (!state.empty())
+            {
+                vertices.push(vertex_type{ vertex, false });
+            }
+            else if (is_end_vertex(ref))
+            {
+                last_end = prepared[event_segment(ref)].end;
+                last_end_point = vertex;
+            }
+            else
+            {
+                auto start = prepared[event_segment(ref)].start;
+                if (last_end == no_segment)
+                {
+                    first_start = start;
+                    first_start_point = vertex;
+                }
+                else
+                {
+                    close_gap(vertex, start);
+                }
+                vertices.push(vertex_type{ vertex, false });
+                last_end = no_segment;
+            }
+        });
+
+        // the gap which contains the positive y axis
+        if (last_end != no_segment)
+            close_gap(first_start_point, first_start);
+        vertices.finish();
+    }
+
+    /** Calculate visibility polygon limited by a circle around the observer
+     * (see visit_visibility_polygon()) and write its vertices in clockwise
+     * order to an output iterator.
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param max_distance radius of the circle
+     * @param tolerance maximal distance of chords which approximate arcs of
+     *        the circle from the circle (if it is not positive, arcs are
+     *        given by their endpoints only)
+     * @param workspace buffers used by the algorithm
+     * @param out output iterator where limited_vertex values are written
+     * @return output iterator past the last written vertex
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State,
+        typename OutputIterator>
+    OutputIterator visibility_polygon(
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        double max_distance,
+        double tolerance,
+        visibility_workspace<Vector, State>& workspace,
+        OutputIterator out)
+    {
+        visit_visibility_polygon(scene, point, max_distance, tolerance, workspace,
+            [&out](const limited_vertex<Vector>& vertex) { *out++ = vertex; });
+        return out;
+    }
+}
+
+#endif // GEOMETRY_RADIUS_HPP_
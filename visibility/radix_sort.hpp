@@ -0,0 +1,96 @@
+#ifndef GEOMETRY_RADIX_SORT_HPP_
+#define GEOMETRY_RADIX_SORT_HPP_
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace geometry
+{
+    /** Sort values by unsigned integer keys using LSD radix sort.
+     * Keys and values are stored in separate arrays (keys[i] is the key of
+     * values[i]) and both arrays are permuted. The sort is stable and it
+     * runs in O(n) time. It uses 11-bit digits and skips digits which are
+     * the same for all keys (e.g. high bits of floating point numbers from
+     * a small range).
+     * @param keys to sort
+     * @param values permuted along with the keys
+     * @param key_buffer temporary storage for keys
+     * @param value_buffer temporary storage for values (content of both
+     *        buffers is unspecified after the call, they are swapped with the
+     *        arrays if the sorted sequence ends up in the buffers)
+     * @param first_bit index of the least significant bit of keys used for
+     *        sorting (lower bits are ignored)
+     * @param last_bit index of the bit after the most significant bit used
+     *        for sorting (higher bits have to be 0)
+     */
+    template<typename Key, typename Value>
+    void radix_sort(
+        std::vector<Key>& keys,
+        std::vector<Value>& values,
+        std::vector<Key>& key_buffer,
+        std::vector<Value>& value_buffer,
+        std::size_t first_bit = 0,
+        std::size_t last_bit = 8 * sizeof(Key))
+    {
+        constexpr std::size_t digit_bits = 11;
+        constexpr std::size_t max_digit_count =
+            (8 * sizeof(Key) + digit_bits - 1) / digit_bits;
+        constexpr std::size_t radix = 1 << digit_bits;
+        auto digit_count = (last_bit - first_bit + digit_bits - 1) / digit_bits;
+
+        // compute histograms of all digits in one pass
+        std::array<std::array<std::uint32_t, radix>, max_digit_count> histograms{};
+        for (auto&& key : keys)
+        {
+            for (std::size_t d = 0; d < digit_count; ++d)
+            {
+                auto shift = first_bit + d * digit_bits;
+                ++histograms[d][(key >> shift) & (radix - 1)];
+            }
+        }
+
+        key_buffer.resize(keys.size());
+        value_buffer.resize(values.size());
+        for (std::size_t d = 0; d < digit_count; ++d)
+        {
+            auto&& histogram = histograms[d];
+
+            // skip the digit if it is the same for all keys
+            auto is_constant = false;
+            for (auto&& count : histogram)
+            {
+                if (count == keys.size())
+                    is_constant = true;
+                if (count != 0)
+                    break;
+            }
+            if (is_constant || keys.empty())
+                continue;
+
+            // prefix sums
+            std::uint32_t offset = 0;
+            for (auto&& count : histogram)
+            {
+                auto bucket_size = count;
+                count = offset;
+                offset += bucket_size;
+            }
+
+            auto shift = first_bit + d * digit_bits;
+            for (std::size_t i = 0; i < keys.size(); ++i)
+            {
+                auto digit = (keys[i] >> shift) & (radix - 1);
+                auto position = histogram[digit]++;
+                key_buffer[position] = keys[i];
+                value_buffer[position] = values[i];
+            }
+            std::swap(keys, key_buffer);
+            std::swap(values, value_buffer);
+        }
+    }
+}
+
+#endif // GEOMETRY_RADIX_SORT_HPP_
@@ -0,0 +1,227 @@
+#ifndef GEOMETRY_REGION_HPP_
+#define GEOMETRY_REGION_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+
+namespace geometry
+{
+    /* Visibility polygon prepared for point queries. The polygon is star-
+     * shaped around the observer, so its vertices sorted by angle around
+     * the observer split the plane into wedges with one edge each. A query
+     * finds the wedge of a direction by binary search on pseudo-angles of
+     * the vertices (see angle_key()) and tests the edge: O(log k) for k
+     * vertices instead of O(k) for a general point in polygon test.
+     */
+    template<typename Vector>
+    class visibility_region
+    {
+    public:
+        visibility_region() {}
+
+        /** Prepare a visibility polygon.
+         * @param observer position of the observer
+         * @param first iterator of the list of vertices of the visibility
+         *        polygon of the observer in clockwise order
+         * @param last iterator of the list of vertices
+         */
+        template<typename InputIterator>
+        visibility_region(Vector observer, InputIterator first, InputIterator last)
+        {
+            assign(observer, first, last);
+        }
+
+        /** Replace the polygon (buffers of the region are reused).
+         * @param observer position of the observer
+         * @param first iterator of the list of vertices of the visibility
+         *        polygon of the observer in clockwise order
+         * @param last iterator of the list of vertices
+         */
+        template<typename InputIterator>
+        void assign(Vector observer, InputIterator first, InputIterator last)
+        {
+            observer_ = observer;
+            vertices_.assign(first, last);
+            angles_.clear();
+            if (vertices_.size() < 3)
+            {
+                vertices_.clear();
+                return;
+            }
+
+            // a vertex on the positive y axis can have an angle just under 4
+            // due to rounding, it belongs to the start of the polygon
+            for (auto&& vertex : vertices_)
+            {
+                auto angle = pseudo_angle(relative_position(observer_, vertex));
+                angles_.push_back(angle > 4 - angle_tolerance ? 0 : angle);
+            }
+
+            // start at the vertex after the largest decrease of the angle
+            // (the polygon crosses the positive y axis there)
+            std::size_t start = 0;
+            double max_decrease = 0;
+            for (std::size_t i = 0; i < angles_.size(); ++i)
+            {
+                auto previous = angles_[i == 0 ? angles_.size() - 1 : i - 1];
+                if (previous - angles_[i] > max_decrease)
+                {
+                    max_decrease = previous - angles_[i];
+                    start = i;
+                }
+            }
+            std::rotate(vertices_.begin(), vertices_.begin() + start, vertices_.end());
+            std::rotate(angles_.begin(), angles_.begin() + start, angles_.end());
+
+            // vertices on one ray can be out of order due to rounding
+            for (std::size_t i = 1; i < angles_.size(); ++i)
+                angles_[i] = std::max(angles_[i], angles_[i - 1]);
+        }
+
+        // position of the observer
+        Vector observer() const { return observer_; }
+
+        // vertices of the polygon in clockwise order starting at the
+        // positive y axis
+        const std::vector<Vector>& vertices() const { return vertices_; }
+
+        // number of vertices
+        std::size_t size() const { return vertices_.size(); }
+
+        // check whether the region has no vertices
+        bool empty() const { return vertices_.empty(); }
+
+        /** Check whether a point is in the region. Points on the boundary
+         * are in the region, including points on a ray through vertices of
+         * the polygon which are not farther than the farthest of them (up to
+         * the angle tolerance).
+         * @param point
+         * @return true iff the point is visible from the observer
+         */
+        bool contains(Vector point) const
+        {
+            if (vertices_.empty())
+                return false;
+
+            auto dir = relative_position(observer_, point);
+            if (length_squared(dir) == 0)
+                return true;
+
+            // the edge is a clockwise turn around the observer so the region
+            // is on the right side
+            auto edge = find_edge(dir);
+            auto a = relative_position(observer_, vertices_[edge]);
+            auto b = relative_position(observer_, vertices_[next(edge)]);
+            if (cross(b - a, dir - a) <= 0)
+                return true;
+
+            auto vertex = farthest_vertex(dir);
+            return vertex < vertices_.size() && length_squared(dir) <=
+                length_squared(relative_position(observer_, vertices_[vertex]));
+        }
+
+        /** Find the point where a ray from the observer leaves the region.
+         * A ray through vertices of the polygon (up to the angle tolerance)
+         * leaves it at the farthest of them or farther.
+         * @param direction of the ray
+         * @return the nearest point on the boundary in the direction (the
+         *         observer if the region is empty or the direction is 0)
+         */
+        Vector ray_hit(vector2<double> direction) const
+        {
+            if (vertices_.empty() || length_squared(direction) == 0)
+                return observer_;
+
+            auto edge = find_edge(direction);
+            auto a = relative_position(observer_, vertices_[edge]);
+            auto b = relative_position(observer_, vertices_[next(edge)]);
+            auto denominator = cross(direction, b - a);
+            auto offset = denominator == 0 ?
+                a : direction * (cross(a, b - a) / denominator);
+
+            auto vertex = farthest_vertex(direction);
+            if (vertex < vertices_.size())
+            {
+                auto position = relative_position(observer_, vertices_[vertex]);
+                if (length_squared(position) > length_squared(offset))
+                    return vertices_[vertex];
+            }
+            return Vector{
+                static_cast<decltype(observer_.x)>(observer_.x + offset.x),
+                static_cast<decltype(observer_.y)>(observer_.y + offset.y) };
+        }
+
+    private:
+        Vector observer_;
+        std::vector<Vector> vertices_;
+
+        // pseudo-angles of the vertices (non-decreasing)
+        std::vector<double> angles_;
+
+        // vertices whose pseudo-angles differ by less than this are on one
+        // ray from the observer (endpoints of a shadow edge computed in
+        // float precision are not exactly on one ray)
+        static constexpr double angle_tolerance = 1e-6;
+
+        std::size_t next(std::size_t index) const
+        {
+            return index + 1 == vertices_.size() ? 0 : index + 1;
+        }
+
+        // find index of the farthest vertex in the direction of a ray up to
+        // the angle tolerance or size() if there is none (the window of
+        // angles wraps around the positive y axis)
+        std::size_t farthest_vertex(vector2<double> direction) const
+        {
+            auto angle = pseudo_angle(direction);
+            auto result = vertices_.size();
+            double max_distance = 0;
+            auto visit = [&](double low, double high)
+            {
+                auto first = std::lower_bound(angles_.begin(), angles_.end(), low);
+                for (auto it = first; it != angles_.end() && *it <= high; ++it)
+                {
+                    auto index = static_cast<std::size_t>(it - angles_.begin());
+                    auto distance = length_squared(relative_position(observer_, vertices_[index]));
+                    if (result == vertices_.size() || distance > max_distance)
+                    {
+                        result = index;
+                        max_distance = distance;
+                    }
+                }
+            };
+
+            visit(angle - angle_tolerance, angle + angle_tolerance);
+            if (angle + angle_tolerance >= 4)
+                visit(0, angle + angle_tolerance - 4);
+            if (angle - angle_tolerance < 0)
+                visit(angle - angle_tolerance + 4, 4);
+            return result;
+        }
+
+        // find index of the first vertex of the edge in a direction
+        std::size_t find_edge(vector2<double> direction) const
+        {
+            auto angle = pseudo_angle(direction);
+            auto it = std::upper_bound(angles_.begin(), angles_.end(), angle);
+            if (it == angles_.begin())
+                return vertices_.size() - 1;
+            return static_cast<std::size_t>(it - angles_.begin()) - 1;
+        }
+
+        // clockwise pseudo-angle from the positive y axis in [0, 4)
+        static double pseudo_angle(vector2<double> dir)
+        {
+            auto ratio = dir.y / (std::abs(dir.x) + std::abs(dir.y));
+            return dir.x < 0 ? 3 + ratio : 1 - ratio;
+        }
+    };
+}
+
+#endif // GEOMETRY_REGION_HPP_
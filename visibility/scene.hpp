@@ -0,0 +1,276 @@
+#ifndef GEOMETRY_SCENE_HPP_
+#define GEOMETRY_SCENE_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "grid.hpp"
+
+namespace geometry
+{
+    /* Equation of the supporting line of a line segment in double precision.
+     * value(p) = dot(normal, p) + offset is positive iff (p, a, b) is a left
+     * turn where a and b are endpoints of the line segment.
+     */
+    struct line_equation
+    {
+        vector2<double> normal;
+        double offset;
+
+        /** Evaluate the equation at a point.
+         * @param point
+         * @return signed distance of the point from the line multiplied by
+         *         length of the line segment
+         */
+        template<typename Vector>
+        double value(Vector point) const
+        {
+            return normal.x * point.x + normal.y * point.y + offset;
+        }
+
+        /** Bound of the rounding error of value(point).
+         * @param point
+         * @return values with smaller absolute value can not be
+         *         distinguished from 0 in single precision
+         */
+        template<typename Vector>
+        double tolerance(Vector point) const
+        {
+            return 4 * std::numeric_limits<float>::epsilon() * (
+                std::abs(normal.x * point.x) +
+                std::abs(normal.y * point.y) +
+                std::abs(offset));
+        }
+
+        /** Determine orientation of a point and endpoints of the line segment.
+         * @param point
+         * @return orientation of (point, a, b) where values close to 0 are
+         *         considered collinear
+         */
+        template<typename Vector>
+        orientation side(Vector point) const
+        {
+            auto result = value(point);
+            if (std::abs(result) <= tolerance(point))
+                return orientation::collinear;
+            return result > 0 ? orientation::left_turn : orientation::right_turn;
+        }
+    };
+
+    /** Compute equation of the supporting line of a line segment.
+     * @param segment line segment
+     * @return equation whose value at p is positive iff (p, a, b) is a
+     *         left turn
+     */
+    template<typename Vector>
+    line_equation make_line_equation(const line_segment<Vector>& segment)
+    {
+        double ax = segment.a.x, ay = segment.a.y;
+        double bx = segment.b.x, by = segment.b.y;
+        return line_equation{
+            vector2<double>{ ay - by, bx - ax },
+            ax * by - ay * bx };
+    }
+
+    /* Immutable set of obstacles preprocessed for visibility queries.
+     * Approximately equal endpoints of line segments are welded into one
+     * vertex and degenerate line segments are removed. The scene keeps
+     * equation of the supporting line of each line segment and a uniform
+     * grid of line segments. A scene can be queried from multiple threads at
+     * once (each thread needs its own workspace).
+     */
+    template<typename Vector>
+    class visibility_scene
+    {
+    public:
+        using segment_type = line_segment<Vector>;
+
+        // line segment given by indices of its endpoints in vertices()
+        struct segment_record
+        {
+            std::uint32_t a, b;
+        };
+
+        visibility_scene() {}
+
+        /** Build a scene.
+         * @param begin iterator of the list of line segments (obstacles)
+         * @param end iterator of the list of line segments (obstacles)
+         */
+        template<typename InputIterator>
+        visibility_scene(InputIterator begin, InputIterator end)
+        {
+            std::vector<segment_type> input(begin, end);
+            weld(input);
+
+            lines_.reserve(segments_.size());
+            for (auto&& segment : segments_)
+                lines_.push_back(make_line_equation(segment));
+
+            grid_ = uniform_grid<Vector>{ segments_ };
+        }
+
+        // number of line segments
+        std::size_t size() const { return segments_.size(); }
+
+        // welded endpoints of line segments
+        const std::vector<Vector>& vertices() const { return vertices_; }
+
+        // line segments with welded endpoints
+        const std::vector<segment_type>& segments() const { return segments_; }
+
+        // indices of endpoints of line segments
+        const std::vector<segment_record>& records() const { return records_; }
+
+        // equations of supporting lines of line segments
+        const std::vector<line_equation>& lines() const { return lines_; }
+
+        // spatial index of line segments
+        const uniform_grid<Vector>& grid() const { return grid_; }
+
+    private:
+        std::vector<Vector> vertices_;
+        std::vector<segment_type> segments_;
+        std::vector<segment_record> records_;
+        std::vector<line_equation> lines_;
+        uniform_grid<Vector> grid_;
+
+        // find a vertex approximately equal to a point which is not less
+        // than any vertex in the lexicographic order or return the number of
+        // vertices if there is none
+        std::size_t find_vertex(Vector point) const
+        {
+            using scalar = decltype(point.y);
+
+            // vertices with approximately equal x coordinate are at the end
+            // of the list. They form a few runs with equal x coordinate,
+            // each sorted by y, so other points in between do not hide them.
+            auto limit = 2 * std::abs(point.y) * std::numeric_limits<scalar>::epsilon();
+            auto last = vertices_.end();
+            while (last != vertices_.begin() && approx_equal((last - 1)->x, point.x))
+            {
+                auto x = (last - 1)->x;
+                auto first = std::partition_point(vertices_.begin(), last,
+                    [x](const Vector& vertex) { return vertex.x < x; });
+                auto it = std::partition_point(first, last,
+                    [&](const Vector& vertex) { return vertex.y < point.y - limit; });
+                for (; it != last && it->y <= point.y + limit; ++it)
+                {
+                    if (approx_equal(*it, point))
+                        return static_cast<std::size_t>(it - vertices_.begin());
+                }
+                last = first;
+            }
+            return vertices_.size();
+        }
+
+        void weld(const std::vector<segment_type>& input)
+        {
+            // sort endpoints lexicographically and merge approximately
+            // equal points
+            std::vector<std::uint32_t> order(2 * input.size());
+            for (std::size_t i = 0; i < order.size(); ++i)
+                order[i] = static_cast<std::uint32_t>(i);
+            auto endpoint = [&input](std::uint32_t i)
+            {
+                return i & 1 ? input[i >> 1].b : input[i >> 1].a;
+            };
+            std::sort(order.begin(), order.end(), [&](auto i, auto j)
+            {
+                auto p = endpoint(i), q = endpoint(j);
+                return p.x < q.x || (p.x == q.x && p.y < q.y);
+            });
+
+            std::vector<std::uint32_t> vertex_of(order.size());
+            for (auto i : order)
+            {
+                auto point = endpoint(i);
+                auto vertex = find_vertex(point);
+                if (vertex == vertices_.size())
+                    vertices_.push_back(point);
+                vertex_of[i] = static_cast<std::uint32_t>(vertex);
+            }
+
+            for (std::size_t i = 0; i < input.size(); ++i)
+            {
+                segment_record record{ vertex_of[2 * i], vertex_of[2 * i + 1] };
+                if (record.a == record.b)
+                    continue; // degenerate line segment
+                records_.push_back(record);
+                segments_.emplace_back(vertices_[record.a], vertices_[record.b]);
+            }
+        }
+    };
+
+    /** Calculate visibility polygon in a scene and pass its vertices in
+     * clockwise order to a sink function. Collinear vertices are removed.
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param workspace buffers used by the algorithm
+     * @param sink function which is called with each vertex of the
+     *        visibility polygon
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State,
+        typename Sink>
+    void visit_visibility_polygon(
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        visibility_workspace<Vector, State>& workspace,
+        Sink sink)
+    {
+        auto&& segments = scene.segments();
+        auto&& lines = scene.lines();
+        workspace.clear();
+        for (std::size_t i = 0; i < segments.size(); ++i)
+            add_obstacle(point, segments[i], lines[i].side(point), workspace);
+        sweep_obstacles(point, workspace, sink);
+    }
+
+    /** Calculate visibility polygon vertices in a scene in clockwise order.
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param workspace buffers used by the algorithm
+     * @return vertices of the visibility polygon (reference to a buffer in
+     *         the workspace which is valid until the next query)
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    const std::vector<Vector>& visibility_polygon(
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        auto& vertices = workspace.vertices;
+        vertices.clear();
+        visit_visibility_polygon(scene, point, workspace,
+            [&vertices](const Vector& vertex) { vertices.push_back(vertex); });
+        return vertices;
+    }
+
+    /** Calculate visibility polygon vertices in a scene in clockwise order.
+     * @param scene obstacles
+     * @param point position of the observer
+     * @return vertices of the visibility polygon
+     */
+    template<typename Vector>
+    std::vector<Vector> visibility_polygon(
+        const visibility_scene<Vector>& scene,
+        Vector point)
+    {
+        visibility_workspace<Vector> workspace;
+        visibility_polygon(scene, point, workspace);
+        return std::move(workspace.vertices);
+    }
+}
+
+#endif // GEOMETRY_SCENE_HPP_
@@ -0,0 +1,798 @@
+#ifndef GEOMETRY_SWEEP_STATE_HPP_
+#define GEOMETRY_SWEEP_STATE_HPP_
+
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <memory>
+#include <iterator>
+
+#include "node_pool.hpp"
+
+namespace geometry
+{
+    /* Sweep line state containers.
+     *
+     * All containers in this header are ordered sets of unique ids (small
+     * non-negative integers, e.g. indices of line segments) with the same
+     * interface:
+     * - reset(cmp)    remove all values and set a new comparator
+     * - insert(value) insert value unless there is an equivalent value
+     *                 (returns true iff the value has been inserted)
+     * - erase(value)  remove a value equivalent to value (returns number of
+     *                 removed values)
+     * - erase_id(id)  remove exactly the value id if it is in the container.
+     *                 Containers remember where each id has been stored so 
+     *                 this does not call the comparator.
+     * - assign_sorted(first, last) 
+     *                 replace the content with values from a range sorted in
+     *                 ascending order without equivalent values. Containers
+     *                 are built in linear time.
+     * - front()       the least value
+     * - empty(), size()
+     * Memory of a container is reused after reset() so that a container
+     * which is kept between queries does not allocate in steady state.
+     */
+
+    /* Red-black tree (std::set) with nodes allocated from a node pool. */
+    template<typename T, typename Compare>
+    class tree_state
+    {
+    public:
+        using value_type = T;
+        using compare_type = Compare;
+
+        tree_state() : tree_state(Compare{}) {}
+
+        explicit tree_state(Compare cmp) :
+            pool_(new node_pool()),
+            set_(cmp, pool_allocator<T>{ *pool_ })
+        {
+        }
+
+        void reset(Compare cmp)
+        {
+            for (auto&& value : set_)
+                handles_[value].is_valid = false;
+            set_ = set_type(cmp, pool_allocator<T>{ *pool_ });
+        }
+
+        template<typename InputIterator>
+        void assign_sorted(InputIterator first, InputIterator last)
+        {
+            reset(set_.key_comp());
+
+            // insertion at the end with a hint takes amortized constant time
+            for (; first != last; ++first)
+            {
+                auto value = *first;
+                if (static_cast<std::size_t>(value) >= handles_.size())
+                    handles_.resize(value + 1);
+                handles_[value] = handle{ set_.insert(set_.end(), value), true };
+            }
+        }
+
+        bool insert(const T& value) 
+        { 
+            auto result = set_.insert(value);
+            if (result.second)
+            {
+                if (static_cast<std::size_t>(value) >= handles_.size())
+                    handles_.resize(value + 1);
+                handles_[value] = handle{ result.first, true };
+            }
+            return result.second;
+        }
+
+        std::size_t erase(const T& value) 
+        { 
+            auto it = set_.find(value);
+            if (it == set_.end())
+                return 0;
+            handles_[*it].is_valid = false;
+            set_.erase(it);
+            return 1;
+        }
+
+        std::size_t erase_id(const T& id)
+        {
+            if (static_cast<std::size_t>(id) >= handles_.size() || 
+                !handles_[id].is_valid)
+                return 0;
+            set_.erase(handles_[id].position);
+            handles_[id].is_valid = false;
+            return 1;
+        }
+
+        const T& front() const { return *set_.begin(); }
+        bool empty() const { return set_.empty(); }
+        std::size_t size() const { return set_.size(); }
+
+    private:
+        using set_type = std::set<T, Compare, pool_allocator<T>>;
+
+        struct handle
+        {
+            typename set_type::iterator position;
+            bool is_valid = false;
+        };
+
+        // the pool has to have a stable address as it is referenced by the
+        // allocator of the set (the state can be moved)
+        std::unique_ptr<node_pool> pool_;
+        set_type set_;
+
+        // position of each id in the set
+        std::vector<handle> handles_;
+    };
+
+    /* Sorted array. Values are stored in descending order so that the least
+     * value (the nearest line segment) is at the end of the array. Insertion
+     * and removal are linear, but with very small constant. This is the
+     * fastest container for small states.
+     */
+    template<typename T, typename Compare>
+    class flat_state
+    {
+    public:
+        using value_type = T;
+        using compare_type = Compare;
+
+        flat_state() : flat_state(Compare{}) {}
+        explicit flat_state(Compare cmp) : cmp_(cmp) {}
+
+        void reset(Compare cmp)
+        {
+            cmp_ = cmp;
+            values_.clear();
+        }
+
+        template<typename InputIterator>
+        void assign_sorted(InputIterator first, InputIterator last)
+        {
+            values_.assign(first, last);
+            std::reverse(values_.begin(), values_.end());
+        }
+
+        bool insert(const T& value)
+        {
+            auto it = lower_bound(value);
+            if (it != values_.end() && !cmp_(*it, value))
+                return false;
+            values_.insert(it, value);
+            return true;
+        }
+
+        std::size_t erase(const T& value)
+        {
+            auto it = lower_bound(value);
+            if (it == values_.end() || cmp_(*it, value))
+                return 0;
+            values_.erase(it);
+            return 1;
+        }
+
+        std::size_t erase_id(const T& id)
+        {
+            // the array is small, a linear search is faster than keeping 
+            // track of positions which change with every insertion
+            auto it = std::find(values_.rbegin(), values_.rend(), id);
+            if (it == values_.rend())
+                return 0;
+            values_.erase(std::next(it).base());
+            return 1;
+        }
+
+        const T& front() const { return values_.back(); }
+        bool empty() const { return values_.empty(); }
+        std::size_t size() const { return values_.size(); }
+
+        /** Values in descending order.
+         * @return reference to the array of values
+         */
+        const std::vector<T>& values() const { return values_; }
+
+    private:
+        Compare cmp_;
+        std::vector<T> values_;
+
+        // find the first value which is not greater than given value
+        typename std::vector<T>::iterator lower_bound(const T& value)
+        {
+            return std::lower_bound(values_.begin(), values_.end(), value,
+                [this](const T& a, const T& b) { return cmp_(b, a); });
+        }
+    };
+
+    /* B-tree with nodes stored in a single array. Each value is stored in
+     * the tree exactly once (unlike a B+ tree), hence the comparator is only
+     * ever called with values that are currently in the container. This is
+     * required by the line segment comparator which is only valid for line
+     * segments intersected by the sweep line.
+     * The tree keeps the node of each id so that erase_id() only scans one
+     * node and rebalances the tree using parent links.
+     */
+    template<typename T, typename Compare>
+    class btree_state
+    {
+    public:
+        using value_type = T;
+        using compare_type = Compare;
+
+        // minimal number of children of an inner node (except the root)
+        static constexpr std::size_t min_degree = sizeof(T) <= 8 ? 16 : 8;
+        static constexpr std::size_t max_keys = 2 * min_degree - 1;
+        static constexpr std::size_t min_keys = min_degree - 1;
+
+        btree_state() : btree_state(Compare{}) {}
+        explicit btree_state(Compare cmp) : cmp_(cmp) { clear(); }
+
+        void reset(Compare cmp)
+        {
+            for (auto&& n : nodes_)
+            {
+                for (std::size_t i = 0; i < n.count; ++i)
+                    node_of_[n.keys[i]] = nil;
+            }
+            cmp_ = cmp;
+            clear();
+        }
+
+        template<typename InputIterator>
+        void assign_sorted(InputIterator first, InputIterator last)
+        {
+            reset(cmp_);
+            level_keys_.assign(first, last);
+            if (level_keys_.empty())
+                return;
+            auto max_value = *std::max_element(level_keys_.begin(), level_keys_.end());
+            if (static_cast<std::size_t>(max_value) >= node_of_.size())
+                node_of_.resize(max_value + 1, nil);
+            size_ = level_keys_.size();
+            
+            // Build the tree bottom up. Keys of each level are split into 
+            // nodes of (almost) equal size. Keys between these nodes form 
+            // the next level.
+            level_nodes_.clear();
+            auto is_leaf = true;
+            for (;;)
+            {
+                auto count = level_keys_.size();
+                auto node_count = (count + max_keys + 1) / (max_keys + 1);
+                if (node_count == 0)
+                    node_count = 1;
+                auto node_size = (count - (node_count - 1)) / node_count;
+                auto remainder = (count - (node_count - 1)) % node_count;
+
+                next_keys_.clear();
+                next_nodes_.clear();
+                std::size_t key = 0, child = 0;
+                for (std::size_t i = 0; i < node_count; ++i)
+                {
+                    // the first leaf never changes
+                    auto index = is_leaf && i == 0 ? 
+                        first_leaf_ : make_node(is_leaf, nil);
+                    auto&& n = nodes_[index];
+                    n.count = static_cast<std::uint32_t>(
+                        node_size + (i < remainder ? 1 : 0));
+                    for (std::size_t j = 0; j < n.count; ++j)
+                        set_key(index, j, level_keys_[key++]);
+                    if (!is_leaf)
+                    {
+                        for (std::size_t j = 0; j <= n.count; ++j)
+                        {
+                            n.children[j] = level_nodes_[child++];
+                            nodes_[n.children[j]].parent = index;
+                        }
+                    }
+
+                    next_nodes_.push_back(index);
+                    if (i + 1 < node_count)
+                        next_keys_.push_back(level_keys_[key++]);
+                }
+
+                std::swap(level_keys_, next_keys_);
+                std::swap(level_nodes_, next_nodes_);
+                is_leaf = false;
+                if (level_nodes_.size() == 1)
+                    break;
+            }
+            root_ = level_nodes_[0];
+        }
+
+        /** Copy all values to an output iterator in ascending order.
+         * @param out output iterator
+         * @return output iterator past the last copied value
+         */
+        template<typename OutputIterator>
+        OutputIterator copy_sorted(OutputIterator out) const
+        {
+            return size_ == 0 ? out : copy_sorted(root_, out);
+        }
+
+        bool insert(const T& value)
+        {
+            if (static_cast<std::size_t>(value) >= node_of_.size())
+                node_of_.resize(value + 1, nil);
+
+            // find a leaf
+            auto current = root_;
+            for (;;)
+            {
+                auto&& n = nodes_[current];
+                auto i = lower_bound(n, value);
+                if (i < n.count && !cmp_(value, n.keys[i]))
+                    return false; // there is an equivalent value
+                if (n.leaf)
+                {
+                    insert_at(current, i, value, nil);
+                    break;
+                }
+                current = n.children[i];
+            }
+
+            ++size_;
+            split_overflow(current);
+            return true;
+        }
+
+        std::size_t erase(const T& value)
+        {
+            auto current = root_;
+            for (;;)
+            {
+                auto&& n = nodes_[current];
+                auto i = lower_bound(n, value);
+                if (i < n.count && !cmp_(value, n.keys[i]))
+                {
+                    erase_at(current, i);
+                    return 1;
+                }
+                if (n.leaf)
+                    return 0;
+                current = n.children[i];
+            }
+        }
+
+        std::size_t erase_id(const T& id)
+        {
+            if (static_cast<std::size_t>(id) >= node_of_.size() || 
+                node_of_[id] == nil)
+                return 0;
+
+            auto index = node_of_[id];
+            auto&& n = nodes_[index];
+            std::size_t i = 0;
+            while (n.keys[i] != id)
+                ++i;
+            erase_at(index, i);
+            return 1;
+        }
+
+        const T& front() const
+        {
+            assert(size_ > 0);
+            return nodes_[first_leaf_].keys[0];
+        }
+
+        bool empty() const { return size_ == 0; }
+        std::size_t size() const { return size_; }
+
+    private:
+        static constexpr std::uint32_t nil = ~std::uint32_t(0);
+
+        struct node
+        {
+            // 1 extra slot for an overflow before a split
+            T keys[max_keys + 1];
+            std::uint32_t children[max_keys + 2];
+            std::uint32_t parent;
+            std::uint32_t count;
+            bool leaf;
+        };
+
+        Compare cmp_;
+        std::vector<node> nodes_;
+        std::vector<std::uint32_t> free_nodes_;
+
+        // node which contains given id or nil
+        std::vector<std::uint32_t> node_of_;
+        std::uint32_t root_;
+        std::uint32_t first_leaf_;
+        std::size_t size_;
+
+        // buffers used by assign_sorted()
+        std::vector<T> level_keys_, next_keys_;
+        std::vector<std::uint32_t> level_nodes_, next_nodes_;
+
+        template<typename OutputIterator>
+        OutputIterator copy_sorted(std::uint32_t index, OutputIterator out) const
+        {
+            auto&& n = nodes_[index];
+            for (std::size_t i = 0; i < n.count; ++i)
+            {
+                if (!n.leaf)
+                    out = copy_sorted(n.children[i], out);
+                *out++ = n.keys[i];
+            }
+            if (!n.leaf)
+                out = copy_sorted(n.children[n.count], out);
+            return out;
+        }
+
+        void clear()
+        {
+            nodes_.clear();
+            free_nodes_.clear();
+            size_ = 0;
+            root_ = first_leaf_ = make_node(true, nil);
+        }
+
+        std::uint32_t make_node(bool leaf, std::uint32_t parent)
+        {
+            std::uint32_t index;
+            if (!free_nodes_.empty())
+            {
+                index = free_nodes_.back();
+                free_nodes_.pop_back();
+            }
+            else
+            {
+                index = static_cast<std::uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+            }
+            auto&& n = nodes_[index];
+            n.leaf = leaf;
+            n.parent = parent;
+            n.count = 0;
+            return index;
+        }
+
+        // index of the first key in the node which is not less than value
+        std::size_t lower_bound(const node& n, const T& value) const
+        {
+            std::size_t first = 0, count = n.count;
+            while (count > 0)
+            {
+                auto step = count / 2;
+                if (cmp_(n.keys[first + step], value))
+                {
+                    first += step + 1;
+                    count -= step + 1;
+                }
+                else
+                {
+                    count = step;
+                }
+            }
+            return first;
+        }
+
+        std::size_t child_index(const node& parent, std::uint32_t child) const
+        {
+            std::size_t i = 0;
+            while (parent.children[i] != child)
+                ++i;
+            return i;
+        }
+
+        // insert key at position i and child right after it
+        void insert_at(
+            std::uint32_t index,
+            std::size_t i,
+            const T& key,
+            std::uint32_t right_child)
+        {
+            auto&& n = nodes_[index];
+            std::copy_backward(n.keys + i, n.keys + n.count, n.keys + n.count + 1);
+            set_key(index, i, key);
+            if (!n.leaf)
+            {
+                std::copy_backward(
+                    n.children + i + 1,
+                    n.children + n.count + 1,
+                    n.children + n.count + 2);
+                n.children[i + 1] = right_child;
+                nodes_[right_child].parent = index;
+            }
+            ++n.count;
+        }
+
+        // split nodes with too many keys from given node up to the root
+        void split_overflow(std::uint32_t index)
+        {
+            while (nodes_[index].count > max_keys)
+            {
+                auto parent = nodes_[index].parent;
+                if (parent == nil)
+                {
+                    parent = make_node(false, nil);
+                    nodes_[parent].children[0] = index;
+                    nodes_[index].parent = parent;
+                    root_ = parent;
+                }
+
+                // the left half stays in the original node
+                auto right = make_node(nodes_[index].leaf, parent);
+                auto&& left_node = nodes_[index];
+                auto&& right_node = nodes_[right];
+                auto mid = left_node.count / 2;
+                right_node.count = left_node.count - mid - 1;
+                for (auto i = mid + 1; i < left_node.count; ++i)
+                    set_key(right, i - mid - 1, left_node.keys[i]);
+                if (!left_node.leaf)
+                {
+                    std::copy(
+                        left_node.children + mid + 1,
+                        left_node.children + left_node.count + 1,
+                        right_node.children);
+                    for (std::size_t i = 0; i <= right_node.count; ++i)
+                        nodes_[right_node.children[i]].parent = right;
+                }
+                left_node.count = mid;
+                auto median = left_node.keys[mid];
+
+                auto&& parent_node = nodes_[parent];
+                insert_at(parent, child_index(parent_node, index), median, right);
+                index = parent;
+            }
+        }
+
+        // set a key and remember its node
+        void set_key(std::uint32_t index, std::size_t i, const T& key)
+        {
+            nodes_[index].keys[i] = key;
+            node_of_[key] = index;
+        }
+
+        void erase_at(std::uint32_t index, std::size_t i)
+        {
+            node_of_[nodes_[index].keys[i]] = nil;
+            if (!nodes_[index].leaf)
+            {
+                // replace the key with its predecessor from a leaf
+                auto leaf = nodes_[index].children[i];
+                while (!nodes_[leaf].leaf)
+                    leaf = nodes_[leaf].children[nodes_[leaf].count];
+                auto&& leaf_node = nodes_[leaf];
+                set_key(index, i, leaf_node.keys[leaf_node.count - 1]);
+                index = leaf;
+                i = leaf_node.count - 1;
+            }
+
+            auto&& n = nodes_[index];
+            std::copy(n.keys + i + 1, n.keys + n.count, n.keys + i);
+            --n.count;
+            --size_;
+            fix_underflow(index);
+        }
+
+        // rebalance nodes with too few keys from given node up to the root
+        void fix_underflow(std::uint32_t index)
+        {
+            while (index != root_ && nodes_[index].count < min_keys)
+            {
+                auto parent = nodes_[index].parent;
+                auto i = child_index(nodes_[parent], index);
+                auto left = i > 0 ? nodes_[parent].children[i - 1] : nil;
+                auto right = i < nodes_[parent].count ?
+                    nodes_[parent].children[i + 1] : nil;
+
+                if (left != nil && nodes_[left].count > min_keys)
+                {
+                    rotate_right(parent, i - 1);
+                    return;
+                }
+                if (right != nil && nodes_[right].count > min_keys)
+                {
+                    rotate_left(parent, i);
+                    return;
+                }
+
+                if (left != nil)
+                    merge(parent, i - 1);
+                else
+                    merge(parent, i);
+                index = parent;
+            }
+
+            auto&& root = nodes_[root_];
+            if (root.count == 0 && !root.leaf)
+            {
+                auto old_root = root_;
+                root_ = root.children[0];
+                nodes_[root_].parent = nil;
+                free_nodes_.push_back(old_root);
+            }
+        }
+
+        // move a key from children[i] to children[i + 1] through the parent
+        void rotate_right(std::uint32_t parent, std::size_t i)
+        {
+            auto&& p = nodes_[parent];
+            auto&& left = nodes_[p.children[i]];
+            auto&& right = nodes_[p.children[i + 1]];
+
+            std::copy_backward(right.keys, right.keys + right.count,
+                right.keys + right.count + 1);
+            set_key(p.children[i + 1], 0, p.keys[i]);
+            set_key(parent, i, left.keys[left.count - 1]);
+            if (!right.leaf)
+            {
+                std::copy_backward(right.children,
+                    right.children + right.count + 1,
+                    right.children + right.count + 2);
+                right.children[0] = left.children[left.count];
+                nodes_[right.children[0]].parent = p.children[i + 1];
+            }
+            --left.count;
+            ++right.count;
+        }
+
+        // move a key from children[i + 1] to children[i] through the parent
+        void rotate_left(std::uint32_t parent, std::size_t i)
+        {
+            auto&& p = nodes_[parent];
+            auto&& left = nodes_[p.children[i]];
+            auto&& right = nodes_[p.children[i + 1]];
+
+            set_key(p.children[i], left.count, p.keys[i]);
+            set_key(parent, i, right.keys[0]);
+            std::copy(right.keys + 1, right.keys + right.count, right.keys);
+            if (!left.leaf)
+            {
+                left.children[left.count + 1] = right.children[0];
+                nodes_[right.children[0]].parent = p.children[i];
+                std::copy(right.children + 1,
+                    right.children + right.count + 1,
+                    right.children);
+            }
+            ++left.count;
+            --right.count;
+        }
+
+        // merge children[i + 1] and keys[i] into children[i]
+        void merge(std::uint32_t parent, std::size_t i)
+        {
+            auto&& p = nodes_[parent];
+            auto left_index = p.children[i];
+            auto right_index = p.children[i + 1];
+            auto&& left = nodes_[left_index];
+            auto&& right = nodes_[right_index];
+
+            set_key(left_index, left.count, p.keys[i]);
+            for (std::size_t j = 0; j < right.count; ++j)
+                set_key(left_index, left.count + 1 + j, right.keys[j]);
+            if (!left.leaf)
+            {
+                std::copy(right.children, right.children + right.count + 1,
+                    left.children + left.count + 1);
+                for (std::size_t j = 0; j <= right.count; ++j)
+                    nodes_[right.children[j]].parent = left_index;
+            }
+            left.count += right.count + 1;
+
+            std::copy(p.keys + i + 1, p.keys + p.count, p.keys + i);
+            std::copy(p.children + i + 2, p.children + p.count + 1,
+                p.children + i + 1);
+            --p.count;
+            right.count = 0;
+            free_nodes_.push_back(right_index);
+        }
+    };
+
+    template<typename T, typename Compare>
+    constexpr std::uint32_t btree_state<T, Compare>::nil;
+
+    /* State which uses a flat_state while the number of values is small and
+     * switches to a btree_state when it grows over a threshold. It switches
+     * back when the size drops under a quarter of the threshold.
+     */
+    template<typename T, typename Compare>
+    class adaptive_state
+    {
+    public:
+        using value_type = T;
+        using compare_type = Compare;
+
+        // maximal size of the flat state (the flat state is faster than the
+        // B-tree up to about 128 line segments in the state benchmark)
+        static constexpr std::size_t flat_limit = 128;
+
+        adaptive_state() : adaptive_state(Compare{}) {}
+        explicit adaptive_state(Compare cmp) : 
+            cmp_(cmp), 
+            flat_(cmp), 
+            tree_(cmp) 
+        {
+        }
+
+        void reset(Compare cmp)
+        {
+            flat_.reset(cmp);
+            tree_.reset(cmp);
+            cmp_ = cmp;
+            is_tree_ = false;
+        }
+
+        template<typename InputIterator>
+        void assign_sorted(InputIterator first, InputIterator last)
+        {
+            flat_.assign_sorted(first, last);
+            tree_.reset(cmp_);
+            is_tree_ = false;
+            if (flat_.size() > flat_limit)
+                grow();
+        }
+
+        bool insert(const T& value)
+        {
+            if (is_tree_)
+                return tree_.insert(value);
+            if (flat_.size() >= flat_limit)
+            {
+                grow();
+                return tree_.insert(value);
+            }
+            return flat_.insert(value);
+        }
+
+        std::size_t erase(const T& value)
+        {
+            if (!is_tree_)
+                return flat_.erase(value);
+            auto count = tree_.erase(value);
+            shrink();
+            return count;
+        }
+
+        std::size_t erase_id(const T& id)
+        {
+            if (!is_tree_)
+                return flat_.erase_id(id);
+            auto count = tree_.erase_id(id);
+            shrink();
+            return count;
+        }
+
+        const T& front() const { return is_tree_ ? tree_.front() : flat_.front(); }
+        bool empty() const { return is_tree_ ? tree_.empty() : flat_.empty(); }
+        std::size_t size() const { return is_tree_ ? tree_.size() : flat_.size(); }
+
+    private:
+        Compare cmp_;
+        flat_state<T, Compare> flat_;
+        btree_state<T, Compare> tree_;
+        bool is_tree_ = false;
+
+        // values in ascending order while they are moved between containers
+        std::vector<T> buffer_;
+
+        // move all values to the tree
+        void grow()
+        {
+            auto&& values = flat_.values();
+            tree_.assign_sorted(values.rbegin(), values.rend());
+            flat_.reset(cmp_);
+            is_tree_ = true;
+        }
+
+        // switch back to the flat state if the tree is small enough
+        void shrink()
+        {
+            if (tree_.size() < flat_limit / 4)
+            {
+                buffer_.clear();
+                tree_.copy_sorted(std::back_inserter(buffer_));
+                flat_.assign_sorted(buffer_.begin(), buffer_.end());
+                tree_.reset(cmp_);
+                is_tree_ = false;
+            }
+        }
+    };
+}
+
+#endif // GEOMETRY_SWEEP_STATE_HPP_
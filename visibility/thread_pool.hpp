@@ -0,0 +1,250 @@
+#ifndef GEOMETRY_THREAD_POOL_HPP_
+#define GEOMETRY_THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace geometry
+{
+    /* Pool of threads which run parallel loops with work stealing.
+     * Iterations of a loop are split into contiguous ranges, one range per
+     * worker. A worker takes small chunks from the front of its range. When
+     * its range is empty, it steals the back half of the largest remaining
+     * range of another worker. This balances the load if the cost of
+     * iterations varies a lot.
+     * The thread which calls parallel_for() is one of the workers (worker 0)
+     * so a pool of size 1 does not create any threads. parallel_for() must
+     * not be called concurrently from multiple threads or from the loop body.
+     */
+    class thread_pool
+    {
+    public:
+        /** Create a thread pool.
+         * @param thread_count number of workers including the calling
+         *        thread (0 = number of hardware threads)
+         */
+        explicit thread_pool(std::size_t thread_count = 0)
+        {
+            if (thread_count == 0)
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            for (std::size_t i = 0; i < thread_count; ++i)
+                queues_.emplace_back(new work_queue());
+            for (std::size_t i = 1; i < thread_count; ++i)
+                threads_.emplace_back([this, i]() { worker_loop(i); });
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        ~thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto&& thread : threads_)
+                thread.join();
+        }
+
+        /** Number of workers (including the thread which calls parallel_for)
+         * @return size of the pool
+         */
+        std::size_t size() const { return queues_.size(); }
+
+        /** Run body(worker, first, last) for chunks [first, last) which
+         * cover the range [0, count). The function returns after all
+         * chunks have been processed. If the body throws an exception,
+         * remaining chunks are skipped and the first exception is rethrown.
+         * @param count number of iterations
+         * @param grain maximal number of iterations in a chunk
+         * @param body function called with index of the worker (less than
+         *        size()) and a range of iterations
+         */
+        template<typename Function>
+        void parallel_for(std::size_t count, std::size_t grain, Function&& body)
+        {
+            if (count == 0)
+                return;
+
+            // split the iterations evenly among the workers
+            auto workers = queues_.size();
+            for (std::size_t i = 0; i < workers; ++i)
+            {
+                auto&& queue = *queues_[i];
+                std::lock_guard<std::mutex> lock{ queue.mutex };
+                queue.first = count * i / workers;
+                queue.last = count * (i + 1) / workers;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                job_ = std::ref(body);
+                grain_ = std::max<std::size_t>(grain, 1);
+                error_ = nullptr;
+                is_cancelled_ = false;
+                active_ = threads_.size();
+                ++generation_;
+            }
+            wake_.notify_all();
+
+            run(0);
+
+            std::unique_lock<std::mutex> lock{ mutex_ };
+            done_.wait(lock, [this]() { return active_ == 0; });
+            job_ = nullptr;
+            if (error_)
+                std::rethrow_exception(error_);
+        }
+
+    private:
+        // remaining iterations of a worker
+        struct work_queue
+        {
+            std::mutex mutex;
+            std::size_t first = 0;
+            std::size_t last = 0;
+        };
+
+        std::vector<std::unique_ptr<work_queue>> queues_;
+        std::vector<std::thread> threads_;
+
+        // state of the current loop (guarded by mutex_)
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        std::function<void(std::size_t, std::size_t, std::size_t)> job_;
+        std::exception_ptr error_;
+        std::size_t grain_ = 1;
+        std::size_t active_ = 0;
+        std::size_t generation_ = 0;
+        bool stop_ = false;
+
+        // set when the remaining iterations are skipped. It is read under
+        // the lock of a queue so that a steal can not refill a cleared queue.
+        std::atomic<bool> is_cancelled_{ false };
+
+        void worker_loop(std::size_t worker)
+        {
+            std::size_t generation = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock{ mutex_ };
+                    wake_.wait(lock, [&]()
+                    {
+                        return stop_ || generation_ != generation;
+                    });
+                    if (stop_)
+                        return;
+                    generation = generation_;
+                }
+
+                run(worker);
+
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                if (--active_ == 0)
+                    done_.notify_one();
+            }
+        }
+
+        // process chunks of the worker and then steal from other workers
+        void run(std::size_t worker)
+        {
+            std::size_t first, last;
+            while (pop(worker, first, last) || steal(worker, first, last))
+            {
+                try
+                {
+                    job_(worker, first, last);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock{ mutex_ };
+                    if (!error_)
+                        error_ = std::current_exception();
+                    clear_queues();
+                }
+            }
+        }
+
+        // take a chunk from the front of the worker's range
+        bool pop(std::size_t worker, std::size_t& first, std::size_t& last)
+        {
+            auto&& queue = *queues_[worker];
+            std::lock_guard<std::mutex> lock{ queue.mutex };
+            if (queue.first >= queue.last)
+                return false;
+            first = queue.first;
+            last = std::min(queue.last, first + grain_);
+            queue.first = last;
+            return true;
+        }
+
+        // move the back half of the largest range to the worker's range
+        // and take a chunk from it
+        bool steal(std::size_t worker, std::size_t& first, std::size_t& last)
+        {
+            for (;;)
+            {
+                std::size_t victim = worker, largest = 0;
+                for (std::size_t i = 0; i < queues_.size(); ++i)
+                {
+                    auto&& queue = *queues_[i];
+                    std::lock_guard<std::mutex> lock{ queue.mutex };
+                    auto size = queue.last - std::min(queue.first, queue.last);
+                    if (size > largest)
+                    {
+                        largest = size;
+                        victim = i;
+                    }
+                }
+                if (largest == 0)
+                    return false;
+
+                std::size_t stolen_first, stolen_last;
+                {
+                    auto&& queue = *queues_[victim];
+                    std::lock_guard<std::mutex> lock{ queue.mutex };
+                    if (queue.first >= queue.last)
+                        continue; // the range has been taken meanwhile
+                    auto size = queue.last - queue.first;
+                    stolen_last = queue.last;
+                    stolen_first = queue.last - (size + 1) / 2;
+                    queue.last = stolen_first;
+                }
+
+                auto&& queue = *queues_[worker];
+                std::lock_guard<std::mutex> lock{ queue.mutex };
+                if (is_cancelled_)
+                    return false; // the queues have been cleared meanwhile
+                first = stolen_first;
+                last = std::min(stolen_last, first + grain_);
+                queue.first = last;
+                queue.last = stolen_last;
+                return true;
+            }
+        }
+
+        // skip all remaining iterations
+        void clear_queues()
+        {
+            is_cancelled_ = true;
+            for (auto&& queue : queues_)
+            {
+                std::lock_guard<std::mutex> lock{ queue->mutex };
+                queue->first = queue->last;
+            }
+        }
+    };
+}
+
+#endif // GEOMETRY_THREAD_POOL_HPP_
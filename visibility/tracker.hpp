@@ -0,0 +1,273 @@
+#ifndef GEOMETRY_TRACKER_HPP_
+#define GEOMETRY_TRACKER_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "scene.hpp"
+
+namespace geometry
+{
+    /* Visibility polygon of an observer which moves in a scene.
+     * The tracker keeps events of the previous query. If no line segment 
+     * becomes (or stops being) collinear with the observer, the set of 
+     * events does not change and only their angular order changes slightly.
+     * Keys of the events are recomputed and the previous order is repaired
+     * by an insertion sort which runs in O(n + k) time where k is the number
+     * of inversions. Events which cross the positive y axis (where the sweep
+     * starts) move from one end of the order to the other, so they are 
+     * sorted separately and merged. 
+     * If the observer crosses the supporting line of a line segment, its 
+     * start and end vertex are swapped in place (the angles of its 
+     * endpoints change continuously). If a line segment becomes collinear
+     * with the observer, the tracker falls back to a full rebuild. If there
+     * are too many inversions, the events are sorted from scratch.
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State = adaptive_state>
+    class visibility_tracker
+    {
+    public:
+        using workspace_type = visibility_workspace<Vector, State>;
+
+        // maximal number of moves of the insertion sort per event before
+        // the tracker sorts the events from scratch
+        static constexpr std::size_t max_moves_per_event = 8;
+
+        /** Create a tracker of an observer in a scene.
+         * @param scene obstacles (the scene must outlive the tracker)
+         */
+        explicit visibility_tracker(const visibility_scene<Vector>& scene) :
+            scene_(&scene) {}
+
+        /** Calculate visibility polygon at a new position of the observer
+         * and pass its vertices in clockwise order to a sink function.
+         * @param observer new position of the observer
+         * @param sink function which is called with each vertex of the
+         *        visibility polygon
+         */
+        template<typename Sink>
+        void visit(Vector observer, Sink sink)
+        {
+            ++update_count_;
+            if (!valid_ || !update_sides(observer))
+                rebuild(observer);
+            else
+                repair_order(observer);
+            sweep_sorted_obstacles(observer, workspace_, sink);
+        }
+
+        /** Calculate visibility polygon at a new position of the observer.
+         * @param observer new position of the observer
+         * @return vertices of the visibility polygon in clockwise order
+         *         (reference to a buffer which is valid until the next
+         *         update)
+         */
+        const std::vector<Vector>& update(Vector observer)
+        {
+            auto& vertices = workspace_.vertices;
+            vertices.clear();
+            visit(observer, [&vertices](const Vector& vertex)
+            {
+                vertices.push_back(vertex);
+            });
+            return vertices;
+        }
+
+        // forget the previous query (the next update does a full rebuild)
+        void invalidate() { valid_ = false; }
+
+        // number of updates
+        std::size_t update_count() const { return update_count_; }
+
+        // number of updates which rebuilt the events from scratch because 
+        // the set of line segments collinear with the observer has changed
+        std::size_t rebuild_count() const { return rebuild_count_; }
+
+        // number of updates which sorted the events from scratch because
+        // the insertion sort exceeded its budget
+        std::size_t resort_count() const { return resort_count_; }
+
+        // buffers of the last query
+        const workspace_type& workspace() const { return workspace_; }
+
+    private:
+        const visibility_scene<Vector>* scene_;
+        workspace_type workspace_;
+
+        // orientation of the observer and each line segment of the scene
+        // in the last query
+        std::vector<orientation> sides_;
+
+        // index of each line segment of the scene in the workspace (valid
+        // if it is not collinear with the observer)
+        std::vector<std::uint32_t> indices_;
+
+        // line segments in the workspace whose orientation has changed 
+        // since the last query (indices in the workspace)
+        std::vector<std::uint32_t> flipped_;
+        std::vector<bool> is_flipped_;
+
+        // events which crossed the positive y axis
+        visibility_events wrapped_;
+
+        bool valid_ = false;
+        std::size_t update_count_ = 0;
+        std::size_t rebuild_count_ = 0;
+        std::size_t resort_count_ = 0;
+
+        // swap endpoints of line segments whose supporting line the 
+        // observer has crossed. Return false if the set of line segments
+        // collinear with the observer has changed.
+        bool update_sides(Vector observer)
+        {
+            auto&& lines = scene_->lines();
+            for (std::size_t i = 0; i < lines.size(); ++i)
+            {
+                auto side = lines[i].side(observer);
+                if (side == sides_[i])
+                    continue;
+                if (side == orientation::collinear || 
+                    sides_[i] == orientation::collinear)
+                    return false;
+
+                sides_[i] = side;
+                auto index = indices_[i];
+                auto& segment = workspace_.segments[index];
+                std::swap(segment.a, segment.b);
+                flipped_.push_back(index);
+                is_flipped_[index] = true;
+            }
+            return true;
+        }
+
+        // add all obstacles and sort their events from scratch
+        void rebuild(Vector observer)
+        {
+            ++rebuild_count_;
+            auto&& segments = scene_->segments();
+            auto&& lines = scene_->lines();
+            workspace_.clear();
+            sides_.resize(segments.size());
+            indices_.resize(segments.size());
+            for (std::size_t i = 0; i < segments.size(); ++i)
+            {
+                sides_[i] = lines[i].side(observer);
+                indices_[i] = static_cast<std::uint32_t>(workspace_.segments.size());
+                add_obstacle(observer, segments[i], sides_[i], workspace_);
+            }
+            sort_obstacles(workspace_);
+            flipped_.clear();
+            is_flipped_.assign(workspace_.segments.size(), false);
+            valid_ = true;
+        }
+
+        // recompute keys of the events and sort them starting from the
+        // order of the last query
+        void repair_order(Vector observer)
+        {
+            auto& events = workspace_.events;
+            auto&& segments = workspace_.segments;
+
+            // update keys and vertex types of flipped line segments, move
+            // events which crossed the positive y axis to a separate list
+            wrapped_.clear();
+            std::size_t count = 0;
+            auto any_flipped = !flipped_.empty();
+            for (std::size_t i = 0; i < events.size(); ++i)
+            {
+                auto ref = events.refs[i];
+                if (any_flipped && is_flipped_[event_segment(ref)])
+                    ref ^= 1;
+                auto&& segment = segments[event_segment(ref)];
+                auto key = angle_key(observer, segment.a);
+                if (is_end_vertex(ref))
+                    key = end_event_key(key, angle_key(observer, segment.b));
+                if (crosses_start(events.keys[i], key))
+                {
+                    wrapped_.push_back(key, ref);
+                }
+                else
+                {
+                    events.keys[count] = key;
+                    events.refs[count] = ref;
+                    ++count;
+                }
+            }
+            for (auto index : flipped_)
+                is_flipped_[index] = false;
+            flipped_.clear();
+
+            // insertion sort of the remaining events
+            auto budget = max_moves_per_event * events.size();
+            std::size_t moves = 0;
+            for (std::size_t i = 1; i < count && moves <= budget; ++i)
+            {
+                auto key = events.keys[i];
+                auto ref = events.refs[i];
+                auto j = i;
+                for (; j > 0 && events.keys[j - 1] > key; --j)
+                {
+                    events.keys[j] = events.keys[j - 1];
+                    events.refs[j] = events.refs[j - 1];
+                }
+                events.keys[j] = key;
+                events.refs[j] = ref;
+                moves += i - j;
+            }
+
+            if (moves > budget)
+            {
+                // the order has changed too much
+                ++resort_count_;
+                for (std::size_t i = 0; i < wrapped_.size(); ++i)
+                {
+                    events.keys[count + i] = wrapped_.keys[i];
+                    events.refs[count + i] = wrapped_.refs[i];
+                }
+                sort_obstacles(workspace_);
+                return;
+            }
+
+            // merge the wrapped events from the back
+            if (wrapped_.size() > 0)
+            {
+                sort_events(wrapped_, workspace_.event_buffer, false);
+                auto i = count, j = wrapped_.size(), k = events.size();
+                while (j > 0)
+                {
+                    --k;
+                    if (i > 0 && events.keys[i - 1] > wrapped_.keys[j - 1])
+                    {
+                        --i;
+                        events.keys[k] = events.keys[i];
+                        events.refs[k] = events.refs[i];
+                    }
+                    else
+                    {
+                        --j;
+                        events.keys[k] = wrapped_.keys[j];
+                        events.refs[k] = wrapped_.refs[j];
+                    }
+                }
+            }
+        }
+
+        // check whether a point has moved across the positive y axis
+        // between the first and the last quarter of the pseudo-angle
+        static bool crosses_start(std::uint64_t old_key, std::uint64_t new_key)
+        {
+            auto old_angle = key_angle(old_key), new_angle = key_angle(new_key);
+            return (old_angle < 1 && new_angle > 3) ||
+                (old_angle > 3 && new_angle < 1);
+        }
+    };
+}
+
+#endif // GEOMETRY_TRACKER_HPP_
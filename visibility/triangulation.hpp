@@ -0,0 +1,739 @@
+#ifndef GEOMETRY_TRIANGULATION_HPP_
+#define GEOMETRY_TRIANGULATION_HPP_
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "grid.hpp"
+#include "scene.hpp"
+
+namespace geometry
+{
+    /* Constrained Delaunay triangulation of a scene. Line segments of the
+     * scene are edges of the triangulation and the other edges satisfy the
+     * Delaunay property as long as the line segments allow it. The
+     * triangulation covers a frame around the scene: a rectangle 3 times
+     * larger than the bounding box of the scene whose corners are the last
+     * 4 vertices and whose sides are constrained edges.
+     *
+     * Vertices are inserted in the order of a Hilbert curve (so that a
+     * walk from the last triangle finds the next vertex in a few steps) and
+     * the Delaunay property is restored by edge flips. Line segments are
+     * inserted afterwards: edges which cross a line segment are flipped
+     * until it becomes an edge and the Delaunay property is restored around
+     * the new edges.
+     */
+    template<typename Vector>
+    class constrained_triangulation
+    {
+    public:
+        using scalar_type = typename std::decay<decltype(Vector{}.x)>::type;
+        using segment_record = typename visibility_scene<Vector>::segment_record;
+
+        // index of a missing triangle
+        static constexpr std::uint32_t none = 0xFFFFFFFFu;
+
+        struct triangle
+        {
+            // indices of vertices in counterclockwise order
+            std::uint32_t vertices[3];
+
+            // neighbors[k] shares the edge opposite to vertices[k] (none on
+            // the frame)
+            std::uint32_t neighbors[3];
+
+            // bit k is set iff the edge opposite to vertices[k] is a line
+            // segment of the scene or a side of the frame
+            std::uint32_t constrained;
+
+            bool is_constrained(std::uint32_t edge) const
+            {
+                return ((constrained >> edge) & 1) != 0;
+            }
+        };
+
+        constrained_triangulation() {}
+
+        /** Triangulate a scene.
+         * @param scene obstacles (line segments must not intersect except
+         *        at their endpoints)
+         */
+        explicit constrained_triangulation(const visibility_scene<Vector>& scene)
+        {
+            build(scene.vertices(), scene.records());
+        }
+
+        // vertices of the scene followed by 4 corners of the frame
+        const std::vector<Vector>& vertices() const { return vertices_; }
+
+        // triangles of the triangulation
+        const std::vector<triangle>& triangles() const { return triangles_; }
+
+        /** Find a triangle which contains a point.
+         * @param point
+         * @return index of a triangle which contains the point (it can be
+         *         on its boundary) or none if the point is outside of the
+         *         frame
+         */
+        std::uint32_t locate(Vector point) const
+        {
+            if (triangles_.empty())
+                return none;
+            auto start = start_triangles_[
+                layout_.row(point.y) * layout_.columns() + layout_.column(point.x)];
+            return walk(to_double(point), start);
+        }
+
+        // index of the next vertex of a triangle in counterclockwise order
+        static std::uint32_t next(std::uint32_t index)
+        {
+            return index == 2 ? 0 : index + 1;
+        }
+
+        // index of the previous vertex of a triangle in counterclockwise order
+        static std::uint32_t prev(std::uint32_t index)
+        {
+            return index == 0 ? 2 : index - 1;
+        }
+
+        // index of the edge of a triangle shared with a neighbor
+        static std::uint32_t neighbor_edge(const triangle& item, std::uint32_t neighbor)
+        {
+            return item.neighbors[0] == neighbor ? 0 : item.neighbors[1] == neighbor ? 1 : 2;
+        }
+
+    private:
+        using edge_type = std::pair<std::uint32_t, std::uint32_t>;
+
+        std::vector<Vector> vertices_;
+        std::vector<triangle> triangles_;
+
+        // a triangle incident to each vertex
+        std::vector<std::uint32_t> vertex_triangles_;
+
+        // a triangle close to the center of each cell of a grid (start of
+        // walks in locate())
+        grid_layout<Vector> layout_;
+        std::vector<std::uint32_t> start_triangles_;
+
+        // buffers of the build
+        std::vector<std::uint32_t> legalize_stack_;
+        std::deque<edge_type> crossed_edges_;
+        std::vector<edge_type> new_edges_;
+
+        // relative tolerance of the in-circle test
+        static constexpr double incircle_tolerance = 1e-12;
+
+        static vector2<double> to_double(Vector point)
+        {
+            return vector2<double>{
+                static_cast<double>(point.x),
+                static_cast<double>(point.y) };
+        }
+
+        vector2<double> position(std::uint32_t vertex) const
+        {
+            return to_double(vertices_[vertex]);
+        }
+
+        /** Compute orientation of 3 points. The result is exact if the
+         * coordinates are floats.
+         * @return positive value iff (a, b, c) is a left turn, negative
+         *         value iff it is a right turn
+         */
+        static double orient(vector2<double> a, vector2<double> b, vector2<double> c)
+        {
+            return cross(b - a, c - a);
+        }
+
+        double orient(std::uint32_t a, std::uint32_t b, std::uint32_t c) const
+        {
+            return orient(position(a), position(b), position(c));
+        }
+
+        /** Check whether a point is in the circumcircle of a triangle.
+         * @param a vertex of a counterclockwise triangle
+         * @param b vertex of a counterclockwise triangle
+         * @param c vertex of a counterclockwise triangle
+         * @param d the point
+         * @return true iff d is clearly inside of the circumcircle (points
+         *         which are approximately on the circle are outside)
+         */
+        bool is_in_circle(
+            std::uint32_t a,
+            std::uint32_t b,
+            std::uint32_t c,
+            std::uint32_t d) const
+        {
+            auto origin = position(d);
+            auto ad = position(a) - origin;
+            auto bd = position(b) - origin;
+            auto cd = position(c) - origin;
+            auto a_lift = length_squared(ad);
+            auto b_lift = length_squared(bd);
+            auto c_lift = length_squared(cd);
+            auto ab = cross(ad, bd), bc = cross(bd, cd), ca = cross(cd, ad);
+            auto det = a_lift * bc + b_lift * ca + c_lift * ab;
+            auto permanent =
+                a_lift * std::abs(bc) + b_lift * std::abs(ca) + c_lift * std::abs(ab);
+            return det > incircle_tolerance * permanent;
+        }
+
+        /** Walk from a triangle towards a point. In each step, the walk
+         * crosses an edge (starting with a pseudo-random one) which
+         * separates the point from the current triangle. The random choice
+         * prevents cycles in triangulations which are not Delaunay.
+         * @param point target of the walk
+         * @param current the first triangle
+         * @return triangle which contains the point or none if it is
+         *         outside of the frame
+         */
+        std::uint32_t walk(vector2<double> point, std::uint32_t current) const
+        {
+            std::uint32_t seed = current;
+            for (;;)
+            {
+                auto&& item = triangles_[current];
+                seed = seed * 1103515245u + 12345u;
+                auto first = (seed >> 16) % 3;
+                auto following = none;
+                for (std::uint32_t i = 0; i < 3 && following == none; ++i)
+                {
+                    auto k = (first + i) % 3;
+                    auto a = position(item.vertices[next(k)]);
+                    auto b = position(item.vertices[prev(k)]);
+                    if (orient(a, b, point) < 0)
+                    {
+                        if (item.neighbors[k] == none)
+                            return none;
+                        following = item.neighbors[k];
+                    }
+                }
+                if (following == none)
+                    return current;
+                current = following;
+            }
+        }
+
+        // position of a vertex in a triangle
+        std::uint32_t index_of(const triangle& item, std::uint32_t vertex) const
+        {
+            return item.vertices[0] == vertex ? 0 : item.vertices[1] == vertex ? 1 : 2;
+        }
+
+        void replace_neighbor(std::uint32_t index, std::uint32_t old_value, std::uint32_t new_value)
+        {
+            if (index == none)
+                return;
+            auto& item = triangles_[index];
+            item.neighbors[neighbor_edge(item, old_value)] = new_value;
+        }
+
+        // constrained bit of an edge moved to another position
+        static std::uint32_t move_flag(const triangle& item, std::uint32_t from, std::uint32_t to)
+        {
+            return ((item.constrained >> from) & 1) << to;
+        }
+
+        /** Find an edge.
+         * @param a endpoint of the edge
+         * @param b endpoint of the edge
+         * @param index triangle which contains the edge (output)
+         * @param edge index of the edge in the triangle (output)
+         * @return false if there is no such edge
+         */
+        bool find_edge(std::uint32_t a, std::uint32_t b, std::uint32_t& index, std::uint32_t& edge) const
+        {
+            // rotate counterclockwise around a and then clockwise if the
+            // frame stops the rotation
+            for (auto is_ccw : { true, false })
+            {
+                auto start = vertex_triangles_[a];
+                auto current = start;
+                do
+                {
+                    auto&& item = triangles_[current];
+                    auto i = index_of(item, a);
+                    if (item.vertices[next(i)] == b || item.vertices[prev(i)] == b)
+                    {
+                        index = current;
+                        edge = item.vertices[next(i)] == b ? prev(i) : next(i);
+                        return true;
+                    }
+                    current = item.neighbors[is_ccw ? next(i) : prev(i)];
+                } while (current != start && current != none);
+
+                if (current == start)
+                    break;
+            }
+            return false;
+        }
+
+        // mark an edge as constrained in both triangles
+        void constrain(std::uint32_t index, std::uint32_t edge)
+        {
+            auto& item = triangles_[index];
+            item.constrained |= 1u << edge;
+            auto neighbor = item.neighbors[edge];
+            if (neighbor != none)
+            {
+                auto& other = triangles_[neighbor];
+                other.constrained |= 1u << neighbor_edge(other, index);
+            }
+        }
+
+        /** Flip the edge opposite to vertices[edge] of a triangle. If the
+         * triangle is (p, a, b) and its neighbor is (d, b, a), the triangle
+         * becomes (p, a, d) and the neighbor becomes (p, d, b).
+         * @param index of the triangle
+         * @param edge index of the edge in the triangle
+         */
+        void flip(std::uint32_t index, std::uint32_t edge)
+        {
+            auto& first = triangles_[index];
+            auto other = first.neighbors[edge];
+            auto& second = triangles_[other];
+            auto other_edge = neighbor_edge(second, index);
+
+            auto p = first.vertices[edge];
+            auto a = first.vertices[next(edge)];
+            auto b = first.vertices[prev(edge)];
+            auto d = second.vertices[other_edge];
+            auto bp = first.neighbors[next(edge)];
+            auto pa = first.neighbors[prev(edge)];
+            auto ad = second.neighbors[next(other_edge)];
+            auto db = second.neighbors[prev(other_edge)];
+            auto first_flags =
+                move_flag(second, next(other_edge), 0) |
+                move_flag(first, prev(edge), 2);
+            auto second_flags =
+                move_flag(second, prev(other_edge), 0) |
+                move_flag(first, next(edge), 1);
+
+            first = triangle{ { p, a, d }, { ad, other, pa }, first_flags };
+            second = triangle{ { p, d, b }, { db, bp, index }, second_flags };
+            replace_neighbor(ad, other, index);
+            replace_neighbor(bp, index, other);
+            vertex_triangles_[p] = index;
+            vertex_triangles_[a] = index;
+            vertex_triangles_[d] = index;
+            vertex_triangles_[b] = other;
+        }
+
+        /** Restore the Delaunay property after insertion of a vertex.
+         * The stack contains triangles whose first vertex is the new vertex.
+         */
+        void legalize()
+        {
+            while (!legalize_stack_.empty())
+            {
+                auto index = legalize_stack_.back();
+                legalize_stack_.pop_back();
+
+                auto&& item = triangles_[index];
+                if (item.is_constrained(0))
+                    continue;
+                auto&& other = triangles_[item.neighbors[0]];
+                auto d = other.vertices[neighbor_edge(other, index)];
+                if (is_in_circle(item.vertices[0], item.vertices[1], item.vertices[2], d))
+                {
+                    auto other_index = item.neighbors[0];
+                    flip(index, 0);
+                    legalize_stack_.push_back(index);
+                    legalize_stack_.push_back(other_index);
+                }
+            }
+        }
+
+        // split a triangle by a vertex in its interior
+        void split_triangle(std::uint32_t index, std::uint32_t p)
+        {
+            auto item = triangles_[index];
+            auto a = item.vertices[0], b = item.vertices[1], c = item.vertices[2];
+            auto first = static_cast<std::uint32_t>(triangles_.size());
+            auto second = first + 1;
+
+            triangles_[index] = triangle{
+                { p, b, c }, { item.neighbors[0], first, second }, move_flag(item, 0, 0) };
+            triangles_.push_back(triangle{
+                { p, c, a }, { item.neighbors[1], second, index }, move_flag(item, 1, 0) });
+            triangles_.push_back(triangle{
+                { p, a, b }, { item.neighbors[2], index, first }, move_flag(item, 2, 0) });
+            replace_neighbor(item.neighbors[1], index, first);
+            replace_neighbor(item.neighbors[2], index, second);
+            vertex_triangles_[p] = index;
+            vertex_triangles_[b] = index;
+            vertex_triangles_[c] = index;
+            vertex_triangles_[a] = first;
+
+            legalize_stack_.push_back(index);
+            legalize_stack_.push_back(first);
+            legalize_stack_.push_back(second);
+            legalize();
+        }
+
+        // split an edge of a triangle (and its neighbor) by a vertex
+        void split_edge(std::uint32_t index, std::uint32_t edge, std::uint32_t p)
+        {
+            auto item = triangles_[index];
+            auto x = item.vertices[edge];
+            auto a = item.vertices[next(edge)];
+            auto b = item.vertices[prev(edge)];
+            auto other = item.neighbors[edge];
+            auto split = item.constrained >> edge & 1;
+
+            auto second = static_cast<std::uint32_t>(triangles_.size());
+            auto fourth = other == none ? none : second + 1;
+            triangles_[index] = triangle{
+                { p, x, a },
+                { item.neighbors[prev(edge)], fourth, second },
+                move_flag(item, prev(edge), 0) | split << 1 };
+            triangles_.push_back(triangle{
+                { p, b, x },
+                { item.neighbors[next(edge)], index, other },
+                move_flag(item, next(edge), 0) | split << 2 });
+            replace_neighbor(item.neighbors[next(edge)], index, second);
+            vertex_triangles_[p] = index;
+            vertex_triangles_[x] = index;
+            vertex_triangles_[a] = index;
+            vertex_triangles_[b] = second;
+            legalize_stack_.push_back(index);
+            legalize_stack_.push_back(second);
+
+            if (other != none)
+            {
+                auto other_item = triangles_[other];
+                auto other_edge = neighbor_edge(other_item, index);
+                auto y = other_item.vertices[other_edge];
+                triangles_[other] = triangle{
+                    { p, y, b },
+                    { other_item.neighbors[prev(other_edge)], second, fourth },
+                    move_flag(other_item, prev(other_edge), 0) | split << 1 };
+                triangles_.push_back(triangle{
+                    { p, a, y },
+                    { other_item.neighbors[next(other_edge)], other, index },
+                    move_flag(other_item, next(other_edge), 0) | split << 2 });
+                replace_neighbor(other_item.neighbors[next(other_edge)], other, fourth);
+                vertex_triangles_[y] = other;
+                legalize_stack_.push_back(other);
+                legalize_stack_.push_back(fourth);
+            }
+            legalize();
+        }
+
+        /** Insert a vertex.
+         * @param p index of the vertex
+         * @param hint triangle close to the vertex
+         * @return index of an existing vertex at the same position or p
+         */
+        std::uint32_t insert_vertex(std::uint32_t p, std::uint32_t hint)
+        {
+            auto point = position(p);
+            auto index = walk(point, hint);
+            auto&& item = triangles_[index];
+
+            std::uint32_t zero_count = 0, zero_edge = 0;
+            for (std::uint32_t k = 0; k < 3; ++k)
+            {
+                auto side = orient(
+                    position(item.vertices[next(k)]),
+                    position(item.vertices[prev(k)]),
+                    point);
+                if (side == 0)
+                {
+                    ++zero_count;
+                    zero_edge = k;
+                }
+            }
+
+            if (zero_count >= 2)
+            {
+                // the vertex is equal to a vertex of the triangle
+                for (auto vertex : item.vertices)
+                {
+                    if (position(vertex) == point)
+                        return vertex;
+                }
+            }
+
+            if (zero_count == 1)
+                split_edge(index, zero_edge, p);
+            else
+                split_triangle(index, p);
+            return p;
+        }
+
+        // insert a line segment as a constrained edge
+        void insert_constraint(std::uint32_t a, std::uint32_t b)
+        {
+            while (a != b)
+            {
+                // find the triangle around a in the direction of b or a
+                // vertex on the line segment
+                auto target = position(b);
+                auto origin = position(a);
+                auto start = vertex_triangles_[a];
+                auto index = start;
+                std::uint32_t edge = none;
+                auto stop = none;
+                while (edge == none)
+                {
+                    auto&& item = triangles_[index];
+                    auto i = index_of(item, a);
+                    auto x = item.vertices[next(i)];
+                    auto y = item.vertices[prev(i)];
+                    auto x_side = orient(origin, position(x), target);
+                    auto y_side = orient(origin, position(y), target);
+                    if (x_side == 0 && dot(position(x) - origin, target - origin) > 0)
+                    {
+                        stop = x;
+                        edge = prev(i);
+                        break;
+                    }
+                    if (y_side == 0 && dot(position(y) - origin, target - origin) > 0)
+                    {
+                        stop = y;
+                        edge = next(i);
+                        break;
+                    }
+                    if (x_side > 0 && y_side < 0)
+                    {
+                        edge = i;
+                        break;
+                    }
+                    index = item.neighbors[next(i)];
+                    if (index == start || index == none)
+                        return; // the line segment intersects another one
+                }
+
+                if (stop != none)
+                {
+                    // the edge exists
+                    constrain(index, edge);
+                    a = stop;
+                    continue;
+                }
+
+                // edges which cross the line segment from a to the first
+                // vertex on it
+                crossed_edges_.clear();
+                for (;;)
+                {
+                    auto&& item = triangles_[index];
+                    crossed_edges_.emplace_back(item.vertices[next(edge)], item.vertices[prev(edge)]);
+                    auto other = item.neighbors[edge];
+                    auto&& other_item = triangles_[other];
+                    auto other_edge = neighbor_edge(other_item, index);
+                    auto d = other_item.vertices[other_edge];
+                    auto d_side = orient(origin, target, position(d));
+                    if (d == b || d_side == 0)
+                    {
+                        stop = d;
+                        break;
+                    }
+
+                    // continue through the edge between d and the endpoint
+                    // of the crossed edge on the other side
+                    auto e = other_item.vertices[next(other_edge)];
+                    auto e_side = orient(origin, target, position(e));
+                    edge = (e_side > 0) == (d_side > 0) ? next(other_edge) : prev(other_edge);
+                    index = other;
+                }
+
+                // flip the crossing edges until none is left
+                auto end = position(stop);
+                new_edges_.clear();
+                while (!crossed_edges_.empty())
+                {
+                    auto current = crossed_edges_.front();
+                    crossed_edges_.pop_front();
+                    if (!find_edge(current.first, current.second, index, edge))
+                        continue;
+
+                    auto&& item = triangles_[index];
+                    auto&& other_item = triangles_[item.neighbors[edge]];
+                    auto p = item.vertices[edge];
+                    auto x = item.vertices[next(edge)];
+                    auto y = item.vertices[prev(edge)];
+                    auto d = other_item.vertices[neighbor_edge(other_item, index)];
+                    if (orient(p, x, d) <= 0 || orient(p, d, y) <= 0)
+                    {
+                        // the quadrilateral is not convex
+                        crossed_edges_.push_back(current);
+                        continue;
+                    }
+
+                    flip(index, edge);
+                    auto p_side = orient(origin, end, position(p));
+                    auto d_side = orient(origin, end, position(d));
+                    if ((p_side > 0 && d_side < 0) || (p_side < 0 && d_side > 0))
+                        crossed_edges_.emplace_back(p, d);
+                    else
+                        new_edges_.emplace_back(p, d);
+                }
+
+                if (find_edge(a, stop, index, edge))
+                    constrain(index, edge);
+                restore_delaunay();
+                a = stop;
+            }
+        }
+
+        // flip new edges which are not Delaunay
+        void restore_delaunay()
+        {
+            auto is_changed = true;
+            while (is_changed)
+            {
+                is_changed = false;
+                for (auto& current : new_edges_)
+                {
+                    std::uint32_t index = 0, edge = 0;
+                    if (!find_edge(current.first, current.second, index, edge))
+                        continue;
+                    auto&& item = triangles_[index];
+                    if (item.is_constrained(edge))
+                        continue;
+
+                    auto&& other_item = triangles_[item.neighbors[edge]];
+                    auto p = item.vertices[edge];
+                    auto x = item.vertices[next(edge)];
+                    auto y = item.vertices[prev(edge)];
+                    auto d = other_item.vertices[neighbor_edge(other_item, index)];
+                    if (is_in_circle(p, x, y, d) &&
+                        orient(p, x, d) > 0 && orient(p, d, y) > 0)
+                    {
+                        flip(index, edge);
+                        current = edge_type{ p, d };
+                        is_changed = true;
+                    }
+                }
+            }
+        }
+
+        /** Compute index of a point on the Hilbert curve.
+         * @param x coordinate in [0, 2^16)
+         * @param y coordinate in [0, 2^16)
+         * @return index of the point
+         */
+        static std::uint64_t hilbert_index(std::uint32_t x, std::uint32_t y)
+        {
+            const std::uint32_t mask = 0xFFFF;
+            std::uint64_t index = 0;
+            for (std::uint32_t s = 1u << 15; s > 0; s >>= 1)
+            {
+                std::uint32_t rx = (x & s) != 0 ? 1 : 0;
+                std::uint32_t ry = (y & s) != 0 ? 1 : 0;
+                index += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+                if (ry == 0)
+                {
+                    if (rx == 1)
+                    {
+                        x = mask - x;
+                        y = mask - y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return index;
+        }
+
+        void build(const std::vector<Vector>& points, const std::vector<segment_record>& records)
+        {
+            auto count = static_cast<std::uint32_t>(points.size());
+            vertices_ = points;
+
+            // frame around the scene
+            scalar_type min_x = 0, min_y = 0, max_x = 1, max_y = 1;
+            if (!points.empty())
+            {
+                min_x = max_x = points[0].x;
+                min_y = max_y = points[0].y;
+            }
+            for (auto&& point : points)
+            {
+                min_x = std::min(min_x, point.x);
+                min_y = std::min(min_y, point.y);
+                max_x = std::max(max_x, point.x);
+                max_y = std::max(max_y, point.y);
+            }
+            auto margin = std::max(max_x - min_x, max_y - min_y) + 1;
+            vertices_.push_back(Vector{ min_x - margin, min_y - margin });
+            vertices_.push_back(Vector{ max_x + margin, min_y - margin });
+            vertices_.push_back(Vector{ max_x + margin, max_y + margin });
+            vertices_.push_back(Vector{ min_x - margin, max_y + margin });
+
+            triangles_.clear();
+            triangles_.reserve(2 * vertices_.size());
+            triangles_.push_back(triangle{ { count, count + 1, count + 2 }, { none, 1, none }, 5 });
+            triangles_.push_back(triangle{ { count, count + 2, count + 3 }, { none, none, 0 }, 3 });
+            vertex_triangles_.assign(vertices_.size(), 0);
+            vertex_triangles_[count + 3] = 1;
+
+            // insert vertices in the order of the Hilbert curve
+            std::vector<std::pair<std::uint64_t, std::uint32_t>> order(count);
+            auto scale = 65535 / std::max<double>(
+                std::max(max_x - min_x, max_y - min_y), 1e-30);
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                auto x = static_cast<std::uint32_t>((points[i].x - min_x) * scale);
+                auto y = static_cast<std::uint32_t>((points[i].y - min_y) * scale);
+                order[i] = std::make_pair(hilbert_index(x, y), i);
+            }
+            std::sort(order.begin(), order.end());
+
+            std::vector<std::uint32_t> vertex_map(count);
+            std::uint32_t last = 0;
+            for (auto&& item : order)
+            {
+                auto vertex = insert_vertex(item.second, last);
+                vertex_map[item.second] = vertex;
+                last = vertex_triangles_[vertex];
+            }
+
+            for (auto&& record : records)
+                insert_constraint(vertex_map[record.a], vertex_map[record.b]);
+
+            // start triangles of walks
+            layout_ = grid_layout<Vector>{
+                Vector{ min_x, min_y }, Vector{ max_x, max_y }, count / 4.0 };
+            start_triangles_.assign(layout_.columns() * layout_.rows(), 0);
+            std::uint32_t current = 0;
+            for (std::size_t row = 0; row < layout_.rows(); ++row)
+            {
+                for (std::size_t i = 0; i < layout_.columns(); ++i)
+                {
+                    // snake order keeps consecutive cells adjacent
+                    auto column = row % 2 == 0 ? i : layout_.columns() - 1 - i;
+                    vector2<double> center{
+                        layout_.min().x + (column + 0.5) * layout_.cell_size(),
+                        layout_.min().y + (row + 0.5) * layout_.cell_size() };
+                    auto found = walk(center, current);
+                    if (found != none)
+                        current = found;
+                    start_triangles_[row * layout_.columns() + column] = current;
+                }
+            }
+
+            legalize_stack_ = std::vector<std::uint32_t>{};
+            crossed_edges_ = std::deque<edge_type>{};
+            new_edges_ = std::vector<edge_type>{};
+        }
+    };
+
+    template<typename Vector>
+    constexpr std::uint32_t constrained_triangulation<Vector>::none;
+
+    template<typename Vector>
+    constexpr double constrained_triangulation<Vector>::incircle_tolerance;
+}
+
+#endif // GEOMETRY_TRIANGULATION_HPP_
@@ -1,16 +1,20 @@
 #ifndef GEOMETRY_VISIBILITY_HPP_
 #define GEOMETRY_VISIBILITY_HPP_
 
-#include <set>
 #include <vector>
 #include <algorithm>
 #include <limits>
 #include <cmath>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 
 #include "floats.hpp"
 #include "vector2.hpp"
 #include "primitives.hpp"
+#include "sweep_state.hpp"
+#include "radix_sort.hpp"
 
 namespace geometry
 {
@@ -124,151 +128,949 @@ namespace geometry
         }
     };
 
+    /** Compute a sort key of a point for the clockwise angular order.
+     * Keys order points the same way as angle_comparer: clockwise starting 
+     * at the positive y axis, points in the same direction by distance 
+     * (on the y axis, farther points go first). The angle is represented by
+     * a pseudo-angle which is monotone in the real angle, so the key can be
+     * computed in constant time without trigonometric functions and points 
+     * can be sorted by comparing integers.
+     * Note: directions which differ by less than float precision of the
+     * pseudo-angle are ordered by distance.
+     * @param origin center of the angular order
+     * @param point 
+     * @return sort key of the point
+     */
     template<typename Vector>
-    struct visibility_event
+    std::uint64_t angle_key(Vector origin, Vector point)
     {
-        // events used in the visibility polygon algorithm
-        enum event_type
-        {
-            start_vertex,
-            end_vertex
-        };
+        auto dir = point - origin;
+        auto is_left = strictly_less(point.x, origin.x);
+        auto is_vertical = approx_equal(point.x, origin.x);
+
+        // pseudo-angle: [0, 2] in the right half plane, (2, 4) in the left
+        double dx = is_vertical ? 0 : dir.x;
+        double dy = dir.y;
+        auto sum = std::abs(dx) + std::abs(dy);
+        auto ratio = sum > 0 ? dy / sum : 1; // the origin goes with the +y axis
+        auto angle = static_cast<float>(is_left ? 3 + ratio : 1 - ratio);
+        auto distance = static_cast<float>(length_squared(dir));
+
+        // both values are non-negative so their bit patterns are ordered
+        // the same way as the values
+        std::uint32_t angle_bits, distance_bits;
+        std::memcpy(&angle_bits, &angle, sizeof(angle_bits));
+        std::memcpy(&distance_bits, &distance, sizeof(distance_bits));
+        if (is_vertical)
+            distance_bits = ~distance_bits;
+        return (static_cast<std::uint64_t>(angle_bits) << 32) | distance_bits;
+    }
+
+    /** Extract the pseudo-angle from a key computed by angle_key().
+     * @param key sort key of a point
+     * @return pseudo-angle of the point in [0, 4)
+     */
+    inline float key_angle(std::uint64_t key)
+    {
+        auto bits = static_cast<std::uint32_t>(key >> 32);
+        float angle;
+        std::memcpy(&angle, &bits, sizeof(angle));
+        return angle;
+    }
 
-        event_type type;
-        line_segment<Vector> segment;
+    /** Adjust the key of an end vertex so that it goes after the start
+     * vertex of the same line segment. If the endpoints have the same 
+     * pseudo-angle in float precision, the keys are ordered by distance and
+     * a nearer end vertex would be processed first: the sweep would remove
+     * the line segment before it is inserted and it would stay in the state.
+     * @param start_key angle_key() of the start vertex
+     * @param end_key angle_key() of the end vertex
+     * @return key of the end vertex event
+     */
+    inline std::uint64_t end_event_key(std::uint64_t start_key, std::uint64_t end_key)
+    {
+        if ((start_key >> 32) == (end_key >> 32) && end_key <= start_key)
+            return start_key + 1;
+        return end_key;
+    }
 
-        visibility_event() {}
-        visibility_event(event_type type, const line_segment<Vector>& segment) :
-            type(type), 
-            segment(segment) {}
+    /* Line segment prepared for comparisons by distance from a fixed origin.
+     * Endpoints are relative to the origin and they are stored in double 
+     * precision. The start vertex `a` is before the end vertex `b` in the 
+     * clockwise order around the origin. Endpoints which are approximately 
+     * equal are welded: they have the same vertex id and the same 
+     * coordinates.
+     */
+    struct prepared_segment
+    {
+        // start and end vertex relative to the origin
+        vector2<double> a, b;
+        
+        // direction of the line segment (b - a)
+        vector2<double> dir;
+
+        // ids of the welded start and end vertex
+        std::uint32_t start, end;
 
-        const auto& point() const { return segment.a; }
+        /** Determine side of the supporting line of this line segment.
+         * The value is exactly 0 for both endpoints of this line segment.
+         * @param point relative to the origin
+         * @return positive value if the point is on the same side as the 
+         *         origin, negative value if it is on the other side and 0 if
+         *         it is on the line
+         */
+        double side(vector2<double> point) const
+        {
+            return cross(point - a, dir);
+        }
     };
 
-    /** Calculate visibility polygon vertices in clockwise order.
-     * Endpoints of the line segments (obstacles) can be ordered arbitrarily.
-     * Line segments collinear with the point are ignored.
-     * @param point - position of the observer
-     * @param begin iterator of the list of line segments (obstacles)
-     * @param end iterator of the list of line segments (obstacles)
-     * @return vector of vertices of the visibility polygon
+    /** Convert a point to a position relative to an origin in double precision.
+     * @param origin 
+     * @param point 
+     * @return point - origin
      */
-    template<typename Vector, typename InputIterator>
-    std::vector<Vector> visibility_polygon(
+    template<typename Vector>
+    vector2<double> relative_position(Vector origin, Vector point)
+    {
+        return vector2<double>{ 
+            static_cast<double>(point.x) - static_cast<double>(origin.x),
+            static_cast<double>(point.y) - static_cast<double>(origin.y) };
+    }
+
+    /** Intersect a ray from the origin with the supporting line of a 
+     * prepared line segment. The intersection is computed in double 
+     * precision: a ray through a vertex whose angle is almost equal to an 
+     * endpoint of the line segment would miss it due to rounding in float.
+     * @param origin origin of the ray
+     * @param point other point on the ray
+     * @param segment line segment prepared for the origin
+     * @return intersection point (the start vertex of the line segment if 
+     *         the ray is parallel to it)
+     */
+    template<typename Vector>
+    Vector ray_intersection(
+        Vector origin, 
         Vector point, 
-        InputIterator begin,
-        InputIterator end)
+        const prepared_segment& segment)
     {
-        using segment_type = line_segment<Vector>;
-        using event_type = visibility_event<Vector>;
-        using segment_comparer_type = line_segment_dist_comparer<Vector>;
+        auto dir = relative_position(origin, point);
+        auto denominator = cross(dir, segment.dir);
+        auto offset = denominator == 0 ? 
+            segment.a : 
+            dir * (cross(segment.a, segment.dir) / denominator);
+        return Vector{
+            static_cast<decltype(origin.x)>(origin.x + offset.x),
+            static_cast<decltype(origin.y)>(origin.y + offset.y) };
+    }
 
-        segment_comparer_type cmp_dist{ point };
-        std::set<segment_type, segment_comparer_type> state{ cmp_dist };
-        std::vector<event_type> events;
+    /* Compare prepared line segments given by their indices based on their 
+     * distance from the origin. It has the same assumptions and it gives 
+     * the same results as line_segment_dist_comparer except for degenerate 
+     * inputs (overlapping line segments) but common endpoints are compared
+     * by vertex ids and there are no approximate comparisons.
+     */
+    struct prepared_segment_comparer
+    {
+        const prepared_segment* segments;
 
-        for (; begin != end; ++begin)
+        explicit prepared_segment_comparer(const prepared_segment* segments) : 
+            segments(segments)
+        {
+        }
+
+        /** Check whether the line segment x is closer to the origin than the
+         * line segment y.
+         * @param x index of a line segment
+         * @param y index of a line segment
+         * @return true iff x < y (x is closer than y)
+         */
+        bool operator()(std::uint32_t x, std::uint32_t y) const
+        {
+            auto&& s = segments[x];
+            auto&& t = segments[y];
+
+            // cases with common endpoints
+            if (s.start == t.start)
+                return t.side(s.b) > 0;
+            if (s.end == t.end)
+                return t.side(s.a) > 0;
+            if (s.start == t.end || s.end == t.start)
+                return false;
+
+            // if s is on one side of t, it is closer iff it is on the side
+            // of the origin. Otherwise, t is on one side of s.
+            auto sa = t.side(s.a);
+            auto sb = t.side(s.b);
+            if (sa * sb >= 0)
+                return sa + sb > 0;
+            return s.side(t.a) + s.side(t.b) < 0;
+        }
+    };
+
+    /** Create a reference to an endpoint of a line segment.
+     * @param segment index of a line segment
+     * @param is_end_vertex true iff the endpoint is the end vertex
+     * @return endpoint reference (index of the line segment shifted by 1 bit
+     *         with the lowest bit set for end vertices)
+     */
+    inline std::uint32_t make_event_ref(std::size_t segment, bool is_end_vertex)
+    {
+        return static_cast<std::uint32_t>(segment << 1) | 
+            static_cast<std::uint32_t>(is_end_vertex);
+    }
+
+    // index of the line segment of an endpoint reference
+    inline std::uint32_t event_segment(std::uint32_t ref) { return ref >> 1; }
+
+    // check whether an endpoint reference is an end vertex
+    inline bool is_end_vertex(std::uint32_t ref) { return (ref & 1) != 0; }
+
+    /* Endpoints of line segments used as events of the sweep line algorithm.
+     * Events are stored as a structure of arrays: keys[i] is angle_key() of 
+     * the endpoint refs[i] (see make_event_ref()). Line segments are stored
+     * in a separate array with their start vertex in the `a` field.
+     */
+    struct visibility_events
+    {
+        std::vector<std::uint64_t> keys;
+        std::vector<std::uint32_t> refs;
+
+        std::size_t size() const { return refs.size(); }
+
+        void clear()
+        {
+            keys.clear();
+            refs.clear();
+        }
+
+        void reserve(std::size_t count)
         {
-            auto segment = *begin;
+            keys.reserve(count);
+            refs.reserve(count);
+        }
 
-            // Sort line segment endpoints and add them as events
-            // Skip line segments collinear with the point
-            auto pab = compute_orientation(point, segment.a, segment.b);
-            if (pab == orientation::collinear)
+        void push_back(std::uint64_t key, std::uint32_t ref)
+        {
+            keys.push_back(key);
+            refs.push_back(ref);
+        }
+
+        void swap(std::size_t i, std::size_t j)
+        {
+            std::swap(keys[i], keys[j]);
+            std::swap(refs[i], refs[j]);
+        }
+    };
+
+    /** Sort events in range [first, last) by keys using std::sort.
+     * Events are sorted indirectly (an array of indices is sorted) and
+     * then both arrays are permuted.
+     * @param events to sort
+     * @param buffer temporary storage of at least events.size() elements
+     * @param first index of the first event
+     * @param last index of the event after the last event
+     */
+    inline void sort_event_range(
+        visibility_events& events,
+        visibility_events& buffer,
+        std::size_t first,
+        std::size_t last)
+    {
+        auto&& keys = events.keys;
+        auto order = buffer.refs.begin() + first;
+        for (auto i = first; i < last; ++i)
+            buffer.refs[i] = static_cast<std::uint32_t>(i);
+        std::sort(order, order + (last - first), [&keys](auto a, auto b)
+        {
+            return keys[a] < keys[b];
+        });
+
+        for (auto i = first; i < last; ++i)
+        {
+            buffer.keys[i] = keys[buffer.refs[i]];
+            buffer.refs[i] = events.refs[buffer.refs[i]];
+        }
+        std::copy(buffer.keys.begin() + first, buffer.keys.begin() + last, 
+            keys.begin() + first);
+        std::copy(buffer.refs.begin() + first, buffer.refs.begin() + last, 
+            events.refs.begin() + first);
+    }
+
+    // algorithm used to sort events by angle
+    enum class event_sort
+    {
+        // choose the algorithm based on the number of events
+        automatic,
+        // std::sort by angle keys
+        comparison,
+        // LSD radix sort of angle keys
+        radix
+    };
+
+    /** Sort events by their angle keys.
+     * @param events to sort
+     * @param buffer temporary storage
+     * @param use_radix_sort if true, LSD radix sort is used. Otherwise, 
+     *        std::sort is used.
+     */
+    inline void sort_events(
+        visibility_events& events,
+        visibility_events& buffer,
+        bool use_radix_sort)
+    {
+        buffer.keys.resize(events.size());
+        buffer.refs.resize(events.size());
+        if (!use_radix_sort)
+        {
+            sort_event_range(events, buffer, 0, events.size());
+            return;
+        }
+
+        // sort by angle and then sort runs of events with the same angle
+        // by distance (these are usually very short)
+        radix_sort(events.keys, events.refs, buffer.keys, buffer.refs, 32, 64);
+
+        auto&& keys = events.keys;
+        for (std::size_t first = 0; first < events.size();)
+        {
+            auto last = first + 1;
+            while (last < events.size() && (keys[last] >> 32) == (keys[first] >> 32))
+                ++last;
+
+            if (last - first > 16)
+            {
+                sort_event_range(events, buffer, first, last);
+            }
+            else
+            {
+                // insertion sort
+                for (auto i = first + 1; i < last; ++i)
+                {
+                    for (auto j = i; j > first && keys[j] < keys[j - 1]; --j)
+                        events.swap(j, j - 1);
+                }
+            }
+            first = last;
+        }
+    }
+
+    /** Compute a sort key of a line segment intersected by the vertical ray
+     * from the origin based on the distance of the intersection point.
+     * @param origin of the ray
+     * @param segment intersected by the ray 
+     * @return sort key
+     */
+    template<typename Vector>
+    std::uint64_t vertical_distance_key(Vector origin, const line_segment<Vector>& segment)
+    {
+        double ax = segment.a.x, ay = segment.a.y;
+        double bx = segment.b.x, by = segment.b.y;
+        auto y = ax == bx ? 
+            std::min(ay, by) : 
+            ay + (origin.x - ax) * (by - ay) / (bx - ax);
+
+        // bit patterns of non-negative doubles are ordered as the values
+        auto distance = std::max(y - origin.y, 0.0);
+        std::uint64_t key;
+        std::memcpy(&key, &distance, sizeof(key));
+        return key;
+    }
+
+    /** Sort line segments intersected by the vertical ray from the origin 
+     * by their distance from the origin. Line segments are sorted by keys 
+     * first (see vertical_distance_key()). The order is then fixed by 
+     * insertion sort with prepared_segment_comparer (this orders line 
+     * segments with a common endpoint on the ray and it fixes rounding 
+     * errors) which usually needs 1 comparison per line segment. Equivalent
+     * line segments are removed.
+     * @param segments prepared line segments
+     * @param state line segments: indices in the refs array with their keys
+     * @param buffer temporary storage
+     */
+    inline void sort_initial_state(
+        const prepared_segment* segments,
+        visibility_events& state,
+        visibility_events& buffer)
+    {
+        sort_events(state, buffer, false);
+
+        prepared_segment_comparer cmp{ segments };
+        auto&& refs = state.refs;
+        std::size_t count = 0;
+        for (auto ref : refs)
+        {
+            if (count == 0 || cmp(refs[count - 1], ref))
             {
+                refs[count++] = ref;
+                continue;
+            }
+            
+            // find position of the line segment and skip it if there is an
+            // equivalent line segment
+            auto position = count;
+            while (position > 0 && cmp(ref, refs[position - 1]))
+                --position;
+            if (position > 0 && !cmp(refs[position - 1], ref))
                 continue;
+            std::copy_backward(
+                refs.begin() + position, 
+                refs.begin() + count, 
+                refs.begin() + count + 1);
+            refs[position] = ref;
+            ++count;
+        }
+        refs.resize(count);
+        state.keys.resize(count);
+    }
+
+    /* Buffers used by the visibility polygon algorithm.
+     * The workspace can be reused by subsequent queries. Once its buffers are
+     * large enough, a query does not allocate any memory.
+     * The State template chooses a sweep line state container (see 
+     * sweep_state.hpp). By default, the container is chosen automatically 
+     * based on the number of line segments in the state.
+     */
+    template<
+        typename Vector, 
+        template<typename, typename> class State = adaptive_state>
+    struct visibility_workspace
+    {
+        using segment_type = line_segment<Vector>;
+        using segment_comparer_type = prepared_segment_comparer;
+        using state_type = State<std::uint32_t, segment_comparer_type>;
+
+        // minimal number of events for which the automatic event sort uses 
+        // radix sort (measured by the event sort benchmark)
+        static constexpr std::size_t radix_sort_threshold = 1536;
+
+        // line segments which are not collinear with the observer with 
+        // their start vertex in the `a` field
+        std::vector<segment_type> segments;
+
+        // line segments prepared for the distance comparer (same indices as
+        // in the segments array)
+        std::vector<prepared_segment> prepared;
+
+        // sorted endpoints of the line segments
+        visibility_events events;
+
+        // temporary storage for sorting
+        visibility_events event_buffer;
+
+        // algorithm used to sort events
+        event_sort sort = event_sort::automatic;
+
+        // vertices of the last computed visibility polygon
+        std::vector<Vector> vertices;
+
+        // line segments intersected by the vertical ray from the observer
+        // (indices in refs, see sort_initial_state())
+        visibility_events initial_state;
+
+        // indices of line segments intersected by the sweep line
+        state_type state{ segment_comparer_type{ nullptr } };
+
+        // remove obstacles of the last query
+        void clear()
+        {
+            segments.clear();
+            events.clear();
+        }
+
+        /** Preallocate buffers for a query with given number of obstacles.
+         * @param segment_count number of line segments (obstacles)
+         */
+        void reserve(std::size_t segment_count)
+        {
+            segments.reserve(segment_count);
+            prepared.reserve(segment_count);
+            events.reserve(2 * segment_count);
+            event_buffer.reserve(2 * segment_count);
+            vertices.reserve(2 * segment_count);
+        }
+    };
+
+    /* Remove collinear vertices from a stream of polygon vertices.
+     * A vertex is removed if it is collinear with the previous vertex which 
+     * has not been removed and the next vertex. The previous vertex of the 
+     * first vertex is the closing point: any point other than the first 
+     * vertex on the line of the edge between the last and the first vertex 
+     * (the first vertex is never removed if there is no closing point). 
+     * Vertices are passed to the sink with a delay of 1 vertex.
+     */
+    template<typename Vector, typename Sink>
+    class collinear_filter
+    {
+    public:
+        collinear_filter(Sink& sink) : sink_(sink) {}
+
+        /** Set the closing point of the polygon.
+         * @param point on the line of the edge between the last and the first
+         *        vertex
+         */
+        void set_closing_point(Vector point)
+        {
+            closing_point_ = point;
+            has_closing_point_ = true;
+        }
+
+        // add the next vertex of the polygon
+        void push(Vector vertex)
+        {
+            if (count_ == 0)
+                first_ = vertex;
+            else
+                process(vertex);
+            pending_ = vertex;
+            ++count_;
+        }
+
+        // process the last vertex
+        void finish()
+        {
+            if (count_ > 0)
+                process(first_);
+        }
+
+    private:
+        Sink& sink_;
+        Vector closing_point_, first_, pending_, last_kept_;
+        bool has_closing_point_ = false;
+        bool has_kept_ = false;
+        std::size_t count_ = 0;
+
+        // decide whether to keep the pending vertex
+        void process(Vector next)
+        {
+            Vector prev;
+            if (has_kept_)
+            {
+                prev = last_kept_;
             }
-            else if (pab == orientation::right_turn)
+            else if (has_closing_point_ && 
+                !approx_equal(closing_point_, pending_))
             {
-                events.emplace_back(event_type::start_vertex, segment);
-                events.emplace_back(
-                    event_type::end_vertex, 
-                    segment_type{ segment.b, segment.a });
+                prev = closing_point_;
             }
             else
             {
-                events.emplace_back(
-                    event_type::start_vertex, 
-                    segment_type{ segment.b, segment.a });
-                events.emplace_back(event_type::end_vertex, segment);
+                keep();
+                return;
             }
 
-            // Initialize state by adding line segments that are intersected
-            // by vertical ray from the point
-            auto a = segment.a, b = segment.b;
-            if (a.x > b.x) 
-                std::swap(a, b);
+            if (compute_orientation(prev, pending_, next) != orientation::collinear)
+                keep();
+        }
 
-            auto abp = compute_orientation(a, b, point);
-            if (abp == orientation::right_turn && 
-                (approx_equal(b.x, point.x) ||
-                (a.x < point.x && point.x < b.x)))
+        void keep()
+        {
+            sink_(pending_);
+            last_kept_ = pending_;
+            has_kept_ = true;
+        }
+    };
+
+    /** Add a line segment to obstacles of a query.
+     * @param point position of the observer
+     * @param segment line segment (obstacle)
+     * @param turn orientation of point, segment.a and segment.b (line 
+     *        segments collinear with the point are skipped)
+     * @param workspace buffers of the query
+     */
+    template<
+        typename Vector, 
+        template<typename, typename> class State>
+    void add_obstacle(
+        Vector point,
+        line_segment<Vector> segment,
+        orientation turn,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        // Sort line segment endpoints and add them as events
+        if (turn == orientation::collinear)
+            return;
+        if (turn == orientation::left_turn)
+            std::swap(segment.a, segment.b);
+
+        auto start_key = angle_key(point, segment.a);
+        auto end_key = end_event_key(start_key, angle_key(point, segment.b));
+
+        auto index = workspace.segments.size();
+        workspace.segments.push_back(segment);
+        workspace.events.push_back(start_key, make_event_ref(index, false));
+        workspace.events.push_back(end_key, make_event_ref(index, true));
+    }
+
+    /** Sort events of obstacles added to the workspace by add_obstacle()
+     * using the algorithm chosen in the workspace.
+     * @param workspace buffers of the query with obstacles
+     */
+    template<
+        typename Vector, 
+        template<typename, typename> class State>
+    void sort_obstacles(visibility_workspace<Vector, State>& workspace)
+    {
+        auto& events = workspace.events;
+        auto use_radix_sort = workspace.sort == event_sort::radix ||
+            (workspace.sort == event_sort::automatic && 
+             events.size() >= workspace.radix_sort_threshold);
+        sort_events(events, workspace.event_buffer, use_radix_sort);
+    }
+
+    // line segment index which denotes no line segment
+    constexpr std::uint32_t no_segment = ~static_cast<std::uint32_t>(0);
+
+    /** Weld equal event points of sorted events (see sort_obstacles()) and
+     * prepare line segments for the distance comparer.
+     * @param point position of the observer
+     * @param workspace buffers of the query with sorted events
+     */
+    template<
+        typename Vector, 
+        template<typename, typename> class State>
+    void prepare_segments(
+        Vector point,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        auto& segments = workspace.segments;
+        auto& events = workspace.events;
+
+        auto event_point = [&segments](std::uint32_t ref) 
+        {
+            auto&& segment = segments[event_segment(ref)];
+            return is_end_vertex(ref) ? segment.b : segment.a;
+        };
+
+        // weld equal points and sort end vertices first if the points are 
+        // equal
+        auto& prepared = workspace.prepared;
+        prepared.resize(segments.size());
+        std::uint32_t vertex_id = 0;
+        for (std::size_t first = 0; first < events.size(); ++vertex_id)
+        {
+            auto first_point = event_point(events.refs[first]);
+            auto position = relative_position(point, first_point);
+            auto last = first;
+            do
+            {
+                auto ref = events.refs[last];
+                auto& segment = prepared[event_segment(ref)];
+                if (is_end_vertex(ref))
+                {
+                    segment.b = position;
+                    segment.end = vertex_id;
+                }
+                else
+                {
+                    segment.a = position;
+                    segment.start = vertex_id;
+                }
+                ++last;
+            } while (last < events.size() && 
+                approx_equal(event_point(events.refs[last]), first_point));
+
+            for (auto i = first, j = last; i < j;)
             {
-                state.insert(segment);
+                if (is_end_vertex(events.refs[i]))
+                    ++i;
+                else
+                    events.swap(i, --j);
             }
+            first = last;
         }
 
-        // sort events by angle
-        angle_comparer<Vector> cmp_angle{ point };
-        std::sort(events.begin(), events.end(), [&cmp_angle](auto&& a, auto&& b) 
+        for (auto&& segment : prepared)
+            segment.dir = segment.b - segment.a;
+    }
+
+    /** Prepare the sweep of sorted events (see sort_obstacles()): weld 
+     * equal event points, prepare line segments for the distance comparer
+     * and build the initial sweep line state.
+     * @param point position of the observer
+     * @param workspace buffers of the query with sorted events
+     */
+    template<
+        typename Vector, 
+        template<typename, typename> class State>
+    void prepare_sweep(
+        Vector point,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        prepare_segments(point, workspace);
+        auto& segments = workspace.segments;
+        auto& prepared = workspace.prepared;
+
+        // Initialize state with line segments that are intersected by 
+        // vertical ray from the point. They are sorted at once and the 
+        // state is built from the sorted sequence.
+        // Start vertex of these line segments is on the left (the sweep 
+        // goes clockwise) and the end vertex is on the right or on the ray.
+        prepared_segment_comparer cmp_dist{ prepared.data() };
+        auto& initial_state = workspace.initial_state;
+        initial_state.clear();
+        for (std::size_t i = 0; i < segments.size(); ++i)
         {
-            // if the points are equal, sort end vertices first
-            if (approx_equal(a.point(), b.point()))
-                return a.type == event_type::end_vertex && 
-                       b.type == event_type::start_vertex;
-            return cmp_angle(a.point(), b.point());
-        });
+            auto a = segments[i].a, b = segments[i].b;
+            if (a.x < point.x && 
+                (point.x < b.x || approx_equal(b.x, point.x)))
+            {
+                initial_state.push_back(
+                    vertical_distance_key(point, segments[i]), 
+                    static_cast<std::uint32_t>(i));
+            }
+        }
+        sort_initial_state(prepared.data(), initial_state, workspace.event_buffer);
 
-        // find the visibility polygon
-        std::vector<Vector> vertices;
-        for (auto&& event : events)
+        auto& state = workspace.state;
+        state.reset(cmp_dist);
+        state.assign_sorted(initial_state.refs.begin(), initial_state.refs.end());
+    }
+
+    /** Run the sweep prepared by prepare_sweep() and pass vertices of the
+     * visibility polygon in clockwise order to a function
+     * emit(vertex, ref, segment). If segment is no_segment, vertex is the 
+     * endpoint given by ref (see make_event_ref()). Otherwise, vertex is 
+     * the intersection of the ray from the observer through that endpoint
+     * with the line segment (indices are in the workspace). Collinear 
+     * vertices are not removed.
+     * @param point position of the observer
+     * @param workspace buffers of the query with a prepared sweep
+     * @param emit function called with each vertex of the polygon
+     */
+    template<
+        typename Vector, 
+        template<typename, typename> class State,
+        typename Emit>
+    void run_sweep(
+        Vector point,
+        visibility_workspace<Vector, State>& workspace,
+        Emit&& emit)
+    {
+        auto& segments = workspace.segments;
+        auto& events = workspace.events;
+        auto& state = workspace.state;
+        prepared_segment_comparer cmp_dist{ workspace.prepared.data() };
+
+        auto event_point = [&segments](std::uint32_t ref) 
         {
-            if (event.type == event_type::end_vertex) 
-                state.erase(event.segment);
+            auto&& segment = segments[event_segment(ref)];
+            return is_end_vertex(ref) ? segment.b : segment.a;
+        };
+
+        for (auto ref : events.refs)
+        {
+            auto index = event_segment(ref);
+            auto is_end = is_end_vertex(ref);
+            auto current_point = event_point(ref);
+
+            if (is_end) 
+                state.erase_id(index);
 
             if (state.empty())
             {
-                vertices.push_back(event.point());
+                emit(current_point, ref, no_segment);
             }
-            else if (cmp_dist(event.segment, *state.begin()))
+            else if (cmp_dist(index, state.front()))
             {
                 // Nearest line segment has changed
-                // Compute the intersection point with this segment
-                vec2 intersection;
-                ray<Vector> ray{ point, event.point() - point };
-                auto nearest_segment = *state.begin();
-                auto intersects = ray.intersects(nearest_segment, intersection);
-                assert(intersects && 
-                    "Ray intersects line segment L iff L is in the state");
-
-                if (event.type == event_type::start_vertex)
+                // Compute the intersection point with this segment (it is 
+                // in the state so the ray hits it)
+                auto intersection = ray_intersection(
+                    point, current_point, workspace.prepared[state.front()]);
+
+                if (!is_end)
                 {
-                    vertices.push_back(intersection);
-                    vertices.push_back(event.point());
+                    emit(intersection, ref, state.front());
+                    emit(current_point, ref, no_segment);
                 }
                 else
                 {
-                    vertices.push_back(event.point());
-                    vertices.push_back(intersection);
+                    emit(current_point, ref, no_segment);
+                    emit(intersection, ref, state.front());
                 }
             }
 
-            if (event.type == event_type::start_vertex) 
-                state.insert(event.segment);
+            if (!is_end) 
+                state.insert(index);
         }
+    }
+
+    /** Calculate visibility polygon of obstacles whose events are sorted 
+     * (see sort_obstacles()) and pass its vertices in clockwise order to 
+     * a sink.
+     * @param point position of the observer
+     * @param workspace buffers of the query with sorted events
+     * @param sink function which is called with each vertex of the 
+     *        visibility polygon
+     */
+    template<
+        typename Vector, 
+        template<typename, typename> class State,
+        typename Sink>
+    void sweep_sorted_obstacles(
+        Vector point,
+        visibility_workspace<Vector, State>& workspace,
+        Sink& sink)
+    {
+        prepare_sweep(point, workspace);
+
+        collinear_filter<Vector, Sink> vertices{ sink };
+        auto& state = workspace.state;
+        if (!state.empty())
+        {
+            // the last edge of the polygon lies on the nearest line segment
+            // which intersects the vertical ray, use its endpoint on the left
+            auto&& nearest_segment = workspace.segments[state.front()];
+            vertices.set_closing_point(
+                nearest_segment.a.x < nearest_segment.b.x ? 
+                nearest_segment.a : nearest_segment.b);
+        }
+
+        run_sweep(point, workspace, [&vertices](
+            const Vector& vertex, 
+            std::uint32_t, 
+            std::uint32_t) 
+        { 
+            vertices.push(vertex); 
+        });
+        vertices.finish();
+    }
+
+    /** Calculate visibility polygon of obstacles added to the workspace by
+     * add_obstacle() and pass its vertices in clockwise order to a sink.
+     * @param point position of the observer
+     * @param workspace buffers of the query with obstacles
+     * @param sink function which is called with each vertex of the 
+     *        visibility polygon
+     */
+    template<
+        typename Vector, 
+        template<typename, typename> class State,
+        typename Sink>
+    void sweep_obstacles(
+        Vector point,
+        visibility_workspace<Vector, State>& workspace,
+        Sink& sink)
+    {
+        sort_obstacles(workspace);
+        sweep_sorted_obstacles(point, workspace, sink);
+    }
 
-        // remove collinear points
-        auto top = vertices.begin();
-        for (auto it = vertices.begin(); it != vertices.end(); ++it)
+    /** Calculate visibility polygon vertices in clockwise order and pass
+     * them to a sink function one by one as they are found. Collinear 
+     * vertices are removed on the fly.
+     * Endpoints of the line segments (obstacles) can be ordered arbitrarily.
+     * Line segments collinear with the point are ignored.
+     * Buffers of the workspace are reused so that the function does not 
+     * allocate memory once the workspace is large enough.
+     * @param point - position of the observer
+     * @param begin iterator of the list of line segments (obstacles)
+     * @param end iterator of the list of line segments (obstacles)
+     * @param workspace buffers used by the algorithm
+     * @param sink function which is called with each vertex of the 
+     *        visibility polygon
+     */
+    template<
+        typename Vector, 
+        typename InputIterator, 
+        template<typename, typename> class State,
+        typename Sink>
+    void visit_visibility_polygon(
+        Vector point, 
+        InputIterator begin,
+        InputIterator end,
+        visibility_workspace<Vector, State>& workspace,
+        Sink sink)
+    {
+        workspace.clear();
+        for (; begin != end; ++begin)
         {
-            auto prev = top == vertices.begin() ? vertices.end() - 1 : top - 1;
-            auto next = it + 1 == vertices.end() ? vertices.begin() : it + 1;
-            if (compute_orientation(*prev, *it, *next) != orientation::collinear) 
-                *top++ = *it;
+            line_segment<Vector> segment = *begin;
+            add_obstacle(
+                point, 
+                segment, 
+                compute_orientation(point, segment.a, segment.b), 
+                workspace);
         }
-        vertices.erase(top, vertices.end());
+        sweep_obstacles(point, workspace, sink);
+    }
+
+    /** Calculate visibility polygon vertices in clockwise order and write
+     * them to an output iterator.
+     * Endpoints of the line segments (obstacles) can be ordered arbitrarily.
+     * Line segments collinear with the point are ignored.
+     * @param point - position of the observer
+     * @param begin iterator of the list of line segments (obstacles)
+     * @param end iterator of the list of line segments (obstacles)
+     * @param workspace buffers used by the algorithm
+     * @param out output iterator where the vertices are written
+     * @return output iterator past the last written vertex
+     */
+    template<
+        typename Vector, 
+        typename InputIterator, 
+        template<typename, typename> class State,
+        typename OutputIterator>
+    OutputIterator visibility_polygon(
+        Vector point, 
+        InputIterator begin,
+        InputIterator end,
+        visibility_workspace<Vector, State>& workspace,
+        OutputIterator out)
+    {
+        visit_visibility_polygon(point, begin, end, workspace, 
+            [&out](const Vector& vertex) { *out++ = vertex; });
+        return out;
+    }
+
+    /** Calculate visibility polygon vertices in clockwise order.
+     * Endpoints of the line segments (obstacles) can be ordered arbitrarily.
+     * Line segments collinear with the point are ignored.
+     * Buffers of the workspace are reused so that the function does not 
+     * allocate memory once the workspace is large enough.
+     * @param point - position of the observer
+     * @param begin iterator of the list of line segments (obstacles)
+     * @param end iterator of the list of line segments (obstacles)
+     * @param workspace buffers used by the algorithm
+     * @return vertices of the visibility polygon (reference to a buffer in
+     *         the workspace which is valid until the next query)
+     */
+    template<
+        typename Vector, 
+        typename InputIterator, 
+        template<typename, typename> class State>
+    const std::vector<Vector>& visibility_polygon(
+        Vector point, 
+        InputIterator begin,
+        InputIterator end,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        auto& vertices = workspace.vertices;
+        vertices.clear();
+        visibility_polygon(point, begin, end, workspace, 
+            std::back_inserter(vertices));
         return vertices;
     }
+
+    /** Calculate visibility polygon vertices in clockwise order.
+     * Endpoints of the line segments (obstacles) can be ordered arbitrarily.
+     * Line segments collinear with the point are ignored.
+     * @param point - position of the observer
+     * @param begin iterator of the list of line segments (obstacles)
+     * @param end iterator of the list of line segments (obstacles)
+     * @return vector of vertices of the visibility polygon
+     */
+    template<typename Vector, typename InputIterator>
+    std::vector<Vector> visibility_polygon(
+        Vector point, 
+        InputIterator begin,
+        InputIterator end)
+    {
+        visibility_workspace<Vector> workspace;
+        visibility_polygon(point, begin, end, workspace);
+        return std::move(workspace.vertices);
+    }
 }
 
 #endif // GEOMETRY_VISIBILITY_HPP_
\ No newline at end of file
@@ -0,0 +1,180 @@
+#ifndef GEOMETRY_VISIBLE_POINTS_HPP_
+#define GEOMETRY_VISIBLE_POINTS_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "scene.hpp"
+
+namespace geometry
+{
+    /* Buffers used by the visible points query.
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State = adaptive_state>
+    struct points_workspace
+    {
+        // buffers of the sweep
+        visibility_workspace<Vector, State> query;
+
+        // target points sorted by their angle keys
+        visibility_events targets;
+    };
+
+    /** Run a sweep of prepared obstacles (see prepare_sweep()) and decide
+     * visibility of target points on the way. Targets are sorted by their
+     * angle keys and merged with the events. Each target is tested against
+     * the nearest line segment in the sweep line state before and after the
+     * sweep passes its angle: it is hidden only if it is behind the nearest
+     * line segment in both cases, i.e., a line segment crosses the line of
+     * sight. A line of sight which touches an obstacle at its endpoint or
+     * ends on it is not blocked. Sides are decided in double precision 
+     * without the tolerance of line_of_sight(), so a line of sight which 
+     * passes just past an endpoint of a line segment on its far side is 
+     * blocked.
+     * @param point position of the observer
+     * @param workspace buffers of the query with prepared obstacles
+     * @param targets angle_key() and an id of each target (ids are
+     *        overwritten by the algorithm, ~0 is reserved)
+     * @param target_point function which returns position of a target with
+     *        given id
+     * @param visit function called with the id of each visible target
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State,
+        typename TargetPoint,
+        typename Visit>
+    void sweep_targets(
+        Vector point,
+        visibility_workspace<Vector, State>& workspace,
+        visibility_events& targets,
+        TargetPoint&& target_point,
+        Visit&& visit)
+    {
+        const auto visited = ~static_cast<std::uint32_t>(0);
+        sort_events(targets, workspace.event_buffer,
+            targets.size() >= workspace.radix_sort_threshold);
+
+        // a line segment which is the nearest one at the angle of a target
+        // only touches the line of sight if the target is on its line
+        auto& state = workspace.state;
+        auto&& prepared = workspace.prepared;
+        auto is_visible = [&](std::uint32_t target)
+        {
+            return state.empty() ||
+                prepared[state.front()].side(relative_position(point, target_point(target))) >= 0;
+        };
+
+        // test targets with angles less than `angle` with the current state
+        auto visit_targets = [&](std::size_t& next, std::uint64_t angle)
+        {
+            for (; next < targets.size() && (targets.keys[next] >> 32) < angle; ++next)
+            {
+                auto& target = targets.refs[next];
+                if (target != visited && is_visible(target))
+                {
+                    visit(target);
+                    target = visited;
+                }
+            }
+        };
+
+        auto&& events = workspace.events;
+        std::size_t next_before = 0, next_after = 0;
+        for (std::size_t i = 0; i < events.size(); ++i)
+        {
+            auto angle = events.keys[i] >> 32;
+            visit_targets(next_after, angle);
+            visit_targets(next_before, angle + 1);
+
+            auto ref = events.refs[i];
+            auto index = event_segment(ref);
+            if (is_end_vertex(ref))
+                state.erase_id(index);
+            else
+                state.insert(index);
+        }
+        visit_targets(next_before, std::uint64_t{ 1 } << 32);
+        visit_targets(next_after, std::uint64_t{ 1 } << 32);
+    }
+
+    /** Decide which target points are visible from an observer in one
+     * rotational sweep. Targets are extra events of the same sweep which
+     * computes the visibility polygon (see sweep_targets()), so the cost is
+     * O((n + m) log(n + m)) for n line segments and m targets instead of a
+     * visibility polygon and m point in polygon tests. Results are appended
+     * to the output in the order of the targets (1 iff the target is
+     * visible).
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param first random access iterator of the list of target positions
+     * @param last random access iterator of the list of target positions
+     * @param workspace buffers used by the algorithm
+     * @param output results
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State,
+        typename RandomAccessIterator>
+    void visible_points(
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        RandomAccessIterator first,
+        RandomAccessIterator last,
+        points_workspace<Vector, State>& workspace,
+        std::vector<std::uint8_t>& output)
+    {
+        auto&& segments = scene.segments();
+        auto&& lines = scene.lines();
+        auto& query = workspace.query;
+        auto& targets = workspace.targets;
+        query.clear();
+        targets.clear();
+        for (std::size_t i = 0; i < segments.size(); ++i)
+            add_obstacle(point, segments[i], lines[i].side(point), query);
+
+        auto count = static_cast<std::uint32_t>(last - first);
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            Vector target = first[i];
+            targets.push_back(angle_key(point, target), i);
+        }
+
+        sort_obstacles(query);
+        prepare_sweep(point, query);
+
+        auto base = output.size();
+        output.resize(base + count, 0);
+        sweep_targets(point, query, targets,
+            [&](std::uint32_t target) -> Vector { return first[target]; },
+            [&](std::uint32_t target) { output[base + target] = 1; });
+    }
+
+    /** Decide which target points are visible from an observer.
+     * @param scene obstacles
+     * @param point position of the observer
+     * @param first random access iterator of the list of target positions
+     * @param last random access iterator of the list of target positions
+     * @return 1 for each visible target and 0 for each hidden target
+     */
+    template<typename Vector, typename RandomAccessIterator>
+    std::vector<std::uint8_t> visible_points(
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        RandomAccessIterator first,
+        RandomAccessIterator last)
+    {
+        points_workspace<Vector> workspace;
+        std::vector<std::uint8_t> output;
+        visible_points(scene, point, first, last, workspace, output);
+        return output;
+    }
+}
+
+#endif // GEOMETRY_VISIBLE_POINTS_HPP_
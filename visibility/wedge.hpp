@@ -0,0 +1,327 @@
+#ifndef GEOMETRY_WEDGE_HPP_
+#define GEOMETRY_WEDGE_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include "vector2.hpp"
+#include "primitives.hpp"
+#include "visibility.hpp"
+#include "scene.hpp"
+
+namespace geometry
+{
+    /* Field of view of an observer: an angular interval which goes
+     * clockwise from the start ray to the end ray. Angles are represented
+     * by pseudo-angles of angle_key().
+     */
+    struct view_wedge
+    {
+        // directions of the start and the end ray (unit vectors)
+        vector2<double> start_dir, end_dir;
+
+        // pseudo-angle of the start ray
+        float start;
+
+        // clockwise pseudo-angle from the start ray to the end ray
+        float width;
+
+        /** Create a wedge symmetric around a direction.
+         * @param direction axis of the wedge
+         * @param half_angle angle between the axis and the boundary rays in
+         *        radians (less than pi)
+         */
+        template<typename Vector>
+        view_wedge(Vector direction, double half_angle)
+        {
+            auto axis = std::atan2(
+                static_cast<double>(direction.x),
+                static_cast<double>(direction.y));
+            start_dir = vector2<double>{
+                std::sin(axis - half_angle), std::cos(axis - half_angle) };
+            end_dir = vector2<double>{
+                std::sin(axis + half_angle), std::cos(axis + half_angle) };
+            start = pseudo_angle(start_dir);
+            width = offset(pseudo_angle(end_dir));
+        }
+
+        /** Compute clockwise pseudo-angle from the start ray.
+         * @param angle pseudo-angle of a direction
+         * @return pseudo-angle in [0, 4)
+         */
+        float offset(float angle) const
+        {
+            auto result = angle - start;
+            return result < 0 ? result + 4 : result;
+        }
+
+        /** Check whether a direction is in the wedge.
+         * @param angle pseudo-angle of the direction
+         * @return true iff the direction is between the start and the end
+         *         ray (inclusive)
+         */
+        bool contains(float angle) const
+        {
+            return offset(angle) <= width;
+        }
+
+        /** Check whether a line segment is outside of a convex wedge. The
+         * test is conservative: it only rejects line segments whose both
+         * endpoints are clearly on the outer side of one of the boundary
+         * rays.
+         * @param a endpoint relative to the apex of the wedge
+         * @param b endpoint relative to the apex of the wedge
+         * @return true if the line segment does not intersect the wedge
+         */
+        bool is_outside(vector2<double> a, vector2<double> b) const
+        {
+            auto margin = 1e-6 * (std::abs(a.x) + std::abs(a.y) +
+                std::abs(b.x) + std::abs(b.y));
+            auto is_before_start =
+                cross(start_dir, a) > margin && cross(start_dir, b) > margin;
+            auto is_after_end =
+                cross(end_dir, a) < -margin && cross(end_dir, b) < -margin;
+            return is_before_start || is_after_end;
+        }
+
+        /** Compute pseudo-angle of a direction (see angle_key()).
+         * @param dir direction vector
+         * @return pseudo-angle in [0, 4)
+         */
+        static float pseudo_angle(vector2<double> dir)
+        {
+            auto ratio = dir.y / (std::abs(dir.x) + std::abs(dir.y));
+            auto angle = static_cast<float>(dir.x < 0 ? 3 + ratio : 1 - ratio);
+            return angle < 4 ? angle : 0;
+        }
+    };
+
+    /** Compute a sort key of a line segment intersected by a ray from the
+     * origin based on the distance of the intersection point.
+     * @param origin of the ray
+     * @param dir direction of the ray
+     * @param segment intersected by the ray
+     * @return sort key
+     */
+    template<typename Vector>
+    std::uint64_t ray_distance_key(
+        Vector origin,
+        vector2<double> dir,
+        const line_segment<Vector>& segment)
+    {
+        auto a = relative_position(origin, segment.a);
+        auto segment_dir = relative_position(segment.a, segment.b);
+        auto denominator = cross(dir, segment_dir);
+        auto distance = denominator == 0 ?
+            std::sqrt(length_squared(a)) :
+            cross(a, segment_dir) / denominator;
+
+        // bit patterns of non-negative doubles are ordered as the values
+        distance = std::max(distance, 0.0);
+        std::uint64_t key;
+        std::memcpy(&key, &distance, sizeof(key));
+        return key;
+    }
+
+    /** Calculate visibility polygon of an observer with a limited field of
+     * view and pass its vertices in clockwise order to a sink function.
+     * The first vertex is the observer followed by the intersection of the
+     * start ray with the nearest line segment, the last vertex is the
+     * intersection of the end ray. Only line segments in grid cells which
+     * intersect the wedge are considered, only events in the wedge are
+     * swept and the initial state is built from line segments which cross
+     * the start ray.
+     * Collinear vertices are removed.
+     * @param scene obstacles (the wedge must be enclosed by obstacles)
+     * @param point position of the observer
+     * @param direction axis of the field of view
+     * @param half_angle angle between the axis and the boundary rays in
+     *        radians (the whole polygon is computed if it is at least pi)
+     * @param workspace buffers used by the algorithm
+     * @param sink function which is called with each vertex of the
+     *        visibility polygon
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State,
+        typename Sink>
+    void visit_visibility_wedge(
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        Vector direction,
+        double half_angle,
+        visibility_workspace<Vector, State>& workspace,
+        Sink sink)
+    {
+        visit_visibility_wedge(scene, scene.grid(), point, direction, half_angle,
+            workspace, sink);
+    }
+
+    /** Calculate visibility polygon of an observer with a limited field of
+     * view (see visit_visibility_wedge()) with line segments found by
+     * another spatial index of the scene.
+     * @param scene obstacles (the wedge must be enclosed by obstacles)
+     * @param spatial_index index of scene.segments() with a method
+     *        visit_wedge(apex, start_dir, end_dir, function) (e.g.,
+     *        segment_bvh)
+     * @param point position of the observer
+     * @param direction axis of the field of view
+     * @param half_angle angle between the axis and the boundary rays in
+     *        radians (the whole polygon is computed if it is at least pi)
+     * @param workspace buffers used by the algorithm
+     * @param sink function which is called with each vertex of the
+     *        visibility polygon
+     */
+    template<
+        typename Vector,
+        typename Index,
+        template<typename, typename> class State,
+        typename Sink>
+    void visit_visibility_wedge(
+        const visibility_scene<Vector>& scene,
+        const Index& spatial_index,
+        Vector point,
+        Vector direction,
+        double half_angle,
+        visibility_workspace<Vector, State>& workspace,
+        Sink sink)
+    {
+        const double pi = 3.14159265358979323846;
+        if (!(half_angle < pi))
+        {
+            visit_visibility_polygon(scene, point, workspace, sink);
+            return;
+        }
+
+        // add line segments in the wedge, those which cross the start ray
+        // form the initial state
+        view_wedge wedge{ direction, half_angle };
+        auto&& segments = scene.segments();
+        auto&& lines = scene.lines();
+        auto& events = workspace.events;
+        auto& initial_state = workspace.initial_state;
+        workspace.clear();
+        initial_state.clear();
+        auto is_convex = half_angle < pi / 2;
+        spatial_index.visit_wedge(point, wedge.start_dir, wedge.end_dir,
+            [&](std::uint32_t i)
+        {
+            auto turn = lines[i].side(point);
+            if (turn == orientation::collinear)
+                return;
+            auto segment = segments[i];
+            if (is_convex && wedge.is_outside(
+                relative_position(point, segment.a),
+                relative_position(point, segment.b)))
+            {
+                return;
+            }
+            if (turn == orientation::left_turn)
+                std::swap(segment.a, segment.b);
+
+            auto start_key = angle_key(point, segment.a);
+            auto end_key = end_event_key(start_key, angle_key(point, segment.b));
+            auto start_offset = wedge.offset(key_angle(start_key));
+            auto end_offset = wedge.offset(key_angle(end_key));
+            auto crosses_start = start_offset > end_offset;
+            if (!crosses_start && start_offset > wedge.width)
+                return;
+
+            auto index = workspace.segments.size();
+            workspace.segments.push_back(segment);
+            events.push_back(start_key, make_event_ref(index, false));
+            events.push_back(end_key, make_event_ref(index, true));
+            if (crosses_start)
+            {
+                initial_state.push_back(
+                    ray_distance_key(point, wedge.start_dir, segment),
+                    static_cast<std::uint32_t>(index));
+            }
+        });
+        sort_obstacles(workspace);
+        prepare_segments(point, workspace);
+
+        // keep events in the wedge starting at the start ray
+        auto& buffer = workspace.event_buffer;
+        buffer.clear();
+        auto split = std::lower_bound(events.keys.begin(), events.keys.end(),
+            static_cast<std::uint64_t>(0), [&wedge](std::uint64_t key, std::uint64_t)
+        {
+            return key_angle(key) < wedge.start;
+        }) - events.keys.begin();
+        for (std::size_t k = 0; k < events.size(); ++k)
+        {
+            auto i = (split + k) % events.size();
+            if (wedge.contains(key_angle(events.keys[i])))
+                buffer.push_back(events.keys[i], events.refs[i]);
+        }
+        std::swap(events, buffer);
+
+        auto&& prepared = workspace.prepared;
+        sort_initial_state(prepared.data(), initial_state, buffer);
+        auto& state = workspace.state;
+        state.reset(prepared_segment_comparer{ prepared.data() });
+        state.assign_sorted(initial_state.refs.begin(), initial_state.refs.end());
+
+        // intersection of a boundary ray with the nearest line segment
+        auto boundary_point = [&](vector2<double> dir)
+        {
+            auto&& segment = prepared[state.front()];
+            auto offset = dir * (cross(segment.a, segment.dir) / cross(dir, segment.dir));
+            return Vector{
+                static_cast<decltype(point.x)>(point.x + offset.x),
+                static_cast<decltype(point.y)>(point.y + offset.y) };
+        };
+
+        collinear_filter<Vector, Sink> vertices{ sink };
+        vertices.push(point);
+        if (!state.empty())
+            vertices.push(boundary_point(wedge.start_dir));
+        run_sweep(point, workspace, [&vertices](
+            const Vector& vertex,
+            std::uint32_t,
+            std::uint32_t)
+        {
+            vertices.push(vertex);
+        });
+        if (!state.empty())
+            vertices.push(boundary_point(wedge.end_dir));
+        vertices.finish();
+    }
+
+    /** Calculate visibility polygon of an observer with a limited field of
+     * view (see visit_visibility_wedge()).
+     * @param scene obstacles (the wedge must be enclosed by obstacles)
+     * @param point position of the observer
+     * @param direction axis of the field of view
+     * @param half_angle angle between the axis and the boundary rays in
+     *        radians (the whole polygon is computed if it is at least pi)
+     * @param workspace buffers used by the algorithm
+     * @return vertices of the polygon in clockwise order starting with the
+     *         observer (reference to a buffer in the workspace which is
+     *         valid until the next query)
+     */
+    template<
+        typename Vector,
+        template<typename, typename> class State>
+    const std::vector<Vector>& visibility_wedge(
+        const visibility_scene<Vector>& scene,
+        Vector point,
+        Vector direction,
+        double half_angle,
+        visibility_workspace<Vector, State>& workspace)
+    {
+        auto& vertices = workspace.vertices;
+        vertices.clear();
+        visit_visibility_wedge(scene, point, direction, half_angle, workspace,
+            [&vertices](const Vector& vertex) { vertices.push_back(vertex); });
+        return vertices;
+    }
+}
+
+#endif // GEOMETRY_WEDGE_HPP_